@@ -246,6 +246,31 @@
 
 #pragma mark -
 
+/**---------------------------------------------------------------------------------------
+ *  @name Receiving Notification when an Array Changes
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/**
+ Add a notification block which is called with the indices of the objects which
+ were inserted into, removed from and modified in this RLMArray each time a write
+ transaction which changes it is committed.
+
+ The block is only called when the contents of the array actually changed. It
+ is not called once the array is invalidated because the object owning it was
+ deleted.
+
+ Only RLMArray properties of persisted objects can be observed.
+
+ @param block   The block to call with the array and the changes made to it.
+
+ @return A token which must be held on to for as long as notifications are
+         wanted and then passed to `-[RLMRealm removeNotification:]`.
+ */
+- (RLMNotificationToken *)addNotificationBlock:(RLMCollectionNotificationBlock)block;
+
+#pragma mark -
+
 - (id)objectAtIndexedSubscript:(NSUInteger)index;
 - (void)setObject:(id)newValue atIndexedSubscript:(NSUInteger)index;
 
@@ -191,6 +191,11 @@ static void RLMValidateMatchingObjectType(RLMArray *array, RLMObject *object) {
     @throw RLMException(@"This method can only be called on RLMArray instances retrieved from an RLMRealm");
 }
 
+- (RLMNotificationToken *)addNotificationBlock:(RLMCollectionNotificationBlock)block
+{
+    @throw RLMException(@"This method can only be called on RLMArray instances retrieved from an RLMRealm");
+}
+
 #pragma GCC diagnostic pop
 
 - (NSUInteger)indexOfObjectWhere:(NSString *)predicateFormat, ...
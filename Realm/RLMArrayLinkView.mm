@@ -128,6 +128,22 @@ static inline void RLMValidateObjectClass(__unsafe_unretained RLMObjectBase *con
     return batchCount;
 }
 
+- (RLMNotificationToken *)addNotificationBlock:(RLMCollectionNotificationBlock)block {
+    RLMLinkViewArrayValidateAttached(self);
+    tightdb::LinkViewRef linkView = _backingLinkView;
+    return RLMAddCollectionNotificationBlock(self, _objectSchema, &linkView->get_origin_table(), block, ^BOOL(std::vector<size_t>& rows) {
+        if (!linkView->is_attached()) {
+            return NO;
+        }
+        size_t count = linkView->size();
+        rows.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            rows.push_back(linkView->get(i).get_index());
+        }
+        return YES;
+    });
+}
+
 - (id)objectAtIndex:(NSUInteger)index {
     RLMLinkViewArrayValidateAttached(self);
 
@@ -229,6 +245,14 @@ static inline void RLMValidateObjectClass(__unsafe_unretained RLMObjectBase *con
 - (void)deleteObjectsFromRealm {
     RLMLinkViewArrayValidateInWriteTransaction(self);
 
+    if (RLMObjectSchemaHasIndexes(_objectSchema)) {
+        std::vector<size_t> rows;
+        for (size_t i = 0; i < _backingLinkView->size(); ++i) {
+            rows.push_back(_backingLinkView->get(i).get_index());
+        }
+        RLMRemoveFromIndexes(_realm, _objectSchema, rows);
+    }
+
     // delete all target rows from the realm
     self->_backingLinkView->remove_all_target_rows();
 }
@@ -243,10 +267,12 @@ static inline void RLMValidateObjectClass(__unsafe_unretained RLMObjectBase *con
 
     tightdb::TableView const &tv = _backingLinkView->get_sorted_view(move(columns), move(order));
     auto query = std::make_unique<tightdb::Query>(_backingLinkView->get_target_table().where(_backingLinkView));
-    return [RLMResults resultsWithObjectClassName:self.objectClassName
-                                                 query:move(query)
-                                                  view:tv
-                                                 realm:_realm];
+    RLMResults *results = [RLMResults resultsWithObjectClassName:self.objectClassName
+                                                           query:move(query)
+                                                            view:tv
+                                                           realm:_realm];
+    [results setPredicates:@[] linkView:_backingLinkView];
+    return results;
 
 }
 
@@ -255,9 +281,11 @@ static inline void RLMValidateObjectClass(__unsafe_unretained RLMObjectBase *con
 
     tightdb::Query query = _backingLinkView->get_target_table().where(_backingLinkView);
     RLMUpdateQueryWithPredicate(&query, predicate, _realm.schema, _realm.schema[self.objectClassName]);
-    return [RLMResults resultsWithObjectClassName:self.objectClassName
-                                            query:std::make_unique<tightdb::Query>(query)
-                                            realm:_realm];
+    RLMResults *results = [RLMResults resultsWithObjectClassName:self.objectClassName
+                                                           query:std::make_unique<tightdb::Query>(query)
+                                                           realm:_realm];
+    [results setPredicates:predicate ? @[predicate] : @[] linkView:_backingLinkView];
+    return results;
 }
 
 @end
@@ -20,10 +20,12 @@
 #import "RLMResults.h"
 
 #import <memory>
+#import <vector>
 
 namespace tightdb {
     class LinkView;
     class Query;
+    class Table;
     class TableView;
 
     namespace util {
@@ -33,6 +35,7 @@ namespace tightdb {
 }
 
 @class RLMObjectSchema;
+@class RLMPreparedPredicate;
 
 // RLMArray private properties/ivars for all subclasses
 @interface RLMArray () {
@@ -74,6 +77,11 @@ namespace tightdb {
                                       view:(tightdb::TableView)view
                                      realm:(RLMRealm *)realm;
 - (void)deleteObjectsFromRealm;
+- (RLMResults *)objectsWithPreparedPredicate:(RLMPreparedPredicate *)predicate arguments:(NSArray *)arguments;
+
+// record the link view (or table, if null) which the query is over and the
+// predicates applied to it to build the query, which are described by -explain
+- (void)setPredicates:(NSArray *)predicates linkView:(tightdb::LinkViewRef)linkView;
 @end
 
 //
@@ -91,6 +99,18 @@ namespace tightdb {
 + (RLMResults *)tableResultsWithObjectSchema:(RLMObjectSchema *)objectSchema realm:(RLMRealm *)realm;
 @end
 
+// Add a notification block to the collection's realm which calls `block` with
+// the changes made to the collection each time the realm changes. `getRows`
+// fills in the table row of each object in the collection, in order, and
+// returns NO once the collection is no longer valid. `listOrigin` is the table
+// holding the RLMArray the objects come from, if any, as changes to it change
+// the collection without changing the objects' table.
+RLMNotificationToken *RLMAddCollectionNotificationBlock(id<RLMCollection> collection,
+                                                        RLMObjectSchema *objectSchema,
+                                                        tightdb::Table *listOrigin,
+                                                        RLMCollectionNotificationBlock block,
+                                                        BOOL (^getRows)(std::vector<size_t>& rows));
+
 //
 // A simple holder for a C array of ids to enable autoreleasing the array without
 // the runtime overhead of a NSMutableArray
@@ -16,7 +16,16 @@
 //
 ////////////////////////////////////////////////////////////////////////////
 
-@class RLMRealm, RLMResults, RLMObject;
+@class RLMRealm, RLMResults, RLMObject, RLMNotificationToken, RLMCollectionChange;
+@protocol RLMCollection;
+
+/**
+ The type of the block passed to `-[RLMCollection addNotificationBlock:]`.
+
+ It receives the collection which changed and an RLMCollectionChange describing
+ which objects in it were inserted, deleted and modified.
+ */
+typedef void (^RLMCollectionNotificationBlock)(id<RLMCollection> collection, RLMCollectionChange *change);
 
 @protocol RLMCollection <NSFastEnumeration>
 
@@ -37,5 +46,40 @@
 - (RLMResults *)sortedResultsUsingProperty:(NSString *)property ascending:(BOOL)ascending;
 - (RLMResults *)sortedResultsUsingDescriptors:(NSArray *)properties;
 - (id)objectAtIndexedSubscript:(NSUInteger)index;
+- (RLMNotificationToken *)addNotificationBlock:(RLMCollectionNotificationBlock)block;
+
+@end
+
+/**
+ RLMCollectionChange describes the changes made to the objects in an RLMResults
+ or RLMArray by the write transactions which were committed since the previous
+ notification for that collection.
+
+ The indices can be passed directly to the batch update methods of
+ UITableView and UICollectionView: remove the deleted rows and reload the
+ modified rows using indices in the old collection, then insert rows using
+ indices in the new collection. An object which moved to a different position
+ is reported as deleted from its old index and inserted at its new one.
+ */
+@interface RLMCollectionChange : NSObject
+
+/**
+ The indices in the previous version of the collection of the objects which
+ are no longer in it.
+ */
+@property (nonatomic, readonly) NSIndexSet *deletions;
+
+/**
+ The indices in the new version of the collection of the objects which were
+ added to it.
+ */
+@property (nonatomic, readonly) NSIndexSet *insertions;
+
+/**
+ The indices in the previous version of the collection of the objects which
+ are still in it at the same relative position but had one or more of their
+ properties changed.
+ */
+@property (nonatomic, readonly) NSIndexSet *modifications;
 
 @end
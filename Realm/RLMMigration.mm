@@ -31,6 +31,9 @@
 #import <tightdb/link_view.hpp>
 #import <tightdb/table_view.hpp>
 
+#include <algorithm>
+#include <vector>
+
 // The source realm for a migration has to use a SharedGroup to be able to share
 // the file with the destination realm, but we don't want to let the user call
 // beginWriteTransaction on it as that would make no sense.
@@ -103,27 +106,29 @@
         RLMProperty *primaryProperty = objectSchema.primaryKeyProperty;
         RLMProperty *oldPrimaryProperty = [[_oldRealm.schema schemaForClassName:objectSchema.className] primaryKeyProperty];
         if (primaryProperty && primaryProperty != oldPrimaryProperty) {
-            // FIXME: replace with count of distinct once we support indexing
-
-            // FIXME: support other types
+            // primary keys are always indexed, including ones designated by this migration
             tightdb::Table *table = objectSchema.table;
-            NSUInteger count = table->size();
+            if (!table->has_search_index(primaryProperty.column)) {
+                table->add_search_index(primaryProperty.column);
+            }
+
+            bool unique;
             if (primaryProperty.type == RLMPropertyTypeString) {
-                if (!table->has_search_index(primaryProperty.column)) {
-                    table->add_search_index(primaryProperty.column);
-                }
-                if (table->get_distinct_view(primaryProperty.column).size() != count) {
-                    NSString *reason = [NSString stringWithFormat:@"Primary key property '%@' has duplicate values after migration.", primaryProperty.name];
-                    @throw RLMException(reason);
-                }
+                unique = table->get_distinct_view(primaryProperty.column).size() == table->size();
             }
             else {
-                for (NSUInteger i = 0; i < count; i++) {
-                    if (table->count_int(primaryProperty.column, table->get_int(primaryProperty.column, i)) > 1) {
-                        NSString *reason = [NSString stringWithFormat:@"Primary key property '%@' has duplicate values after migration.", primaryProperty.name];
-                        @throw RLMException(reason);
-                    }
+                // sort a copy of the keys rather than counting each one
+                std::vector<int64_t> keys;
+                keys.reserve(table->size());
+                for (size_t i = 0; i < table->size(); i++) {
+                    keys.push_back(table->get_int(primaryProperty.column, i));
                 }
+                std::sort(keys.begin(), keys.end());
+                unique = std::adjacent_find(keys.begin(), keys.end()) == keys.end();
+            }
+            if (!unique) {
+                NSString *reason = [NSString stringWithFormat:@"Primary key property '%@' has duplicate values after migration.", primaryProperty.name];
+                @throw RLMException(reason);
             }
         }
     }
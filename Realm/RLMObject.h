@@ -210,11 +210,39 @@
 
 /**
  Return an array of property names for properties which should be indexed. Only supported
- for string properties.
+ for string, integer, BOOL and NSDate properties.
  @return    NSArray of property names.
  */
 + (NSArray *)indexedProperties;
 
+/**
+ Return an array of compound indexes, each an array of two or more property names. Only supported
+ for string, integer, BOOL and NSDate properties. A compound index is used for queries which compare
+ all but the last of its properties for equality, optionally along with an equality or range
+ comparison on the last property, e.g. `@[@[@"accountId", @"timestamp"]]` for
+ `accountId == 5 AND timestamp > %@`.
+ @return    NSArray of NSArrays of property names.
+ */
++ (NSArray *)compoundIndexes;
+
+/**
+ Return an array of property names for properties which should have a full-text index. Only
+ supported for string properties. Full-text indexed properties can be searched for words, word
+ prefixes and phrases with the `MATCHES` operator, e.g. `[Note objectsWhere:@"text MATCHES 'realm dat*'"]`.
+ @return    NSArray of property names.
+ */
++ (NSArray *)fullTextIndexedProperties;
+
+/**
+ Return an array of property names for properties which should have an ordered index. Supported
+ for string, integer, float, double, BOOL and NSDate properties. Results sorted by an ordered indexed
+ property are read in the order of the index rather than sorted, and `<`, `<=`, `>`, `>=` and
+ `BETWEEN` comparisons on ordered indexed numeric and NSDate properties look up the matching
+ objects in the index.
+ @return    NSArray of property names.
+ */
++ (NSArray *)orderedIndexedProperties;
+
 /**
  Implement to indicate the default values to be used for each property.
  
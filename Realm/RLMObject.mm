@@ -140,6 +140,18 @@
     return @[];
 }
 
++ (NSArray *)fullTextIndexedProperties {
+    return @[];
+}
+
++ (NSArray *)orderedIndexedProperties {
+    return @[];
+}
+
++ (NSArray *)compoundIndexes {
+    return @[];
+}
+
 + (NSDictionary *)defaultPropertyValues {
     return nil;
 }
@@ -315,6 +315,18 @@ Class RLMObjectUtilClass(BOOL isSwift) {
     return [cls indexedProperties];
 }
 
++ (NSArray *)fullTextIndexedPropertiesForClass:(Class)cls {
+    return [cls fullTextIndexedProperties];
+}
+
++ (NSArray *)orderedIndexedPropertiesForClass:(Class)cls {
+    return [cls orderedIndexedProperties];
+}
+
++ (NSArray *)compoundIndexesForClass:(Class)cls {
+    return [cls compoundIndexes];
+}
+
 + (NSArray *)getGenericListPropertyNames:(__unused id)obj {
     return nil;
 }
@@ -39,6 +39,8 @@
 @implementation RLMObjectSchema {
     // table accessor optimization
     tightdb::TableRef _table;
+
+    NSMutableDictionary *_compiledPredicates;
 }
 
 - (instancetype)initWithClassName:(NSString *)objectClassName objectClass:(Class)objectClass properties:(NSArray *)properties {
@@ -65,6 +67,16 @@
         }
     }
     _propertiesByName = map;
+
+    // compiled predicates refer to the columns of the old properties
+    [_compiledPredicates removeAllObjects];
+}
+
+- (NSMutableDictionary *)compiledPredicates {
+    if (!_compiledPredicates) {
+        _compiledPredicates = [NSMutableDictionary new];
+    }
+    return _compiledPredicates;
 }
 
 - (void)setPrimaryKeyProperty:(RLMProperty *)primaryKeyProperty {
@@ -104,10 +116,7 @@
     if (NSString *primaryKey = [objectClass primaryKey]) {
         for (RLMProperty *prop in schema.properties) {
             if ([primaryKey isEqualToString:prop.name]) {
-                 // FIXME - enable for ints when we have core suppport
-                if (prop.type == RLMPropertyTypeString) {
-                    prop.indexed = YES;
-                }
+                prop.indexed = YES;
                 schema.primaryKeyProperty = prop;
                 break;
             }
@@ -123,6 +132,53 @@
         }
     }
 
+    for (NSString *propertyName in [RLMObjectUtilClass(isSwift) fullTextIndexedPropertiesForClass:objectClass]) {
+        RLMProperty *prop = schema[propertyName];
+        if (!prop) {
+            NSString *message = [NSString stringWithFormat:@"Full-text indexed property '%@' does not exist on object '%@'",
+                                 propertyName, className];
+            @throw RLMException(message);
+        }
+        if (prop.type != RLMPropertyTypeString) {
+            @throw RLMException(@"Only 'string' properties can have a full-text index");
+        }
+        prop.fullTextIndexed = YES;
+    }
+
+    for (NSString *propertyName in [RLMObjectUtilClass(isSwift) orderedIndexedPropertiesForClass:objectClass]) {
+        RLMProperty *prop = schema[propertyName];
+        if (!prop) {
+            NSString *message = [NSString stringWithFormat:@"Ordered indexed property '%@' does not exist on object '%@'",
+                                 propertyName, className];
+            @throw RLMException(message);
+        }
+        if (!RLMPropertyTypeSupportsOrderedIndex(prop.type)) {
+            @throw RLMException(@"Only 'string', 'int', 'float', 'double', 'bool' and 'date' properties can have an ordered index");
+        }
+        prop.orderedIndexed = YES;
+    }
+
+    NSArray *compoundIndexes = [RLMObjectUtilClass(isSwift) compoundIndexesForClass:objectClass];
+    for (NSArray *propertyNames in compoundIndexes) {
+        if (![propertyNames isKindOfClass:NSArray.class] || propertyNames.count < 2) {
+            @throw RLMException(@"Compound indexes must be arrays of two or more property names");
+        }
+        for (NSString *propertyName in propertyNames) {
+            RLMProperty *prop = schema[propertyName];
+            if (!prop) {
+                NSString *message = [NSString stringWithFormat:@"Compound index property '%@' does not exist on object '%@'",
+                                     propertyName, className];
+                @throw RLMException(message);
+            }
+            if (prop.type != RLMPropertyTypeString && prop.type != RLMPropertyTypeInt &&
+                prop.type != RLMPropertyTypeBool && prop.type != RLMPropertyTypeDate) {
+                @throw RLMException(@"Only 'string', 'int', 'bool' and 'date' properties can be part of a compound index");
+            }
+            prop.compoundIndexed = YES;
+        }
+    }
+    schema.compoundIndexes = compoundIndexes;
+
     return schema;
 }
 
@@ -221,6 +277,22 @@
         }
     }
 
+    // full-text indexes are stored as tables alongside the object table
+    for (RLMProperty *prop in propArray) {
+        if (prop.type == RLMPropertyTypeString && RLMRealmHasFullTextIndex(realm, className, prop.name)) {
+            prop.fullTextIndexed = YES;
+        }
+        if (RLMPropertyTypeSupportsOrderedIndex(prop.type) && RLMRealmHasOrderedIndex(realm, className, prop.name)) {
+            prop.orderedIndexed = YES;
+        }
+    }
+    schema.compoundIndexes = RLMRealmCompoundIndexesForObjectClass(realm, className);
+    for (NSArray *propertyNames in schema.compoundIndexes) {
+        for (NSString *propertyName in propertyNames) {
+            schema[propertyName].compoundIndexed = YES;
+        }
+    }
+
     // for dynamic schema use vanilla RLMObject accessor classes
     schema.objectClass = RLMObject.class;
     schema.accessorClass = RLMObject.class;
@@ -237,6 +309,7 @@
     schema->_accessorClass = _accessorClass;
     schema->_standaloneClass = _standaloneClass;
     schema->_isSwiftClass = _isSwiftClass;
+    schema->_compoundIndexes = _compoundIndexes;
 
     // call property setter to reset map and primary key
     schema.properties = [[NSArray allocWithZone:zone] initWithArray:_properties copyItems:YES];
@@ -258,6 +331,7 @@
     schema->_properties = _properties;
     schema->_propertiesByName = _propertiesByName;
     schema->_primaryKeyProperty = _primaryKeyProperty;
+    schema->_compoundIndexes = _compoundIndexes;
 
     // _table not copied as it's tightdb::Group-specific
     return schema;
@@ -275,6 +349,9 @@
         if (p1.type != p2.type ||
             p1.column != p2.column ||
             p1.isPrimary != p2.isPrimary ||
+            p1.fullTextIndexed != p2.fullTextIndexed ||
+            p1.orderedIndexed != p2.orderedIndexed ||
+            p1.compoundIndexed != p2.compoundIndexed ||
             ![p1.name isEqualToString:p2.name] ||
             !(p1.objectClassName == p2.objectClassName || [p1.objectClassName isEqualToString:p2.objectClassName])) {
             return NO;
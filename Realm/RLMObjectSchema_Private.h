@@ -34,8 +34,15 @@
 
 @property (nonatomic, readwrite) RLMProperty *primaryKeyProperty;
 
+// arrays of the names of the properties in each compound index
+@property (nonatomic, copy) NSArray *compoundIndexes;
+
 // The Realm retains its object schemas, so they need to not retain the Realm
 @property (nonatomic, unsafe_unretained) RLMRealm *realm;
+
+// predicates which have been compiled against this object schema, keyed on
+// the structure of the predicate (see RLMUpdateQueryWithPredicate)
+@property (nonatomic, readonly) NSMutableDictionary *compiledPredicates;
 // returns a cached or new schema for a given object class
 +(instancetype)schemaForObjectClass:(Class)objectClass;
 
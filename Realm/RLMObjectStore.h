@@ -22,7 +22,7 @@
 extern "C" {
 #endif
 
-@class RLMRealm, RLMSchema, RLMObjectSchema, RLMObjectBase, RLMResults;
+@class RLMRealm, RLMSchema, RLMObjectSchema, RLMObjectBase, RLMResults, RLMProperty;
 
 //
 // Table modifications
@@ -89,6 +89,15 @@ id RLMGetObject(RLMRealm *realm, NSString *objectClassName, id key);
 // create object from array or dictionary
 RLMObjectBase *RLMCreateObjectInRealmWithValue(RLMRealm *realm, NSString *className, id value, RLMCreationOptions options);
 
+// update the full-text, compound and ordered indexes of a property after it has been set
+void RLMUpdateIndexes(RLMObjectBase *object, RLMProperty *prop);
+
+// whether the objects of a class are in any full-text, compound or ordered indexes
+BOOL RLMObjectSchemaHasIndexes(RLMObjectSchema *objectSchema);
+
+// clear the full-text, compound and ordered indexes of a class when all of its objects are deleted
+void RLMClearIndexes(RLMRealm *realm, RLMObjectSchema *objectSchema);
+
 
 //
 // Accessor Creation
@@ -103,3 +112,11 @@ RLMObjectBase *RLMCreateObjectAccessor(__unsafe_unretained RLMRealm *const realm
 #ifdef __cplusplus
 }
 #endif
+
+#ifdef __cplusplus
+#import <vector>
+
+// remove objects from the full-text, compound and ordered indexes of their class
+// before deleting their rows
+void RLMRemoveFromIndexes(RLMRealm *realm, RLMObjectSchema *objectSchema, std::vector<size_t> const& rows);
+#endif
@@ -32,6 +32,9 @@
 
 #import <objc/message.h>
 
+#include <algorithm>
+#include <vector>
+
 extern "C" {
 
 static void RLMVerifyAndAlignColumns(RLMObjectSchema *tableSchema, RLMObjectSchema *objectSchema) {
@@ -87,6 +90,18 @@ static void RLMVerifyAndAlignColumns(RLMObjectSchema *tableSchema, RLMObjectSche
     objectSchema.properties = properties;
 }
 
+static bool RLMPropertyTypeSupportsSearchIndex(RLMPropertyType type) {
+    switch (type) {
+        case RLMPropertyTypeString:
+        case RLMPropertyTypeInt:
+        case RLMPropertyTypeBool:
+        case RLMPropertyTypeDate:
+            return true;
+        default:
+            return false;
+    }
+}
+
 // create a column for a property in a table
 // NOTE: must be called from within write transaction
 static void RLMCreateColumn(RLMRealm *realm, tightdb::Table &table, RLMProperty *prop) {
@@ -101,18 +116,335 @@ static void RLMCreateColumn(RLMRealm *realm, tightdb::Table &table, RLMProperty
         default: {
             prop.column = table.add_column(tightdb::DataType(prop.type), prop.name.UTF8String);
             if (prop.indexed) {
-                // FIXME - support other types
-                if (prop.type != RLMPropertyTypeString) {
-                    NSLog(@"RLMPropertyAttributeIndexed only supported for 'NSString' properties");
+                if (RLMPropertyTypeSupportsSearchIndex(prop.type)) {
+                    table.add_search_index(prop.column);
                 }
                 else {
-                    table.add_search_index(prop.column);
+                    NSLog(@"RLMPropertyAttributeIndexed only supported for 'NSString', integer, 'BOOL' and 'NSDate' properties");
                 }
             }
         }
     }
 }
 
+// get the column for an indexed property which is missing its search index,
+// such as the primary key of a table created by an older version or a property
+// which was added to indexedProperties later
+// columns may not be aligned with the schema yet, so look up the column by name
+static size_t RLMUnindexedColumn(tightdb::Table &table, RLMProperty *prop) {
+    if (!prop.indexed || !RLMPropertyTypeSupportsSearchIndex(prop.type)) {
+        return tightdb::not_found;
+    }
+    size_t column = table.get_column_index(prop.name.UTF8String);
+    if (column == tightdb::not_found || table.get_column_type(column) != tightdb::DataType(prop.type)
+        || table.has_search_index(column)) {
+        return tightdb::not_found;
+    }
+    return column;
+}
+
+// add any missing search indexes
+// NOTE: must be called from within write transaction
+static bool RLMRealmCreateSearchIndexes(RLMObjectSchema *objectSchema) {
+    bool changed = false;
+    tightdb::Table &table = *objectSchema.table;
+    for (RLMProperty *prop in objectSchema.properties) {
+        size_t column = RLMUnindexedColumn(table, prop);
+        if (column != tightdb::not_found) {
+            table.add_search_index(column);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// remove all postings for a row from a full-text or compound index
+static void RLMRemovePostings(tightdb::Table &index, size_t linkColumn, tightdb::Table const& table, size_t row) {
+    while (size_t count = table.get_backlink_count(row, index, linkColumn)) {
+        index.move_last_over(table.get_backlink(row, index, linkColumn, count - 1));
+    }
+}
+
+// drop a full-text or compound index
+// tables can't be removed, so the index is left behind without any columns
+static void RLMDropIndexTable(tightdb::TableRef index) {
+    if (!index) {
+        return;
+    }
+    index->clear();
+    while (size_t count = index->get_column_count()) {
+        index->remove_column(count - 1);
+    }
+}
+
+// add postings for each word of a string to a full-text index
+static void RLMAddToFullTextIndex(tightdb::Table &index, tightdb::StringData text, size_t row) {
+    NSArray *tokens = RLMFullTextTokens(RLMStringDataToNSString(text));
+    for (NSUInteger position = 0; position < tokens.count; position++) {
+        size_t posting = index.add_empty_row();
+        index.set_string(c_fullTextIndexTokenColumnIndex, posting, RLMStringDataWithNSString(tokens[position]));
+        index.set_link(c_fullTextIndexObjectColumnIndex, posting, row);
+        index.set_int(c_fullTextIndexPositionColumnIndex, posting, position);
+    }
+}
+
+static tightdb::TableRef RLMFullTextIndexTable(RLMRealm *realm, NSString *className, RLMProperty *prop) {
+    return realm.group->get_table(RLMFullTextIndexTableName(className, prop.name).UTF8String);
+}
+
+// create or drop full-text indexes to match the schema, indexing any existing objects
+// NOTE: must be called from within write transaction
+static bool RLMRealmCreateFullTextIndexes(RLMRealm *realm, RLMObjectSchema *objectSchema) {
+    bool changed = false;
+    tightdb::Table &table = *objectSchema.table;
+    for (RLMProperty *prop in objectSchema.properties) {
+        if (prop.type != RLMPropertyTypeString ||
+            prop.fullTextIndexed == RLMRealmHasFullTextIndex(realm, objectSchema.className, prop.name)) {
+            continue;
+        }
+
+        changed = true;
+        if (!prop.fullTextIndexed) {
+            RLMDropIndexTable(RLMFullTextIndexTable(realm, objectSchema.className, prop));
+            continue;
+        }
+
+        // columns are not aligned with the schema yet, so look up the column by name
+        size_t column = table.get_column_index(prop.name.UTF8String);
+        if (column == tightdb::not_found || table.get_column_type(column) != tightdb::type_String) {
+            // verifying the schema will report the missing column
+            continue;
+        }
+
+        tightdb::TableRef index = realm.group->get_or_add_table(RLMFullTextIndexTableName(objectSchema.className, prop.name).UTF8String);
+        index->add_column(tightdb::type_String, "token");
+        index->add_search_index(c_fullTextIndexTokenColumnIndex);
+        index->add_column_link(tightdb::type_Link, "object", table);
+        index->add_column(tightdb::type_Int, "position");
+        for (size_t row = 0; row < table.size(); row++) {
+            RLMAddToFullTextIndex(*index, table.get_string(column, row), row);
+        }
+    }
+    return changed;
+}
+
+static tightdb::TableRef RLMCompoundIndexTable(RLMRealm *realm, NSString *className, NSArray *propertyNames) {
+    return realm.group->get_table(RLMCompoundIndexTableName(className, propertyNames).UTF8String);
+}
+
+static std::vector<size_t> RLMCompoundIndexColumns(RLMObjectSchema *objectSchema, NSArray *propertyNames) {
+    std::vector<size_t> columns;
+    for (NSString *propertyName in propertyNames) {
+        columns.push_back(objectSchema[propertyName].column);
+    }
+    return columns;
+}
+
+// add the row of a compound index for an object, keyed on the values of all but the
+// last of the index's columns, and holding the value of the last one
+static void RLMAddToCompoundIndex(tightdb::Table &index, tightdb::Table &table, std::vector<size_t> const& columns, size_t row) {
+    std::string key;
+    for (size_t i = 0; i + 1 < columns.size(); i++) {
+        switch (table.get_column_type(columns[i])) {
+            case tightdb::type_String:
+                RLMAppendCompoundIndexKey(key, table.get_string(columns[i], row));
+                break;
+            case tightdb::type_Bool:
+                RLMAppendCompoundIndexKey(key, int64_t(table.get_bool(columns[i], row)));
+                break;
+            case tightdb::type_DateTime:
+                RLMAppendCompoundIndexKey(key, int64_t(table.get_datetime(columns[i], row).get_datetime()));
+                break;
+            default:
+                RLMAppendCompoundIndexKey(key, table.get_int(columns[i], row));
+                break;
+        }
+    }
+
+    size_t posting = index.add_empty_row();
+    index.set_string(c_compoundIndexKeyColumnIndex, posting, tightdb::StringData(key));
+    index.set_link(c_compoundIndexObjectColumnIndex, posting, row);
+
+    size_t column = columns.back();
+    switch (table.get_column_type(column)) {
+        case tightdb::type_String:
+            index.set_string(c_compoundIndexValueColumnIndex, posting, table.get_string(column, row));
+            break;
+        case tightdb::type_Bool:
+            index.set_bool(c_compoundIndexValueColumnIndex, posting, table.get_bool(column, row));
+            break;
+        case tightdb::type_DateTime:
+            index.set_datetime(c_compoundIndexValueColumnIndex, posting, table.get_datetime(column, row));
+            break;
+        default:
+            index.set_int(c_compoundIndexValueColumnIndex, posting, table.get_int(column, row));
+            break;
+    }
+}
+
+// create or drop compound indexes to match the schema, indexing any existing objects
+// NOTE: must be called from within write transaction
+static bool RLMRealmCreateCompoundIndexes(RLMRealm *realm, RLMObjectSchema *objectSchema) {
+    bool changed = false;
+    NSArray *compoundIndexes = objectSchema.compoundIndexes ?: @[];
+    for (NSArray *propertyNames in RLMRealmCompoundIndexesForObjectClass(realm, objectSchema.className)) {
+        if (![compoundIndexes containsObject:propertyNames]) {
+            RLMDropIndexTable(RLMCompoundIndexTable(realm, objectSchema.className, propertyNames));
+            changed = true;
+        }
+    }
+
+    tightdb::Table &table = *objectSchema.table;
+    for (NSArray *propertyNames in compoundIndexes) {
+        tightdb::TableRef index = RLMCompoundIndexTable(realm, objectSchema.className, propertyNames);
+        if (index && index->get_column_count() != 0) {
+            continue;
+        }
+
+        // columns are not aligned with the schema yet, so look up the columns by name
+        std::vector<size_t> columns;
+        for (NSString *propertyName in propertyNames) {
+            size_t column = table.get_column_index(propertyName.UTF8String);
+            if (column == tightdb::not_found ||
+                table.get_column_type(column) != tightdb::DataType(objectSchema[propertyName].type)) {
+                break;
+            }
+            columns.push_back(column);
+        }
+        if (columns.size() != propertyNames.count) {
+            // verifying the schema will report the missing column
+            continue;
+        }
+
+        index = realm.group->get_or_add_table(RLMCompoundIndexTableName(objectSchema.className, propertyNames).UTF8String);
+        index->add_column(tightdb::type_String, "key");
+        index->add_search_index(c_compoundIndexKeyColumnIndex);
+        index->add_column_link(tightdb::type_Link, "object", table);
+        index->add_column(table.get_column_type(columns.back()), "value");
+        for (size_t row = 0; row < table.size(); row++) {
+            RLMAddToCompoundIndex(*index, table, columns, row);
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+static tightdb::TableRef RLMOrderedIndexTable(RLMRealm *realm, NSString *className, RLMProperty *prop) {
+    return realm.group->get_table(RLMOrderedIndexTableName(className, prop.name).UTF8String);
+}
+
+// add the row for an object to an ordered index, after any rows with the same value
+static void RLMAddToOrderedIndex(tightdb::Table &index, tightdb::Table &table, size_t column, size_t row) {
+    size_t posting = RLMOrderedIndexBound(index.size(), [&](size_t posting) {
+        return RLMCompareRowValues(index, c_orderedIndexValueColumnIndex, posting, table, column, row);
+    }, true);
+    index.insert_empty_row(posting);
+    RLMCopyRowValue(index, c_orderedIndexValueColumnIndex, posting, table, column, row);
+    index.set_link(c_orderedIndexObjectColumnIndex, posting, row);
+}
+
+// remove the row for an object from an ordered index
+// unlike the other indexes the rows are removed rather than moved over, to
+// keep the remaining rows in order
+static void RLMRemoveFromOrderedIndex(tightdb::Table &index, tightdb::Table const& table, size_t row) {
+    while (size_t count = table.get_backlink_count(row, index, c_orderedIndexObjectColumnIndex)) {
+        index.remove(table.get_backlink(row, index, c_orderedIndexObjectColumnIndex, count - 1));
+    }
+}
+
+// create or drop ordered indexes to match the schema, indexing any existing objects
+// NOTE: must be called from within write transaction
+static bool RLMRealmCreateOrderedIndexes(RLMRealm *realm, RLMObjectSchema *objectSchema) {
+    bool changed = false;
+    tightdb::Table &table = *objectSchema.table;
+    for (RLMProperty *prop in objectSchema.properties) {
+        if (!RLMPropertyTypeSupportsOrderedIndex(prop.type) ||
+            prop.orderedIndexed == RLMRealmHasOrderedIndex(realm, objectSchema.className, prop.name)) {
+            continue;
+        }
+
+        changed = true;
+        if (!prop.orderedIndexed) {
+            RLMDropIndexTable(RLMOrderedIndexTable(realm, objectSchema.className, prop));
+            continue;
+        }
+
+        // columns are not aligned with the schema yet, so look up the column by name
+        size_t column = table.get_column_index(prop.name.UTF8String);
+        if (column == tightdb::not_found || table.get_column_type(column) != tightdb::DataType(prop.type)) {
+            // verifying the schema will report the missing column
+            continue;
+        }
+
+        // sort the existing objects once and append them in order rather than
+        // inserting each one
+        std::vector<size_t> rows(table.size());
+        for (size_t row = 0; row < rows.size(); row++) {
+            rows[row] = row;
+        }
+        std::stable_sort(rows.begin(), rows.end(), [&](size_t a, size_t b) {
+            return RLMCompareRowValues(table, column, a, table, column, b) < 0;
+        });
+
+        tightdb::TableRef index = realm.group->get_or_add_table(RLMOrderedIndexTableName(objectSchema.className, prop.name).UTF8String);
+        index->add_column(table.get_column_type(column), "value");
+        index->add_column_link(tightdb::type_Link, "object", table);
+        index->add_empty_row(rows.size());
+        for (size_t posting = 0; posting < rows.size(); posting++) {
+            RLMCopyRowValue(*index, c_orderedIndexValueColumnIndex, posting, table, column, rows[posting]);
+            index->set_link(c_orderedIndexObjectColumnIndex, posting, rows[posting]);
+        }
+    }
+    return changed;
+}
+
+BOOL RLMObjectSchemaHasIndexes(RLMObjectSchema *objectSchema) {
+    for (RLMProperty *prop in objectSchema.properties) {
+        if (prop.fullTextIndexed || prop.orderedIndexed) {
+            return YES;
+        }
+    }
+    return objectSchema.compoundIndexes.count != 0;
+}
+
+void RLMRemoveFromIndexes(RLMRealm *realm, RLMObjectSchema *objectSchema, std::vector<size_t> const& rows) {
+    tightdb::Table const& table = *objectSchema.table;
+    for (RLMProperty *prop in objectSchema.properties) {
+        if (prop.fullTextIndexed) {
+            tightdb::TableRef index = RLMFullTextIndexTable(realm, objectSchema.className, prop);
+            for (size_t row : rows) {
+                RLMRemovePostings(*index, c_fullTextIndexObjectColumnIndex, table, row);
+            }
+        }
+        if (prop.orderedIndexed) {
+            tightdb::TableRef index = RLMOrderedIndexTable(realm, objectSchema.className, prop);
+            for (size_t row : rows) {
+                RLMRemoveFromOrderedIndex(*index, table, row);
+            }
+        }
+    }
+    for (NSArray *propertyNames in objectSchema.compoundIndexes) {
+        tightdb::TableRef index = RLMCompoundIndexTable(realm, objectSchema.className, propertyNames);
+        for (size_t row : rows) {
+            RLMRemovePostings(*index, c_compoundIndexObjectColumnIndex, table, row);
+        }
+    }
+}
+
+void RLMClearIndexes(RLMRealm *realm, RLMObjectSchema *objectSchema) {
+    for (RLMProperty *prop in objectSchema.properties) {
+        if (prop.fullTextIndexed) {
+            RLMFullTextIndexTable(realm, objectSchema.className, prop)->clear();
+        }
+        if (prop.orderedIndexed) {
+            RLMOrderedIndexTable(realm, objectSchema.className, prop)->clear();
+        }
+    }
+    for (NSArray *propertyNames in objectSchema.compoundIndexes) {
+        RLMCompoundIndexTable(realm, objectSchema.className, propertyNames)->clear();
+    }
+}
+
 // Schema used to created generated accessors
 static NSMutableArray * const s_accessorSchema = [NSMutableArray new];
 
@@ -176,6 +508,25 @@ static bool RLMRealmGetTables(RLMRealm *realm, RLMSchema *targetSchema) {
             return false;
         }
         objectSchema.table = table.get();
+
+        for (RLMProperty *prop in objectSchema.properties) {
+            if (RLMUnindexedColumn(*table, prop) != tightdb::not_found) {
+                return false;
+            }
+            if (prop.type == RLMPropertyTypeString &&
+                prop.fullTextIndexed != RLMRealmHasFullTextIndex(realm, objectSchema.className, prop.name)) {
+                return false;
+            }
+            if (RLMPropertyTypeSupportsOrderedIndex(prop.type) &&
+                prop.orderedIndexed != RLMRealmHasOrderedIndex(realm, objectSchema.className, prop.name)) {
+                return false;
+            }
+        }
+
+        NSArray *compoundIndexes = RLMRealmCompoundIndexesForObjectClass(realm, objectSchema.className);
+        if (![[NSSet setWithArray:compoundIndexes] isEqualToSet:[NSSet setWithArray:objectSchema.compoundIndexes ?: @[]]]) {
+            return false;
+        }
     }
 
     return true;
@@ -225,6 +576,12 @@ static bool RLMRealmCreateTables(RLMRealm *realm, RLMSchema *targetSchema, bool
         for (int i = (int)tableSchema.properties.count - 1; i >= 0; i--) {
             RLMProperty *prop = tableSchema.properties[i];
             if (RLMPropertyHasChanged(prop, objectSchema[prop.name])) {
+                if (prop.fullTextIndexed) {
+                    RLMDropIndexTable(RLMFullTextIndexTable(realm, objectSchema.className, prop));
+                }
+                if (prop.orderedIndexed) {
+                    RLMDropIndexTable(RLMOrderedIndexTable(realm, objectSchema.className, prop));
+                }
                 objectSchema.table->remove_column(prop.column);
                 changed = true;
             }
@@ -245,6 +602,14 @@ static bool RLMRealmCreateTables(RLMRealm *realm, RLMSchema *targetSchema, bool
         }
     }
 
+    // search, full-text, compound and ordered indexes can be added without a migration
+    for (RLMObjectSchema *objectSchema in targetSchema.objectSchema) {
+        changed = RLMRealmCreateSearchIndexes(objectSchema) || changed;
+        changed = RLMRealmCreateFullTextIndexes(realm, objectSchema) || changed;
+        changed = RLMRealmCreateCompoundIndexes(realm, objectSchema) || changed;
+        changed = RLMRealmCreateOrderedIndexes(realm, objectSchema) || changed;
+    }
+
     // FIXME - remove deleted tables
 
     return changed;
@@ -341,6 +706,25 @@ static inline void RLMInitializeSwiftListAccessor(RLMObjectBase *object) {
 
 } // extern "C" {
 
+// options for setting the primary key of a new row
+// a row created when updating was just looked up by its primary key, so the
+// key only needs checking for uniqueness if objects linked from properties set
+// before it are created first, as they can include another object with the key
+static inline RLMCreationOptions RLMPrimaryKeyCreationOptions(RLMObjectSchema *schema, RLMCreationOptions options) {
+    if (!(options & RLMCreationOptionsUpdateOrCreate)) {
+        return RLMCreationOptionsEnforceUnique;
+    }
+    for (RLMProperty *prop in schema.properties) {
+        if (prop.isPrimary) {
+            break;
+        }
+        if (prop.type == RLMPropertyTypeObject || prop.type == RLMPropertyTypeArray) {
+            return RLMCreationOptionsEnforceUnique;
+        }
+    }
+    return RLMCreationOptionsNone;
+}
+
 template<typename F>
 static inline NSUInteger RLMCreateOrGetRowForObject(RLMObjectSchema *schema, F primaryValueGetter, RLMCreationOptions options, bool &created) {
     // try to get existing row if updating
@@ -399,6 +783,7 @@ void RLMAddObjectToRealm(RLMObjectBase *object, RLMRealm *realm, RLMCreationOpti
     bool created;
     auto primaryGetter = [=](RLMProperty *p) { return [object valueForKey:p.getterName]; };
     object->_row = (*schema.table)[RLMCreateOrGetRowForObject(schema, primaryGetter, options, created)];
+    RLMCreationOptions primaryOptions = RLMPrimaryKeyCreationOptions(schema, options);
 
     // populate all properties
     for (RLMProperty *prop in schema.properties) {
@@ -420,7 +805,7 @@ void RLMAddObjectToRealm(RLMObjectBase *object, RLMRealm *realm, RLMCreationOpti
         // set in table with out validation
         // skip primary key when updating since it doesn't change
         if (created || !prop.isPrimary) {
-            RLMDynamicSet(object, prop, value, options | (prop.isPrimary ? RLMCreationOptionsEnforceUnique : 0));
+            RLMDynamicSet(object, prop, value, options | (prop.isPrimary ? primaryOptions : 0));
         }
 
         // set the ivars for object and array properties to nil as otherwise the
@@ -458,6 +843,7 @@ RLMObjectBase *RLMCreateObjectInRealmWithValue(RLMRealm *realm, NSString *classN
     RLMSchema *schema = realm.schema;
     RLMObjectSchema *objectSchema = schema[className];
     RLMObjectBase *object = [[objectSchema.accessorClass alloc] initWithRealm:realm schema:objectSchema];
+    RLMCreationOptions primaryOptions = RLMPrimaryKeyCreationOptions(objectSchema, options);
 
     // validate values, create row, and populate
     if (NSArray *array = RLMDynamicCast<NSArray>(value)) {
@@ -475,7 +861,7 @@ RLMObjectBase *RLMCreateObjectInRealmWithValue(RLMRealm *realm, NSString *classN
             // skip primary key when updating since it doesn't change
             if (created || !prop.isPrimary) {
                 RLMDynamicSet(object, prop, array[i],
-                              options | RLMCreationOptionsUpdateOrCreate | (prop.isPrimary ? RLMCreationOptionsEnforceUnique : 0));
+                              options | RLMCreationOptionsUpdateOrCreate | (prop.isPrimary ? primaryOptions : 0));
             }
         }
     }
@@ -494,7 +880,7 @@ RLMObjectBase *RLMCreateObjectInRealmWithValue(RLMRealm *realm, NSString *classN
             id propValue = dict[prop.name];
             if (propValue && (created || !prop.isPrimary)) {
                 RLMDynamicSet(object, prop, propValue,
-                              options | RLMCreationOptionsUpdateOrCreate | (prop.isPrimary ? RLMCreationOptionsEnforceUnique : 0));
+                              options | RLMCreationOptionsUpdateOrCreate | (prop.isPrimary ? primaryOptions : 0));
             }
         }
     }
@@ -503,6 +889,35 @@ RLMObjectBase *RLMCreateObjectInRealmWithValue(RLMRealm *realm, NSString *classN
     return object;
 }
 
+void RLMUpdateIndexes(RLMObjectBase *object, RLMProperty *prop) {
+    RLMObjectSchema *objectSchema = object->_objectSchema;
+    tightdb::Table &table = *object->_row.get_table();
+    size_t row = object->_row.get_index();
+
+    if (prop.fullTextIndexed) {
+        tightdb::TableRef index = RLMFullTextIndexTable(object->_realm, objectSchema.className, prop);
+        RLMRemovePostings(*index, c_fullTextIndexObjectColumnIndex, table, row);
+        RLMAddToFullTextIndex(*index, table.get_string(prop.column, row), row);
+    }
+
+    if (prop.orderedIndexed) {
+        tightdb::TableRef index = RLMOrderedIndexTable(object->_realm, objectSchema.className, prop);
+        RLMRemoveFromOrderedIndex(*index, table, row);
+        RLMAddToOrderedIndex(*index, table, prop.column, row);
+    }
+
+    if (prop.compoundIndexed) {
+        for (NSArray *propertyNames in objectSchema.compoundIndexes) {
+            if (![propertyNames containsObject:prop.name]) {
+                continue;
+            }
+            tightdb::TableRef index = RLMCompoundIndexTable(object->_realm, objectSchema.className, propertyNames);
+            RLMRemovePostings(*index, c_compoundIndexObjectColumnIndex, table, row);
+            RLMAddToCompoundIndex(*index, table, RLMCompoundIndexColumns(objectSchema, propertyNames), row);
+        }
+    }
+}
+
 void RLMDeleteObjectFromRealm(RLMObjectBase *object, RLMRealm *realm) {
     if (realm != object->_realm) {
         @throw RLMException(@"Can only delete an object from the Realm it belongs to.");
@@ -512,6 +927,7 @@ void RLMDeleteObjectFromRealm(RLMObjectBase *object, RLMRealm *realm) {
 
     // move last row to row we are deleting
     if (object->_row.is_attached()) {
+        RLMRemoveFromIndexes(realm, object->_objectSchema, {object->_row.get_index()});
         object->_row.get_table()->move_last_over(object->_row.get_index());
     }
 
@@ -525,6 +941,7 @@ void RLMDeleteAllObjectsFromRealm(RLMRealm *realm) {
     // clear table for each object schema
     for (RLMObjectSchema *objectSchema in realm.schema.objectSchema) {
         objectSchema.table->clear();
+        RLMClearIndexes(realm, objectSchema);
     }
 }
 
@@ -544,9 +961,11 @@ RLMResults *RLMGetObjects(RLMRealm *realm, NSString *objectClassName, NSPredicat
         RLMUpdateQueryWithPredicate(&query, predicate, realm.schema, objectSchema);
 
         // create and populate array
-        return [RLMResults resultsWithObjectClassName:objectClassName
-                                                query:std::make_unique<Query>(query)
-                                                realm:realm];
+        RLMResults *results = [RLMResults resultsWithObjectClassName:objectClassName
+                                                               query:std::make_unique<Query>(query)
+                                                               realm:realm];
+        [results setPredicates:@[predicate] linkView:{}];
+        return results;
     }
 
     return [RLMTableResults tableResultsWithObjectSchema:objectSchema realm:realm];
@@ -67,6 +67,9 @@ FOUNDATION_EXTERN Class RLMObjectUtilClass(BOOL isSwift);
 + (NSString *)primaryKeyForClass:(Class)cls;
 + (NSArray *)ignoredPropertiesForClass:(Class)cls;
 + (NSArray *)indexedPropertiesForClass:(Class)cls;
++ (NSArray *)fullTextIndexedPropertiesForClass:(Class)cls;
++ (NSArray *)orderedIndexedPropertiesForClass:(Class)cls;
++ (NSArray *)compoundIndexesForClass:(Class)cls;
 
 + (NSArray *)getGenericListPropertyNames:(id)obj;
 + (void)initializeListProperty:(RLMObjectBase *)object property:(RLMProperty *)property array:(RLMArray *)array;
@@ -48,6 +48,20 @@
  */
 @property (nonatomic, readonly) BOOL indexed;
 
+/**
+ Indicates if this property has a full-text index.
+
+ @see RLMObject
+ */
+@property (nonatomic, readonly) BOOL fullTextIndexed;
+
+/**
+ Indicates if this property has an ordered index.
+
+ @see RLMObject
+ */
+@property (nonatomic, readonly) BOOL orderedIndexed;
+
 /**
  Object class name - specify object types for RLMObject and RLMArray properties.
  */
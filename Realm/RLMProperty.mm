@@ -294,6 +294,9 @@
     prop->_objcType = _objcType;
     prop->_objectClassName = _objectClassName;
     prop->_indexed = _indexed;
+    prop->_fullTextIndexed = _fullTextIndexed;
+    prop->_orderedIndexed = _orderedIndexed;
+    prop->_compoundIndexed = _compoundIndexed;
     prop->_getterName = _getterName;
     prop->_setterName = _setterName;
     prop->_getterSel = _getterSel;
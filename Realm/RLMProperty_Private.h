@@ -42,11 +42,15 @@
 @property (nonatomic, assign) NSUInteger column;
 @property (nonatomic, readwrite, assign) RLMPropertyType type;
 @property (nonatomic, readwrite) BOOL indexed;
+@property (nonatomic, readwrite) BOOL fullTextIndexed;
+@property (nonatomic, readwrite) BOOL orderedIndexed;
 @property (nonatomic, copy) NSString *objectClassName;
 
 // private properties
 @property (nonatomic, assign) char objcType;
 @property (nonatomic, assign) BOOL isPrimary;
+// whether the property is part of any of its object's compound indexes
+@property (nonatomic, assign) BOOL compoundIndexed;
 @property (nonatomic, assign) Ivar swiftListIvar;
 
 // getter and setter names
@@ -35,8 +35,34 @@ extern NSString * const RLMUnsupportedTypesFoundInPropertyComparisonException;
 void RLMUpdateQueryWithPredicate(tightdb::Query *query, NSPredicate *predicate, RLMSchema *schema,
                                  RLMObjectSchema *objectSchema);
 
-// sort an existing view by the specified property name and direction
-void RLMUpdateViewWithOrder(tightdb::TableView &view, RLMObjectSchema *schema, NSArray *properties);
+// a predicate format which has been parsed and compiled against an object
+// schema once, with $0, $1, ... placeholders filled in each time it is applied
+@interface RLMPreparedPredicate : NSObject
+// the number of arguments which must be supplied when applying the predicate
+@property (nonatomic, readonly) NSUInteger argumentCount;
+@end
+
+// parse and compile a predicate format containing placeholders
+RLMPreparedPredicate *RLMPreparePredicate(NSString *predicateFormat, RLMSchema *schema,
+                                          RLMObjectSchema *objectSchema);
+
+// apply a prepared predicate to the passed in query, using arguments for the placeholders
+void RLMUpdateQueryWithPreparedPredicate(tightdb::Query *query, RLMPreparedPredicate *predicate,
+                                         NSArray *arguments);
+
+// append a description of how the predicate is evaluated to explanation,
+// including how many rows reach and are matched by each of its conditions, and
+// then apply the predicate to the query
+void RLMExplainPredicate(NSMutableString *explanation, tightdb::Query &query, NSPredicate *predicate,
+                         RLMSchema *schema, RLMObjectSchema *objectSchema);
+void RLMExplainPreparedPredicate(NSMutableString *explanation, tightdb::Query &query,
+                                 RLMPreparedPredicate *predicate, NSArray *arguments);
+
+// whether a predicate, or the arguments for a prepared predicate, contain
+// RLMObjects or collections of them, which tie the query built from them to
+// the thread of their realm
+bool RLMPredicateContainsObjects(NSPredicate *predicate);
+bool RLMArgumentsContainObjects(NSArray *arguments);
 
 // return column index - throw for invalid column name
 NSUInteger RLMValidatedColumnIndex(RLMObjectSchema *schema, NSString *columnName);
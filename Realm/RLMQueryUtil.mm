@@ -22,10 +22,19 @@
 #import "RLMObject_Private.hpp"
 #import "RLMObjectSchema_Private.hpp"
 #import "RLMProperty_Private.h"
+#import "RLMRealm_Private.hpp"
 #import "RLMSchema_Private.h"
 #import "RLMUtil.hpp"
 
 #include <tightdb.hpp>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <unordered_set>
+
 using namespace tightdb;
 
 NSString * const RLMPropertiesComparisonTypeMismatchException = @"RLMPropertiesComparisonTypeMismatchException";
@@ -69,32 +78,35 @@ NSUInteger RLMValidatedColumnIndex(RLMObjectSchema *desc, NSString *columnName)
 }
 
 namespace {
-// add a clause for numeric constraints based on operator type
+// add a clause for numeric constraints based on operator type. These use
+// core's column conditions rather than a Columns<T> expression, as the
+// conditions search each leaf of the column with SIMD comparisons, while
+// expressions are evaluated one row at a time.
 template <typename T>
 void add_numeric_constraint_to_query(tightdb::Query& query,
                                      RLMPropertyType datatype,
                                      NSPredicateOperatorType operatorType,
-                                     Columns<T> &&column,
+                                     size_t column,
                                      T value)
 {
     switch (operatorType) {
         case NSLessThanPredicateOperatorType:
-            query.and_query(column < value);
+            query.less(column, value);
             break;
         case NSLessThanOrEqualToPredicateOperatorType:
-            query.and_query(column <= value);
+            query.less_equal(column, value);
             break;
         case NSGreaterThanPredicateOperatorType:
-            query.and_query(column > value);
+            query.greater(column, value);
             break;
         case NSGreaterThanOrEqualToPredicateOperatorType:
-            query.and_query(column >= value);
+            query.greater_equal(column, value);
             break;
         case NSEqualToPredicateOperatorType:
-            query.and_query(column == value);
+            query.equal(column, value);
             break;
         case NSNotEqualToPredicateOperatorType:
-            query.and_query(column != value);
+            query.not_equal(column, value);
             break;
         default:
             @throw RLMPredicateException(@"Invalid operator type",
@@ -102,6 +114,37 @@ void add_numeric_constraint_to_query(tightdb::Query& query,
     }
 }
 
+void add_datetime_constraint_to_query(tightdb::Query& query,
+                                      NSPredicateOperatorType operatorType,
+                                      size_t column,
+                                      DateTime value)
+{
+    switch (operatorType) {
+        case NSLessThanPredicateOperatorType:
+            query.less_datetime(column, value);
+            break;
+        case NSLessThanOrEqualToPredicateOperatorType:
+            query.less_equal_datetime(column, value);
+            break;
+        case NSGreaterThanPredicateOperatorType:
+            query.greater_datetime(column, value);
+            break;
+        case NSGreaterThanOrEqualToPredicateOperatorType:
+            query.greater_equal_datetime(column, value);
+            break;
+        case NSEqualToPredicateOperatorType:
+            query.equal_datetime(column, value);
+            break;
+        case NSNotEqualToPredicateOperatorType:
+            query.not_equal_datetime(column, value);
+            break;
+        default:
+            @throw RLMPredicateException(@"Invalid operator type",
+                                         @"Operator type %lu not supported for type %@", (unsigned long)operatorType,
+                                         RLMTypeToString(RLMPropertyTypeDate));
+    }
+}
+
 void add_bool_constraint_to_query(tightdb::Query &query,
                                        NSPredicateOperatorType operatorType,
                                        Columns<Bool> &&column,
@@ -126,9 +169,6 @@ void add_string_constraint_to_query(tightdb::Query &query,
                                     Columns<String> &&column,
                                     NSString *value) {
     bool caseSensitive = !(predicateOptions & NSCaseInsensitivePredicateOption);
-    bool diacriticInsensitive = (predicateOptions & NSDiacriticInsensitivePredicateOption);
-    RLMPrecondition(!diacriticInsensitive, @"Invalid predicate option",
-                    @"NSDiacriticInsensitivePredicateOption not supported for string type");
 
     tightdb::StringData sd = RLMStringDataWithNSString(value);
     switch (operatorType) {
@@ -153,6 +193,296 @@ void add_string_constraint_to_query(tightdb::Query &query,
     }
 }
 
+// Case and diacritic folding of UTF-8 strings for [c] and [d] string
+// comparisons. Both the value searched for and each row's value are folded and
+// then compared bytewise. ASCII strings, which are checked for eight bytes at a
+// time, only need their letters lowercased; other characters are decoded and
+// looked up in folding tables covering Latin-1, Latin Extended-A, Greek and
+// Cyrillic, and combining diacritical marks are dropped for [d].
+class StringFolder {
+public:
+    StringFolder(bool caseInsensitive, bool diacriticInsensitive)
+    : m_caseInsensitive(caseInsensitive), m_diacriticInsensitive(diacriticInsensitive) { }
+
+    // fold str into out, stopping once at least limit bytes have been written
+    void fold(StringData str, std::string& out, size_t limit = size_t(-1)) const {
+        out.clear();
+        const char *data = str.data();
+        size_t size = str.size();
+
+        if (is_ascii(data, size)) {
+            size = std::min(size, limit);
+            out.assign(data, size);
+            if (m_caseInsensitive) {
+                // written without branches so that the compiler can vectorize it
+                for (char& c : out) {
+                    c += char(uint8_t(c - 'A') < 26) * ('a' - 'A');
+                }
+            }
+            return;
+        }
+
+        for (size_t i = 0; i < size && out.size() < limit; ) {
+            uint32_t codePoint = decode(data, size, i);
+            if (m_diacriticInsensitive) {
+                if (codePoint >= 0x300 && codePoint < 0x370) {
+                    // combining diacritical mark
+                    continue;
+                }
+                codePoint = strip_diacritic(codePoint);
+            }
+            if (m_caseInsensitive) {
+                codePoint = lowercase(codePoint);
+            }
+            encode(codePoint, out);
+        }
+    }
+
+private:
+    bool m_caseInsensitive;
+    bool m_diacriticInsensitive;
+
+    static bool is_ascii(const char *data, size_t size) {
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(word));
+            if (word & 0x8080808080808080ULL) {
+                return false;
+            }
+        }
+        for (; i < size; ++i) {
+            if (data[i] & 0x80) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // decode the code point starting at data[i] and advance i past it; bytes
+    // which aren't valid UTF-8 are returned as-is
+    static uint32_t decode(const char *data, size_t size, size_t& i) {
+        uint8_t lead = data[i++];
+        size_t length = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+        if (length == 0 || i + length > size) {
+            return lead;
+        }
+        uint32_t codePoint = lead & (0x3F >> length);
+        for (size_t j = 0; j < length; ++j) {
+            codePoint = (codePoint << 6) | (uint8_t(data[i++]) & 0x3F);
+        }
+        return codePoint;
+    }
+
+    static void encode(uint32_t codePoint, std::string& out) {
+        if (codePoint < 0x80) {
+            out += char(codePoint);
+        }
+        else if (codePoint < 0x800) {
+            out += char(0xC0 | (codePoint >> 6));
+            out += char(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000) {
+            out += char(0xE0 | (codePoint >> 12));
+            out += char(0x80 | ((codePoint >> 6) & 0x3F));
+            out += char(0x80 | (codePoint & 0x3F));
+        }
+        else {
+            out += char(0xF0 | (codePoint >> 18));
+            out += char(0x80 | ((codePoint >> 12) & 0x3F));
+            out += char(0x80 | ((codePoint >> 6) & 0x3F));
+            out += char(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    static uint32_t strip_diacritic(uint32_t codePoint) {
+        // the base letter of each character from U+00C0 to U+017F, or '.' for
+        // letters which aren't a base letter with a diacritic
+        static const char latin[] =
+            "AAAAAA.CEEEEIIII.NOOOOO..UUUUY.." "aaaaaa.ceeeeiiii.nooooo..uuuuy.y"
+            "AaAaAaCcCcCcCcDd..EeEeEeEeEeGgGg" "GgGgHh..IiIiIiIiI...JjKk.LlLlLlL"
+            "l..NnNnNn...OoOoOo..RrRrRrSsSsSs" "SsTtTt..UuUuUuUuUuUuWwYyYZzZzZz.";
+        static_assert(sizeof(latin) == 0x180 - 0xC0 + 1, "one entry per character");
+        if (codePoint >= 0xC0 && codePoint < 0x180) {
+            char base = latin[codePoint - 0xC0];
+            return base == '.' ? codePoint : uint32_t(base);
+        }
+
+        switch (codePoint) {
+            // Greek letters with tonos and dialytika
+            case 0x386: return 0x391;
+            case 0x388: return 0x395;
+            case 0x389: return 0x397;
+            case 0x38A: case 0x3AA: return 0x399;
+            case 0x38C: return 0x39F;
+            case 0x38E: case 0x3AB: return 0x3A5;
+            case 0x38F: return 0x3A9;
+            case 0x3AC: return 0x3B1;
+            case 0x3AD: return 0x3B5;
+            case 0x3AE: return 0x3B7;
+            case 0x3AF: case 0x390: case 0x3CA: return 0x3B9;
+            case 0x3CC: return 0x3BF;
+            case 0x3CD: case 0x3B0: case 0x3CB: return 0x3C5;
+            case 0x3CE: return 0x3C9;
+            // Cyrillic io and short i
+            case 0x401: return 0x415;
+            case 0x451: return 0x435;
+            case 0x419: return 0x418;
+            case 0x439: return 0x438;
+            default: return codePoint;
+        }
+    }
+
+    static uint32_t lowercase(uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            return codePoint - 'A' < 26 ? codePoint + ('a' - 'A') : codePoint;
+        }
+        if (codePoint >= 0xC0 && codePoint <= 0xDE && codePoint != 0xD7) {
+            return codePoint + 0x20;
+        }
+        if (codePoint >= 0x100 && codePoint < 0x180) {
+            switch (codePoint) {
+                case 0x130: return 'i';
+                case 0x178: return 0xFF;
+                case 0x17F: return 's';
+                case 0x131: case 0x138: case 0x149: return codePoint;
+            }
+            // pairs of upper and lower case letters, which start at an odd
+            // code point from U+0139 to U+0148 and U+0179 to U+017E
+            bool oddPairs = (codePoint >= 0x139 && codePoint <= 0x148) || codePoint >= 0x179;
+            bool upper = oddPairs ? (codePoint & 1) : !(codePoint & 1);
+            return upper ? codePoint + 1 : codePoint;
+        }
+        if (codePoint >= 0x391 && codePoint <= 0x3A9 && codePoint != 0x3A2) {
+            return codePoint + 0x20;
+        }
+        if (codePoint >= 0x410 && codePoint <= 0x42F) {
+            return codePoint + 0x20;
+        }
+        if (codePoint >= 0x400 && codePoint <= 0x40F) {
+            return codePoint + 0x50;
+        }
+        switch (codePoint) {
+            case 0x386: return 0x3AC;
+            case 0x388: case 0x389: case 0x38A: return codePoint + 0x25;
+            case 0x38C: return 0x3CC;
+            case 0x38E: case 0x38F: return codePoint + 0x3F;
+            case 0x3C2: return 0x3C3; // final sigma
+            default: return codePoint;
+        }
+    }
+};
+
+// [c] and [d] comparisons of a string property with a constant, which fold
+// each row's value with a StringFolder and compare it to the folded constant.
+// For properties reached through links, a row matches if any of the objects
+// linked to matches.
+class FoldedStringExpression : public tightdb::Expression {
+public:
+    FoldedStringExpression(Table *table, std::vector<NSUInteger> const& linkColumns, size_t column,
+                           NSPredicateOperatorType operatorType, StringFolder folder, StringData value)
+    : m_table(table), m_column(column), m_operatorType(operatorType), m_folder(folder)
+    {
+        Table *linkTable = table;
+        for (NSUInteger linkColumn : linkColumns) {
+            TableRef target = linkTable->get_link_target(linkColumn);
+            m_links.push_back({linkColumn, linkTable->get_column_type(linkColumn) == type_LinkList, target});
+            linkTable = target.get();
+        }
+        m_folder.fold(value, m_value);
+    }
+
+    size_t find_first(size_t start, size_t end) const override {
+        bool negate = m_operatorType == NSNotEqualToPredicateOperatorType;
+        for (; start < end; ++start) {
+            if (matches(*m_table, start, 0) != negate) {
+                return start;
+            }
+        }
+        return tightdb::not_found;
+    }
+
+    void set_table() override { }
+    const Table* get_table() override { return m_table; }
+
+private:
+    struct LinkStep {
+        size_t column;
+        bool isList;
+        TableRef target;
+    };
+
+    Table *m_table;
+    size_t m_column;
+    NSPredicateOperatorType m_operatorType;
+    StringFolder m_folder;
+    std::vector<LinkStep> m_links;
+    std::string m_value;
+    mutable std::string m_buffer;
+
+    bool matches(Table& table, size_t row, size_t depth) const {
+        if (depth == m_links.size()) {
+            return matches(table.get_string(m_column, row));
+        }
+
+        LinkStep const& link = m_links[depth];
+        if (link.isList) {
+            LinkViewRef linkView = table.get_linklist(link.column, row);
+            for (size_t i = 0; i < linkView->size(); ++i) {
+                if (matches(*link.target, linkView->get(i).get_index(), depth + 1)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        return !table.is_null_link(link.column, row)
+            && matches(*link.target, table.get_link(link.column, row), depth + 1);
+    }
+
+    bool matches(StringData str) const {
+        switch (m_operatorType) {
+            case NSBeginsWithPredicateOperatorType:
+                m_folder.fold(str, m_buffer, m_value.size());
+                return m_buffer.compare(0, m_value.size(), m_value) == 0;
+            case NSEndsWithPredicateOperatorType:
+                m_folder.fold(str, m_buffer);
+                return m_buffer.size() >= m_value.size()
+                    && m_buffer.compare(m_buffer.size() - m_value.size(), m_value.size(), m_value) == 0;
+            case NSContainsPredicateOperatorType:
+                m_folder.fold(str, m_buffer);
+                return m_buffer.find(m_value) != std::string::npos;
+            default:
+                // == and !=, the latter negated by find_first()
+                m_folder.fold(str, m_buffer);
+                return m_buffer == m_value;
+        }
+    }
+};
+
+void add_folded_string_constraint_to_query(tightdb::Query &query,
+                                           NSPredicateOperatorType operatorType,
+                                           NSComparisonPredicateOptions predicateOptions,
+                                           std::vector<NSUInteger> const& linkColumns,
+                                           NSUInteger column,
+                                           NSString *value) {
+    switch (operatorType) {
+        case NSBeginsWithPredicateOperatorType:
+        case NSEndsWithPredicateOperatorType:
+        case NSContainsPredicateOperatorType:
+        case NSEqualToPredicateOperatorType:
+        case NSNotEqualToPredicateOperatorType:
+            break;
+        default:
+            @throw RLMPredicateException(@"Invalid operator type",
+                                         @"Operator type %lu not supported for string type", (unsigned long)operatorType);
+    }
+
+    StringFolder folder(predicateOptions & NSCaseInsensitivePredicateOption,
+                        predicateOptions & NSDiacriticInsensitivePredicateOption);
+    query.expression(new FoldedStringExpression(query.get_table().get(), linkColumns, column, operatorType,
+                                                folder, RLMStringDataWithNSString(value)), true);
+}
+
 id value_from_constant_expression_or_value(id value) {
     if (NSExpression *exp = RLMDynamicCast<NSExpression>(value)) {
         RLMPrecondition(exp.expressionType == NSConstantValueExpressionType,
@@ -179,6 +509,8 @@ void add_constraint_to_query(tightdb::Query &query, RLMPropertyType type,
                              NSPredicateOperatorType operatorType,
                              NSComparisonPredicateOptions predicateOptions,
                              std::vector<NSUInteger> linkColumns, NSUInteger idx, id value);
+bool add_indexed_range_constraint_to_query(Query &query, RLMPropertyType type, size_t column,
+                                           int64_t from, int64_t to);
 
 void add_between_constraint_to_query(tightdb::Query &query, std::vector<NSUInteger> const& indexes, RLMProperty *prop, id value) {
     id from, to;
@@ -197,9 +529,12 @@ void add_between_constraint_to_query(tightdb::Query &query, std::vector<NSUInteg
     // add to query
     switch (prop.type) {
         case type_DateTime:
-            query.between_datetime(index,
-                                   [from timeIntervalSince1970],
-                                   [to timeIntervalSince1970]);
+            if (!add_indexed_range_constraint_to_query(query, prop.type, index, int64_t([from timeIntervalSince1970]),
+                                                       int64_t([to timeIntervalSince1970]))) {
+                query.between_datetime(index,
+                                       [from timeIntervalSince1970],
+                                       [to timeIntervalSince1970]);
+            }
             break;
         case type_Double:
             query.between(index, [from doubleValue], [to doubleValue]);
@@ -208,7 +543,9 @@ void add_between_constraint_to_query(tightdb::Query &query, std::vector<NSUInteg
             query.between(index, [from floatValue], [to floatValue]);
             break;
         case type_Int:
-            query.between(index, [from longLongValue], [to longLongValue]);
+            if (!add_indexed_range_constraint_to_query(query, prop.type, index, [from longLongValue], [to longLongValue])) {
+                query.between(index, [from longLongValue], [to longLongValue]);
+            }
             break;
         default:
             @throw RLMPredicateException(@"Unsupported predicate value type",
@@ -261,24 +598,291 @@ void add_link_constraint_to_query(tightdb::Query & query,
     }
 }
 
-// iterate over an array of subpredicates, using @func to build a query from each
-// one and ORing them together
-template<typename Func>
-void process_or_group(Query &query, id array, Func&& func) {
-    RLMPrecondition([array conformsToProtocol:@protocol(NSFastEnumeration)],
-                    @"Invalid value", @"IN clause requires an array of items");
+// Matches the objects from which following a chain of links reaches a row of
+// the chain's last table which matches a condition. Rather than following the
+// links from each object, the matching rows of the last table are found first,
+// and the chain is then walked backwards through the backlinks of each link
+// column, joining each table to the one before it. An object with a list of
+// links at any level of the chain matches if any of the linked objects do.
+class LinkChainExpression : public tightdb::Expression {
+public:
+    // finds the rows of the last table of the chain which match the condition
+    typedef std::function<std::vector<size_t>(Table&)> Matcher;
+
+    LinkChainExpression(Table *table, std::vector<NSUInteger> linkColumns, Matcher matcher)
+    : m_table(table), m_linkColumns(std::move(linkColumns)), m_matcher(std::move(matcher))
+    {
+    }
+
+    size_t find_first(size_t start, size_t end) const override {
+        auto it = std::lower_bound(m_rows.begin(), m_rows.end(), start);
+        return it != m_rows.end() && *it < end ? *it : tightdb::not_found;
+    }
+
+    void set_table() override {
+        std::vector<TableRef> tables{m_table->get_table_ref()};
+        for (size_t column : m_linkColumns) {
+            tables.push_back(tables.back()->get_link_target(column));
+        }
+
+        std::vector<size_t> rows = m_matcher(*tables.back());
+        for (size_t i = m_linkColumns.size(); i-- > 0 && !rows.empty(); ) {
+            Table &origin = *tables[i], &target = *tables[i + 1];
+            size_t column = m_linkColumns[i];
+            std::vector<bool> matched(origin.size());
+            for (size_t row : rows) {
+                for (size_t j = 0, count = target.get_backlink_count(row, origin, column); j < count; ++j) {
+                    matched[target.get_backlink(row, origin, column, j)] = true;
+                }
+            }
+            rows.clear();
+            for (size_t row = 0; row < matched.size(); ++row) {
+                if (matched[row]) {
+                    rows.push_back(row);
+                }
+            }
+        }
+        m_rows = std::move(rows);
+    }
+
+    const Table* get_table() override { return m_table; }
+
+private:
+    Table *m_table;
+    std::vector<NSUInteger> m_linkColumns;
+    Matcher m_matcher;
+    std::vector<size_t> m_rows;
+};
+
+// Match the objects from which following a chain of links reaches a row which
+// matches the conditions added by add_conditions to a query on the chain's
+// last table. The conditions are added upfront so that invalid values are
+// reported when the predicate is applied rather than when the query is run,
+// and they are evaluated by core's column conditions like any other query.
+void add_link_chain_constraint_to_query(Query &query, std::vector<NSUInteger> const& linkColumns,
+                                        std::function<void(Query &)> const& add_conditions) {
+    TableRef target = query.get_table();
+    for (size_t column : linkColumns) {
+        target = target->get_link_target(column);
+    }
+
+    auto matching = std::make_shared<Query>(target->where());
+    add_conditions(*matching);
+
+    query.expression(new LinkChainExpression(query.get_table().get(), linkColumns, [=](Table &) {
+        TableView view = matching->find_all();
+        std::vector<size_t> rows;
+        rows.reserve(view.size());
+        for (size_t i = 0; i < view.size(); ++i) {
+            rows.push_back(view.get_source_ndx(i));
+        }
+        return rows;
+    }), true);
+}
+
+void add_link_chain_link_constraint_to_query(Query &query, NSPredicateOperatorType operatorType,
+                                             std::vector<NSUInteger> const& linkColumns,
+                                             NSUInteger column, RLMObject *obj) {
+    RLMPrecondition(operatorType == NSEqualToPredicateOperatorType || operatorType == NSNotEqualToPredicateOperatorType,
+                    @"Invalid operator type", @"Only 'Equal' and 'Not Equal' operators supported for object comparison");
+    if (operatorType == NSNotEqualToPredicateOperatorType) {
+        query.Not();
+    }
+
+    size_t targetRow = obj ? obj->_row.get_index() : tightdb::not_found;
+    query.expression(new LinkChainExpression(query.get_table().get(), linkColumns, [=](Table &table) {
+        std::vector<size_t> rows;
+        if (targetRow != tightdb::not_found) {
+            // the rows linking to the object are its backlinks
+            Table &target = *table.get_link_target(column);
+            for (size_t i = 0, count = target.get_backlink_count(targetRow, table, column); i < count; ++i) {
+                rows.push_back(target.get_backlink(targetRow, table, column, i));
+            }
+            std::sort(rows.begin(), rows.end());
+            rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+        }
+        else {
+            bool isList = table.get_column_type(column) == type_LinkList;
+            for (size_t row = 0; row < table.size(); ++row) {
+                if (isList ? table.get_link_count(column, row) == 0 : table.is_null_link(column, row)) {
+                    rows.push_back(row);
+                }
+            }
+        }
+        return rows;
+    }), true);
+}
+
+// ALL matches the objects for which none of the objects reached through the
+// key path fail the comparison, so the rows of the last table of the chain
+// which don't match the comparison are joined back to the queried table and
+// the objects which reach any of them are excluded.
+void add_all_constraint_to_query(Query &query, std::vector<NSUInteger> const& linkColumns,
+                                 std::function<void(Query &)> const& addComparison) {
+    query.Not();
+    add_link_chain_constraint_to_query(query, linkColumns, [&](Query &failing) {
+        failing.Not();
+        failing.group();
+        addComparison(failing);
+        failing.end_group();
+    });
+}
+
+// Matches the objects whose list of links has a number of entries, or an
+// aggregate of a numeric property of the linked objects, which satisfies
+// bounds. The aggregate is computed from each row's link list as the query
+// reaches the row, so no accessors are created for the objects. When a filter
+// is given (for SUBQUERY) only the linked objects which match it are counted;
+// the filter is run once against the target table each time the query is run.
+class LinkListAggregateExpression : public tightdb::Expression {
+public:
+    enum class Aggregate { Count, Sum, Min, Max, Average };
+    typedef std::pair<NSPredicateOperatorType, double> Bound;
+
+    LinkListAggregateExpression(Table *table, size_t column, Aggregate aggregate, size_t targetColumn,
+                                std::vector<Bound> bounds, std::unique_ptr<Query> filter)
+    : m_table(table), m_column(column), m_aggregate(aggregate), m_targetColumn(targetColumn)
+    , m_bounds(std::move(bounds)), m_filter(std::move(filter))
+    {
+    }
+
+    size_t find_first(size_t start, size_t end) const override {
+        for (size_t row = start; row < end; ++row) {
+            double value;
+            if (aggregate(row, value) && satisfies_bounds(value)) {
+                return row;
+            }
+        }
+        return tightdb::not_found;
+    }
+
+    void set_table() override {
+        m_target = m_table->get_link_target(m_column);
+        m_matched.clear();
+        if (m_filter) {
+            TableView matches = m_filter->find_all();
+            m_matched.resize(m_target->size());
+            for (size_t i = 0; i < matches.size(); ++i) {
+                m_matched[matches.get_source_ndx(i)] = true;
+            }
+        }
+    }
+
+    const Table* get_table() override { return m_table; }
+
+private:
+    // compute the aggregate for a row, returning false if it has no value
+    // (the minimum, maximum or average of an empty list)
+    bool aggregate(size_t row, double &value) const {
+        if (m_aggregate == Aggregate::Count && !m_filter) {
+            value = m_table->get_link_count(m_column, row);
+            return true;
+        }
+
+        LinkViewRef links = m_table->get_linklist(m_column, row);
+        size_t count = 0;
+        double result = 0;
+        for (size_t i = 0, size = links->size(); i < size; ++i) {
+            size_t target = links->get(i).get_index();
+            if (m_filter && !m_matched[target]) {
+                continue;
+            }
+            if (m_aggregate == Aggregate::Count) {
+                ++count;
+                continue;
+            }
+
+            double element = target_value(target);
+            if (count == 0) {
+                result = element;
+            }
+            else if (m_aggregate == Aggregate::Min) {
+                result = std::min(result, element);
+            }
+            else if (m_aggregate == Aggregate::Max) {
+                result = std::max(result, element);
+            }
+            else {
+                result += element;
+            }
+            ++count;
+        }
+
+        switch (m_aggregate) {
+            case Aggregate::Count:
+                value = count;
+                return true;
+            case Aggregate::Sum:
+                value = result;
+                return true;
+            case Aggregate::Average:
+                value = count ? result / count : 0;
+                return count != 0;
+            case Aggregate::Min:
+            case Aggregate::Max:
+                value = result;
+                return count != 0;
+        }
+    }
+
+    double target_value(size_t row) const {
+        switch (m_target->get_column_type(m_targetColumn)) {
+            case type_Int:
+                return m_target->get_int(m_targetColumn, row);
+            case type_Float:
+                return m_target->get_float(m_targetColumn, row);
+            case type_Double:
+                return m_target->get_double(m_targetColumn, row);
+            case type_DateTime:
+                return m_target->get_datetime(m_targetColumn, row).get_datetime();
+            default:
+                TIGHTDB_ASSERT(false); // only numeric and date properties can be aggregated
+                return 0;
+        }
+    }
+
+    bool satisfies_bounds(double value) const {
+        for (auto const& bound : m_bounds) {
+            bool satisfied;
+            switch (bound.first) {
+                case NSEqualToPredicateOperatorType: satisfied = value == bound.second; break;
+                case NSNotEqualToPredicateOperatorType: satisfied = value != bound.second; break;
+                case NSLessThanPredicateOperatorType: satisfied = value < bound.second; break;
+                case NSLessThanOrEqualToPredicateOperatorType: satisfied = value <= bound.second; break;
+                case NSGreaterThanPredicateOperatorType: satisfied = value > bound.second; break;
+                case NSGreaterThanOrEqualToPredicateOperatorType: satisfied = value >= bound.second; break;
+                default: satisfied = false; break;
+            }
+            if (!satisfied) {
+                return false;
+            }
+        }
+        return true;
+    }
 
+    Table *m_table;
+    size_t m_column;
+    Aggregate m_aggregate;
+    size_t m_targetColumn;
+    std::vector<Bound> m_bounds;
+    std::unique_ptr<Query> m_filter;
+    TableRef m_target;
+    std::vector<bool> m_matched;
+};
+
+// build a group of ORed together conditions, with @for_each adding each of the
+// conditions to the query after calling the function passed to it
+template<typename ForEach>
+void process_or_group(Query &query, ForEach&& for_each) {
     query.group();
 
     bool first = true;
-    for (id item in array) {
+    for_each([&] {
         if (!first) {
             query.Or();
         }
         first = false;
-
-        func(item);
-    }
+    });
 
     if (first) {
         // Queries can't be empty, so if there's zero things in the OR group
@@ -296,108 +900,617 @@ void process_or_group(Query &query, id array, Func&& func) {
     query.end_group();
 }
 
-void add_constraint_to_query(tightdb::Query &query, RLMPropertyType type,
-                             NSPredicateOperatorType operatorType,
-                             NSComparisonPredicateOptions predicateOptions,
-                             std::vector<NSUInteger> linkColumns, NSUInteger idx, id value)
-{
-    tightdb::Table *(^table)() = ^{
-        tightdb::TableRef& tbl = query.get_table();
-        for (NSUInteger col : linkColumns) {
-            tbl->link(col); // mutates m_link_chain on table
+// accessors for reading the values of a column as a type which can be hashed
+struct IntColumnValue {
+    typedef int64_t type;
+    static type get(Table const& table, size_t column, size_t row) { return table.get_int(column, row); }
+    static type from(id value) { return [value longLongValue]; }
+    static TableView find_all(Table &table, size_t column, type value) { return table.find_all_int(column, value); }
+};
+struct DateColumnValue {
+    typedef int64_t type;
+    static type get(Table const& table, size_t column, size_t row) { return table.get_datetime(column, row).get_datetime(); }
+    static type from(id value) { return int64_t([value timeIntervalSince1970]); }
+    static TableView find_all(Table &table, size_t column, type value) { return table.find_all_datetime(column, DateTime(time_t(value))); }
+};
+struct FloatColumnValue {
+    typedef float type;
+    static type get(Table const& table, size_t column, size_t row) { return table.get_float(column, row); }
+    static type from(id value) { return [value floatValue]; }
+    static TableView find_all(Table &table, size_t column, type value) { return table.find_all_float(column, value); }
+};
+struct DoubleColumnValue {
+    typedef double type;
+    static type get(Table const& table, size_t column, size_t row) { return table.get_double(column, row); }
+    static type from(id value) { return [value doubleValue]; }
+    static TableView find_all(Table &table, size_t column, type value) { return table.find_all_double(column, value); }
+};
+
+// Set membership test for IN clauses on numeric columns, which hashes the
+// values once rather than comparing each row against every value in turn.
+// Indexed columns instead look up the rows matching each value in the search
+// index whenever the query is run, as with StringInExpression.
+template<typename ColumnValue>
+class InExpression : public tightdb::Expression {
+public:
+    InExpression(Table *table, size_t column, std::unordered_set<typename ColumnValue::type> values)
+    : m_table(table), m_column(column), m_values(std::move(values))
+    , m_indexed(table->has_search_index(column)) { }
+
+    size_t find_first(size_t start, size_t end) const override {
+        if (m_indexed) {
+            auto it = std::lower_bound(m_rows.begin(), m_rows.end(), start);
+            return it != m_rows.end() && *it < end ? *it : tightdb::not_found;
         }
-        return tbl.get();
-    };
 
-    switch (type) {
-        case type_Bool:
-            add_bool_constraint_to_query(query, operatorType, table()->column<bool>(idx), bool([value boolValue]));
-            break;
-        case type_DateTime:
-            add_numeric_constraint_to_query(query, type, operatorType, table()->column<Int>(idx), Int([value timeIntervalSince1970]));
-            break;
-        case type_Double:
-            add_numeric_constraint_to_query(query, type, operatorType, table()->column<Double>(idx), [value doubleValue]);
-            break;
-        case type_Float:
-            add_numeric_constraint_to_query(query, type, operatorType, table()->column<Float>(idx), [value floatValue]);
-            break;
-        case type_Int:
-            add_numeric_constraint_to_query(query, type, operatorType, table()->column<Int>(idx), [value longLongValue]);
-            break;
-        case type_String:
-            add_string_constraint_to_query(query, operatorType, predicateOptions, table()->column<String>(idx), value);
-            break;
-        case type_Binary:
-            if (linkColumns.empty()) {
-                add_binary_constraint_to_query(query, operatorType, idx, value);
-                break;
-            }
-            else {
-                @throw RLMPredicateException(@"Unsupported operator", @"Binary data is not supported.");
-            }
-        case type_Link:
-        case type_LinkList:
-            if (linkColumns.empty()) {
-                add_link_constraint_to_query(query, operatorType, idx, value);
-            }
-            else {
-                @throw RLMPredicateException(@"Unsupported operator", @"Multi-level object equality link queries are not supported.");
+        for (; start < end; ++start) {
+            if (m_values.count(ColumnValue::get(*m_table, m_column, start))) {
+                return start;
             }
-            break;
-        default:
-            @throw RLMPredicateException(@"Unsupported predicate value type",
-                                         @"Object type %@ not supported", RLMTypeToString(type));
+        }
+        return tightdb::not_found;
     }
-}
-
-RLMProperty *get_property_from_key_path(RLMSchema *schema, RLMObjectSchema *desc,
-                                        NSString *keyPath, std::vector<NSUInteger> &indexes, bool isAny)
-{
-    RLMProperty *prop = nil;
-    NSArray *paths = [keyPath componentsSeparatedByString:@"."];
-    indexes.reserve(paths.count - 1);
 
-    NSString *prevPath = nil;
-    for (NSString *path in paths) {
-        if (prop) {
-            RLMPrecondition(prop.type == RLMPropertyTypeObject || prop.type == RLMPropertyTypeArray,
-                            @"Invalid value", @"column name '%@' is not a link", prevPath);
-            indexes.push_back(prop.column);
-            prop = desc[path];
-            RLMPrecondition(prop, @"Invalid column name",
-                            @"Column name %@ not found in table", path);
+    void set_table() override {
+        if (!m_indexed) {
+            return;
         }
-        else {
-            prop = desc[path];
-            RLMPrecondition(prop, @"Invalid column name",
-                            @"Column name %@ not found in table", path);
 
-            if (isAny) {
-                RLMPrecondition(prop.type == RLMPropertyTypeArray,
-                                @"Invalid predicate",
-                                @"ANY modifier can only be used for RLMArray properties");
-            }
-            else {
-                RLMPrecondition(prop.type != RLMPropertyTypeArray,
-                                @"Invalid predicate",
-                                @"RLMArray predicates must contain the ANY modifier");
+        m_rows.clear();
+        for (auto value : m_values) {
+            TableView matches = ColumnValue::find_all(*m_table, m_column, value);
+            for (size_t i = 0; i < matches.size(); ++i) {
+                m_rows.push_back(matches.get_source_ndx(i));
             }
         }
-
-        if (prop.objectClassName) {
-            desc = schema[prop.objectClassName];
-        }
-        prevPath = path;
+        std::sort(m_rows.begin(), m_rows.end());
     }
 
-    return prop;
-}
+    const Table* get_table() override { return m_table; }
 
-void validate_property_value(RLMProperty *prop, id value, NSString *err) {
-    if (prop.type == RLMPropertyTypeArray) {
-        RLMPrecondition([RLMDynamicCast<RLMObject>(value).objectSchema.className isEqualToString:prop.objectClassName],
-                        @"Invalid value", err, prop.objectClassName);
+private:
+    Table *m_table;
+    size_t m_column;
+    std::unordered_set<typename ColumnValue::type> m_values;
+    bool m_indexed;
+    std::vector<size_t> m_rows;
+};
+
+// ranges on indexed int and date columns spanning at most this many values are
+// looked up in the search index one value at a time rather than checking each row
+const uint64_t c_maxIndexedRangeSpan = 32;
+
+bool add_indexed_range_constraint_to_query(Query &query, RLMPropertyType type, size_t column,
+                                           int64_t from, int64_t to) {
+    Table *table = query.get_table().get();
+    if (from > to || uint64_t(to) - uint64_t(from) >= c_maxIndexedRangeSpan || !table->has_search_index(column)) {
+        return false;
+    }
+
+    std::unordered_set<int64_t> values;
+    for (int64_t value = from; value <= to; ++value) {
+        values.insert(value);
+    }
+    if (type == RLMPropertyTypeDate) {
+        query.expression(new InExpression<DateColumnValue>(table, column, std::move(values)), true);
+    }
+    else {
+        query.expression(new InExpression<IntColumnValue>(table, column, std::move(values)), true);
+    }
+    return true;
+}
+
+// Set membership test for IN clauses on string columns. Indexed columns look up
+// the rows matching each value in the search index whenever the query is run,
+// and other columns binary search the sorted values for each row's value.
+class StringInExpression : public tightdb::Expression {
+public:
+    StringInExpression(Table *table, size_t column, std::vector<std::string> values)
+    : m_table(table), m_column(column), m_values(std::move(values))
+    , m_indexed(table->has_search_index(column))
+    {
+        std::sort(m_values.begin(), m_values.end());
+        m_values.erase(std::unique(m_values.begin(), m_values.end()), m_values.end());
+    }
+
+    size_t find_first(size_t start, size_t end) const override {
+        if (m_indexed) {
+            auto it = std::lower_bound(m_rows.begin(), m_rows.end(), start);
+            return it != m_rows.end() && *it < end ? *it : tightdb::not_found;
+        }
+
+        for (; start < end; ++start) {
+            StringData value = m_table->get_string(m_column, start);
+            auto it = std::lower_bound(m_values.begin(), m_values.end(), value,
+                                       [](std::string const& a, StringData b) { return StringData(a) < b; });
+            if (it != m_values.end() && StringData(*it) == value) {
+                return start;
+            }
+        }
+        return tightdb::not_found;
+    }
+
+    // called each time the query is run, so the rows found via the index
+    // reflect the current contents of the table
+    void set_table() override {
+        if (!m_indexed) {
+            return;
+        }
+
+        m_rows.clear();
+        for (auto const& value : m_values) {
+            TableView matches = m_table->find_all_string(m_column, StringData(value));
+            for (size_t i = 0; i < matches.size(); ++i) {
+                m_rows.push_back(matches.get_source_ndx(i));
+            }
+        }
+        std::sort(m_rows.begin(), m_rows.end());
+    }
+
+    const Table* get_table() override { return m_table; }
+
+private:
+    Table *m_table;
+    size_t m_column;
+    std::vector<std::string> m_values;
+    bool m_indexed;
+    std::vector<size_t> m_rows;
+};
+
+template<typename ColumnValue>
+void add_numeric_in_constraint_to_query(Query &query, NSUInteger column, std::vector<id> const& values) {
+    std::unordered_set<typename ColumnValue::type> set;
+    set.reserve(values.size());
+    for (id value : values) {
+        set.insert(ColumnValue::from(value));
+    }
+    query.expression(new InExpression<ColumnValue>(query.get_table().get(), column, std::move(set)), true);
+}
+
+// add a set membership test for the values of an IN clause, returning false
+// if the property can't use one and the values should instead be compared
+// one at a time
+bool add_in_constraint_to_query(Query &query, RLMPropertyType type, NSComparisonPredicateOptions options,
+                                std::vector<NSUInteger> const& linkColumns, NSUInteger column,
+                                std::vector<id> const& values)
+{
+    if (!linkColumns.empty()) {
+        return false;
+    }
+
+    switch (type) {
+        case type_Int:
+            add_numeric_in_constraint_to_query<IntColumnValue>(query, column, values);
+            return true;
+        case type_DateTime:
+            add_numeric_in_constraint_to_query<DateColumnValue>(query, column, values);
+            return true;
+        case type_Float:
+            add_numeric_in_constraint_to_query<FloatColumnValue>(query, column, values);
+            return true;
+        case type_Double:
+            add_numeric_in_constraint_to_query<DoubleColumnValue>(query, column, values);
+            return true;
+        case type_String: {
+            if (options & (NSCaseInsensitivePredicateOption | NSDiacriticInsensitivePredicateOption)) {
+                return false;
+            }
+            std::vector<std::string> strings;
+            strings.reserve(values.size());
+            for (NSString *value : values) {
+                StringData sd = RLMStringDataWithNSString(value);
+                strings.emplace_back(sd.data(), sd.size());
+            }
+            query.expression(new StringInExpression(query.get_table().get(), column, std::move(strings)), true);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Matches the objects whose full-text indexed property contains every term of
+// a MATCHES pattern, where each term is a sequence of words which have to
+// appear consecutively. A word ending in '*' matches any word it is a prefix of.
+// The matching rows are looked up in the property's index table each time the
+// query is run, as with StringInExpression.
+class FullTextExpression : public tightdb::Expression {
+public:
+    FullTextExpression(Table *table, TableRef index, std::vector<std::vector<std::string>> terms)
+    : m_table(table), m_index(std::move(index)), m_terms(std::move(terms))
+    {
+    }
+
+    size_t find_first(size_t start, size_t end) const override {
+        auto it = std::lower_bound(m_rows.begin(), m_rows.end(), start);
+        return it != m_rows.end() && *it < end ? *it : tightdb::not_found;
+    }
+
+    void set_table() override {
+        m_rows.clear();
+        for (size_t i = 0; i < m_terms.size(); ++i) {
+            std::vector<size_t> rows = rows_matching(m_terms[i]);
+            if (i == 0) {
+                m_rows = std::move(rows);
+            }
+            else {
+                std::vector<size_t> both;
+                std::set_intersection(m_rows.begin(), m_rows.end(), rows.begin(), rows.end(),
+                                      std::back_inserter(both));
+                m_rows = std::move(both);
+            }
+            if (m_rows.empty()) {
+                return;
+            }
+        }
+    }
+
+    const Table* get_table() override { return m_table; }
+
+private:
+    typedef std::pair<size_t, int64_t> Posting; // object row and word position
+
+    // the sorted postings for a word, skipping those of deleted objects
+    std::vector<Posting> postings(std::string const& word) const {
+        Query query = m_index->where();
+        if (word.back() == '*') {
+            query.begins_with(c_fullTextIndexTokenColumnIndex, StringData(word.data(), word.size() - 1));
+        }
+        else {
+            query.equal(c_fullTextIndexTokenColumnIndex, StringData(word));
+        }
+
+        TableView matches = query.find_all();
+        std::vector<Posting> postings;
+        postings.reserve(matches.size());
+        for (size_t i = 0; i < matches.size(); ++i) {
+            size_t row = matches.get_source_ndx(i);
+            if (!m_index->is_null_link(c_fullTextIndexObjectColumnIndex, row)) {
+                postings.emplace_back(m_index->get_link(c_fullTextIndexObjectColumnIndex, row),
+                                      m_index->get_int(c_fullTextIndexPositionColumnIndex, row));
+            }
+        }
+        std::sort(postings.begin(), postings.end());
+        return postings;
+    }
+
+    std::vector<size_t> rows_matching(std::vector<std::string> const& term) const {
+        // positions at which the term could start, narrowed by each later word
+        std::vector<Posting> starts = postings(term[0]);
+        for (size_t i = 1; i < term.size() && !starts.empty(); ++i) {
+            std::vector<Posting> next = postings(term[i]);
+            auto end = std::remove_if(starts.begin(), starts.end(), [&](Posting const& start) {
+                return !std::binary_search(next.begin(), next.end(), Posting(start.first, start.second + int64_t(i)));
+            });
+            starts.erase(end, starts.end());
+        }
+
+        std::vector<size_t> rows;
+        for (auto const& start : starts) {
+            if (rows.empty() || rows.back() != start.first) {
+                rows.push_back(start.first);
+            }
+        }
+        return rows;
+    }
+
+    Table *m_table;
+    TableRef m_index;
+    std::vector<std::vector<std::string>> m_terms;
+    std::vector<size_t> m_rows;
+};
+
+// the index table with the given name in the group holding the query's table.
+// The group is never taken from the realm of the object schema the predicate
+// was compiled with, as prepared predicates are applied to queries built by
+// other realms, including on other threads.
+TableRef index_table_for_query(Query &query, NSString *name) {
+    return query.get_table()->get_parent_group()->get_table(name.UTF8String);
+}
+
+// split a MATCHES pattern into terms: quoted phrases, and words outside of
+// quotes, folded the same way as the indexed strings
+std::vector<std::vector<std::string>> full_text_terms(NSString *pattern) {
+    std::vector<std::vector<std::string>> terms;
+    auto add_term = [&](NSString *text, bool prefix) {
+        std::vector<std::string> words;
+        for (NSString *token in RLMFullTextTokens(text)) {
+            words.emplace_back(token.UTF8String);
+        }
+        if (words.empty()) {
+            return;
+        }
+        if (prefix) {
+            words.back() += '*';
+        }
+        terms.push_back(std::move(words));
+    };
+
+    NSArray *parts = [pattern componentsSeparatedByString:@"\""];
+    for (NSUInteger i = 0; i < parts.count; ++i) {
+        if (i % 2) {
+            add_term(parts[i], false);
+            continue;
+        }
+        for (NSString *word in [parts[i] componentsSeparatedByCharactersInSet:NSCharacterSet.whitespaceAndNewlineCharacterSet]) {
+            add_term(word, [word hasSuffix:@"*"]);
+        }
+    }
+    return terms;
+}
+
+void add_full_text_constraint_to_query(Query &query, RLMObjectSchema *objectSchema, RLMProperty *prop, NSString *pattern) {
+    std::vector<std::vector<std::string>> terms = full_text_terms(pattern);
+    RLMPrecondition(!terms.empty(), @"Invalid value", @"MATCHES pattern '%@' contains no words", pattern);
+
+    TableRef index = index_table_for_query(query, RLMFullTextIndexTableName(objectSchema.className, prop.name));
+    query.expression(new FullTextExpression(query.get_table().get(), index, std::move(terms)), true);
+}
+
+void add_constraint_to_query(tightdb::Query &query, RLMPropertyType type,
+                             NSPredicateOperatorType operatorType,
+                             NSComparisonPredicateOptions predicateOptions,
+                             std::vector<NSUInteger> linkColumns, NSUInteger idx, id value)
+{
+    tightdb::Table *(^table)() = ^{
+        tightdb::TableRef& tbl = query.get_table();
+        for (NSUInteger col : linkColumns) {
+            tbl->link(col); // mutates m_link_chain on table
+        }
+        return tbl.get();
+    };
+
+    switch (type) {
+        case type_Bool:
+            add_bool_constraint_to_query(query, operatorType, table()->column<bool>(idx), bool([value boolValue]));
+            break;
+        case type_DateTime:
+        case type_Double:
+        case type_Float:
+        case type_Int:
+            if (!linkColumns.empty()) {
+                // compare the values with column conditions on the last table
+                // of the chain and join the matches back to this table
+                add_link_chain_constraint_to_query(query, linkColumns, [&](Query &target) {
+                    add_constraint_to_query(target, type, operatorType, predicateOptions, {}, idx, value);
+                });
+            }
+            else if (type == type_DateTime) {
+                add_datetime_constraint_to_query(query, operatorType, idx, DateTime(time_t([value timeIntervalSince1970])));
+            }
+            else if (type == type_Double) {
+                add_numeric_constraint_to_query(query, type, operatorType, idx, double([value doubleValue]));
+            }
+            else if (type == type_Float) {
+                add_numeric_constraint_to_query(query, type, operatorType, idx, float([value floatValue]));
+            }
+            else {
+                add_numeric_constraint_to_query(query, type, operatorType, idx, int64_t([value longLongValue]));
+            }
+            break;
+        case type_String:
+            if (predicateOptions & (NSCaseInsensitivePredicateOption | NSDiacriticInsensitivePredicateOption)) {
+                add_folded_string_constraint_to_query(query, operatorType, predicateOptions, linkColumns, idx, value);
+            }
+            else {
+                add_string_constraint_to_query(query, operatorType, predicateOptions, table()->column<String>(idx), value);
+            }
+            break;
+        case type_Binary:
+            if (linkColumns.empty()) {
+                add_binary_constraint_to_query(query, operatorType, idx, value);
+            }
+            else {
+                add_link_chain_constraint_to_query(query, linkColumns, [&](Query &target) {
+                    add_binary_constraint_to_query(target, operatorType, idx, value);
+                });
+            }
+            break;
+        case type_Link:
+        case type_LinkList:
+            if (linkColumns.empty()) {
+                add_link_constraint_to_query(query, operatorType, idx, value);
+            }
+            else {
+                add_link_chain_link_constraint_to_query(query, operatorType, linkColumns, idx, value);
+            }
+            break;
+        default:
+            @throw RLMPredicateException(@"Unsupported predicate value type",
+                                         @"Object type %@ not supported", RLMTypeToString(type));
+    }
+}
+
+// Matches the objects whose values for the properties of a compound index
+// equal the values encoded in a key, and which optionally also satisfy bounds
+// on the index's last property. As with FullTextExpression, the matching rows
+// are looked up in the index table each time the query is run.
+class CompoundIndexExpression : public tightdb::Expression {
+public:
+    typedef std::pair<NSPredicateOperatorType, id> Bound;
+
+    CompoundIndexExpression(Table *table, TableRef index, std::string key,
+                            RLMPropertyType valueType, std::vector<Bound> bounds)
+    : m_table(table), m_index(std::move(index)), m_key(std::move(key))
+    , m_valueType(valueType), m_bounds(std::move(bounds))
+    {
+    }
+
+    size_t find_first(size_t start, size_t end) const override {
+        auto it = std::lower_bound(m_rows.begin(), m_rows.end(), start);
+        return it != m_rows.end() && *it < end ? *it : tightdb::not_found;
+    }
+
+    void set_table() override {
+        Query query = m_index->where();
+        query.equal(c_compoundIndexKeyColumnIndex, StringData(m_key));
+        for (auto const& bound : m_bounds) {
+            add_constraint_to_query(query, m_valueType, bound.first, 0, {}, c_compoundIndexValueColumnIndex, bound.second);
+        }
+
+        TableView matches = query.find_all();
+        m_rows.clear();
+        m_rows.reserve(matches.size());
+        for (size_t i = 0; i < matches.size(); ++i) {
+            size_t row = matches.get_source_ndx(i);
+            if (!m_index->is_null_link(c_compoundIndexObjectColumnIndex, row)) {
+                m_rows.push_back(m_index->get_link(c_compoundIndexObjectColumnIndex, row));
+            }
+        }
+        std::sort(m_rows.begin(), m_rows.end());
+    }
+
+    const Table* get_table() override { return m_table; }
+
+private:
+    Table *m_table;
+    TableRef m_index;
+    std::string m_key;
+    RLMPropertyType m_valueType;
+    std::vector<Bound> m_bounds;
+    std::vector<size_t> m_rows;
+};
+
+// Matches the objects whose value for an ordered indexed property lies within
+// bounds, found by binary searching the property's index table for the ends
+// of the range rather than checking each row. As with FullTextExpression, the
+// matching rows are looked up in the index each time the query is run.
+class OrderedIndexExpression : public tightdb::Expression {
+public:
+    typedef std::pair<NSPredicateOperatorType, id> Bound;
+
+    OrderedIndexExpression(Table *table, TableRef index, RLMPropertyType type, std::vector<Bound> bounds)
+    : m_table(table), m_index(std::move(index)), m_type(type), m_bounds(std::move(bounds))
+    {
+    }
+
+    size_t find_first(size_t start, size_t end) const override {
+        auto it = std::lower_bound(m_rows.begin(), m_rows.end(), start);
+        return it != m_rows.end() && *it < end ? *it : tightdb::not_found;
+    }
+
+    void set_table() override {
+        size_t begin = 0, end = m_index->size();
+        for (auto const& bound : m_bounds) {
+            bool lower = bound.first == NSGreaterThanPredicateOperatorType
+                      || bound.first == NSGreaterThanOrEqualToPredicateOperatorType;
+            bool upper = bound.first == NSGreaterThanPredicateOperatorType
+                      || bound.first == NSLessThanOrEqualToPredicateOperatorType;
+            size_t position = RLMOrderedIndexBound(m_index->size(), [&](size_t posting) {
+                return compare(posting, bound.second);
+            }, upper);
+            if (lower) {
+                begin = std::max(begin, position);
+            }
+            else {
+                end = std::min(end, position);
+            }
+        }
+
+        m_rows.clear();
+        for (size_t posting = begin; posting < end; ++posting) {
+            if (!m_index->is_null_link(c_orderedIndexObjectColumnIndex, posting)) {
+                m_rows.push_back(m_index->get_link(c_orderedIndexObjectColumnIndex, posting));
+            }
+        }
+        std::sort(m_rows.begin(), m_rows.end());
+    }
+
+    const Table* get_table() override { return m_table; }
+
+private:
+    template<typename T>
+    static int compare_values(T const& a, T const& b) {
+        return a < b ? -1 : b < a ? 1 : 0;
+    }
+
+    // compare the value of a row of the index to a bound, converting the bound
+    // the same way as add_constraint_to_query()
+    int compare(size_t posting, id value) const {
+        size_t column = c_orderedIndexValueColumnIndex;
+        switch (m_type) {
+            case type_Int:
+                return compare_values<int64_t>(m_index->get_int(column, posting), [value longLongValue]);
+            case type_Float:
+                return compare_values<float>(m_index->get_float(column, posting), [value floatValue]);
+            case type_Double:
+                return compare_values<double>(m_index->get_double(column, posting), [value doubleValue]);
+            case type_DateTime:
+                return compare_values<int64_t>(m_index->get_datetime(column, posting).get_datetime(),
+                                               Int([value timeIntervalSince1970]));
+            default:
+                TIGHTDB_ASSERT(false); // uses_ordered_index() only allows numeric and date properties
+                return 0;
+        }
+    }
+
+    Table *m_table;
+    TableRef m_index;
+    RLMPropertyType m_type;
+    std::vector<Bound> m_bounds;
+    std::vector<size_t> m_rows;
+};
+
+void add_ordered_index_constraint_to_query(Query &query, RLMObjectSchema *objectSchema, RLMProperty *prop,
+                                           std::vector<OrderedIndexExpression::Bound> bounds) {
+    TableRef index = index_table_for_query(query, RLMOrderedIndexTableName(objectSchema.className, prop.name));
+    query.expression(new OrderedIndexExpression(query.get_table().get(), index, prop.type, std::move(bounds)), true);
+}
+
+RLMProperty *get_property_from_key_path(RLMSchema *schema, RLMObjectSchema *desc,
+                                        NSString *keyPath, std::vector<NSUInteger> &indexes, bool isAny,
+                                        RLMObjectSchema **owner = nullptr)
+{
+    RLMProperty *prop = nil;
+    NSArray *paths = [keyPath componentsSeparatedByString:@"."];
+    indexes.reserve(paths.count - 1);
+
+    // ANY and ALL can apply to an RLMArray property at any level of the key path
+    bool hasArray = false;
+    NSString *prevPath = nil;
+    for (NSString *path in paths) {
+        if (prop) {
+            RLMPrecondition(prop.type == RLMPropertyTypeObject || prop.type == RLMPropertyTypeArray,
+                            @"Invalid value", @"column name '%@' is not a link", prevPath);
+            indexes.push_back(prop.column);
+            prop = desc[path];
+            RLMPrecondition(prop, @"Invalid column name",
+                            @"Column name %@ not found in table", path);
+        }
+        else {
+            prop = desc[path];
+            RLMPrecondition(prop, @"Invalid column name",
+                            @"Column name %@ not found in table", path);
+
+            if (!isAny) {
+                RLMPrecondition(prop.type != RLMPropertyTypeArray,
+                                @"Invalid predicate",
+                                @"RLMArray predicates must contain the ANY modifier");
+            }
+        }
+
+        if (owner) {
+            *owner = desc;
+        }
+        hasArray = hasArray || prop.type == RLMPropertyTypeArray;
+        if (prop.objectClassName) {
+            desc = schema[prop.objectClassName];
+        }
+        prevPath = path;
+    }
+
+    if (isAny) {
+        RLMPrecondition(hasArray, @"Invalid predicate",
+                        @"ANY and ALL modifiers can only be used for key paths which include an RLMArray property");
+    }
+
+    return prop;
+}
+
+void validate_property_value(RLMProperty *prop, id value, NSString *err) {
+    if (prop.type == RLMPropertyTypeArray) {
+        RLMPrecondition([RLMDynamicCast<RLMObject>(value).objectSchema.className isEqualToString:prop.objectClassName],
+                        @"Invalid value", err, prop.objectClassName);
     }
     else {
         RLMPrecondition(RLMIsObjectValidForProperty(value, prop),
@@ -405,227 +1518,1395 @@ void validate_property_value(RLMProperty *prop, id value, NSString *err) {
     }
 }
 
-void update_query_with_value_expression(RLMSchema *schema,
-                                        RLMObjectSchema *desc,
-                                        tightdb::Query &query,
-                                        NSString *keyPath,
-                                        id value,
-                                        NSComparisonPredicate *pred)
+// A predicate which has been validated against an object schema, with all of
+// its key paths resolved to columns and link chains. Comparisons against
+// constants refer to an argument slot rather than holding the value, so one
+// compiled predicate can be applied with any set of values which fit its
+// structure.
+struct CompiledPredicate {
+    enum class Type {
+        And,
+        Or,
+        Not,
+        KeyPathValue,
+        KeyPathKeyPath,
+        // a lower bound and an upper bound on the same column, combined by
+        // plan_predicate() into a single range check
+        Range,
+        // comparisons on the properties of a compound index, combined by
+        // plan_predicate() into a single lookup in the index
+        CompoundIndex,
+        // a comparison of @count, @sum, @min, @max or @avg of an RLMArray
+        // property, or of the number of objects in one which match a SUBQUERY
+        CollectionOperator,
+    };
+
+    Type type;
+    // And, Or, Not: the combined predicates
+    // Range: the KeyPathValue comparisons for the lower and upper bounds
+    // CompoundIndex: the equality comparisons on each property of the index
+    // but the last, in index order, optionally followed by an equality
+    // comparison, a bound or a Range on the last one
+    // CollectionOperator: the SUBQUERY's predicate, if any
+    std::vector<CompiledPredicate> subpredicates;
+
+    NSPredicateOperatorType operatorType;
+    NSComparisonPredicateOptions options;
+    NSComparisonPredicateModifier modifier;
+
+    // KeyPathValue and KeyPathKeyPath: the key paths compared, for describing
+    // the predicate
+    NSString *keyPath;
+    NSString *rightKeyPath;
+
+    // KeyPathValue: the property compared, the links followed to reach it,
+    // and the index of the argument holding the value to compare against
+    // MATCHES, comparisons using an ordered index and CompoundIndex also need
+    // the object schema to find the index table. For ALL comparisons it is
+    // the schema of the objects which hold the property.
+    RLMProperty *property;
+    __weak RLMObjectSchema *objectSchema;
+
+    // CompoundIndex: the names of the properties of the index
+    NSArray *indexProperties;
+    std::vector<NSUInteger> linkColumns;
+    size_t argument;
+
+    // KeyPathKeyPath: the two columns compared and their types, which
+    // compile_column_comparison() checks are the same
+    NSUInteger leftColumn;
+    NSUInteger rightColumn;
+    RLMPropertyType columnType;
+    RLMPropertyType rightColumnType;
+
+    // CollectionOperator: the aggregate computed over the RLMArray in
+    // property, and the property of the linked objects it's computed from
+    // (nil for @count). objectSchema is the schema of the linked objects.
+    LinkListAggregateExpression::Aggregate aggregate;
+    RLMProperty *aggregateProperty;
+};
+
+void compile_value_comparison(CompiledPredicate &compiled, RLMSchema *schema, RLMObjectSchema *desc,
+                              NSString *keyPath, NSComparisonPredicate *pred, size_t argument)
 {
+    bool isAll = pred.comparisonPredicateModifier == NSAllPredicateModifier;
     bool isAny = pred.comparisonPredicateModifier == NSAnyPredicateModifier;
-    std::vector<NSUInteger> indexes;
-    RLMProperty *prop = get_property_from_key_path(schema, desc, keyPath, indexes, isAny);
+    RLMObjectSchema *owner = desc;
+    compiled.type = CompiledPredicate::Type::KeyPathValue;
+    compiled.keyPath = keyPath;
+    compiled.property = get_property_from_key_path(schema, desc, keyPath, compiled.linkColumns, isAny || isAll, &owner);
+    compiled.argument = argument;
+    compiled.objectSchema = isAll ? owner : desc;
+
+    if (isAll) {
+        RLMPrecondition(compiled.property.type != RLMPropertyTypeArray, @"Invalid predicate",
+                        @"ALL modifier must compare a property of the objects in an RLMArray, not '%@'", keyPath);
+    }
+
+    if (pred.predicateOperatorType == NSMatchesPredicateOperatorType) {
+        RLMPrecondition(compiled.property.fullTextIndexed && compiled.linkColumns.empty(), @"Invalid operator type",
+                        @"MATCHES is only supported for full-text indexed string properties of the queried object, not '%@'", keyPath);
+    }
+}
+
+// whether a comparison or range looks up its matches in an ordered index
+// rather than checking each row
+bool uses_ordered_index(CompiledPredicate const& compiled) {
+    if (compiled.type == CompiledPredicate::Type::Range) {
+        return uses_ordered_index(compiled.subpredicates[0]);
+    }
+    if (compiled.type != CompiledPredicate::Type::KeyPathValue
+        || !compiled.linkColumns.empty()
+        || !compiled.property.orderedIndexed) {
+        return false;
+    }
+    switch (compiled.property.type) {
+        case RLMPropertyTypeInt:
+        case RLMPropertyTypeFloat:
+        case RLMPropertyTypeDouble:
+        case RLMPropertyTypeDate:
+            break;
+        default:
+            return false;
+    }
+    switch (compiled.operatorType) {
+        case NSLessThanPredicateOperatorType:
+        case NSLessThanOrEqualToPredicateOperatorType:
+        case NSGreaterThanPredicateOperatorType:
+        case NSGreaterThanOrEqualToPredicateOperatorType:
+        case NSBetweenPredicateOperatorType:
+            return true;
+        default:
+            return false;
+    }
+}
 
+void apply_value_comparison(CompiledPredicate const& compiled, tightdb::Query &query, id value)
+{
+    RLMProperty *prop = compiled.property;
     NSUInteger index = prop.column;
 
+    if (compiled.modifier == NSAllPredicateModifier) {
+        // compare the objects at the end of the key path as if they were queried directly
+        CompiledPredicate element = compiled;
+        element.modifier = NSDirectPredicateModifier;
+        element.linkColumns.clear();
+        add_all_constraint_to_query(query, compiled.linkColumns, [&](Query &elementQuery) {
+            apply_value_comparison(element, elementQuery, value);
+        });
+        return;
+    }
+
+    if (uses_ordered_index(compiled)) {
+        std::vector<OrderedIndexExpression::Bound> bounds;
+        if (compiled.operatorType == NSBetweenPredicateOperatorType) {
+            id from, to;
+            validate_and_extract_between_range(value, prop, &from, &to);
+            bounds.emplace_back(NSGreaterThanOrEqualToPredicateOperatorType, from);
+            bounds.emplace_back(NSLessThanOrEqualToPredicateOperatorType, to);
+        }
+        else {
+            validate_property_value(prop, value, @"object must be of type %@");
+            bounds.emplace_back(compiled.operatorType, value);
+        }
+        add_ordered_index_constraint_to_query(query, compiled.objectSchema, prop, std::move(bounds));
+        return;
+    }
+
     // check to see if this is a between query
-    if (pred.predicateOperatorType == NSBetweenPredicateOperatorType) {
-        add_between_constraint_to_query(query, indexes, prop, value);
+    if (compiled.operatorType == NSBetweenPredicateOperatorType) {
+        add_between_constraint_to_query(query, compiled.linkColumns, prop, value);
+        return;
+    }
+
+    if (compiled.operatorType == NSMatchesPredicateOperatorType) {
+        validate_property_value(prop, value, @"MATCHES pattern must be of type %@");
+        add_full_text_constraint_to_query(query, compiled.objectSchema, prop, value);
         return;
     }
 
-    // turn IN into ored together ==
-    if (pred.predicateOperatorType == NSInPredicateOperatorType) {
-        process_or_group(query, value, [&](id item) {
+    if (compiled.operatorType == NSInPredicateOperatorType) {
+        RLMPrecondition([value conformsToProtocol:@protocol(NSFastEnumeration)],
+                        @"Invalid value", @"IN clause requires an array of items");
+
+        std::vector<id> values;
+        for (id item in value) {
             id normalized = value_from_constant_expression_or_value(item);
             validate_property_value(prop, normalized, @"Object in IN clause must be of type %@");
-            add_constraint_to_query(query, prop.type, NSEqualToPredicateOperatorType,
-                                    pred.options, indexes, index, normalized);
+            values.push_back(normalized);
+        }
+
+        if (add_in_constraint_to_query(query, prop.type, compiled.options, compiled.linkColumns, index, values)) {
+            return;
+        }
+
+        // otherwise turn IN into ored together ==
+        process_or_group(query, [&](auto&& next) {
+            for (id item : values) {
+                next();
+                add_constraint_to_query(query, prop.type, NSEqualToPredicateOperatorType,
+                                        compiled.options, compiled.linkColumns, index, item);
+            }
         });
         return;
     }
 
-    validate_property_value(prop, value, @"object must be of type %@");
-    add_constraint_to_query(query, prop.type, pred.predicateOperatorType,
-                            pred.options, indexes, index, value);
-}
+    validate_property_value(prop, value, @"object must be of type %@");
+    add_constraint_to_query(query, prop.type, compiled.operatorType,
+                            compiled.options, compiled.linkColumns, index, value);
+}
+
+template<typename T>
+Query column_expression(NSComparisonPredicateOptions operatorType,
+                                            NSUInteger leftColumn,
+                                            NSUInteger rightColumn,
+                                            Table *table) {
+    switch (operatorType) {
+        case NSEqualToPredicateOperatorType:
+            return table->column<T>(leftColumn) == table->column<T>(rightColumn);
+        case NSNotEqualToPredicateOperatorType:
+            return table->column<T>(leftColumn) != table->column<T>(rightColumn);
+        case NSLessThanPredicateOperatorType:
+            return table->column<T>(leftColumn) < table->column<T>(rightColumn);
+        case NSGreaterThanPredicateOperatorType:
+            return table->column<T>(leftColumn) > table->column<T>(rightColumn);
+        case NSLessThanOrEqualToPredicateOperatorType:
+            return table->column<T>(leftColumn) <= table->column<T>(rightColumn);
+        case NSGreaterThanOrEqualToPredicateOperatorType:
+            return table->column<T>(leftColumn) >= table->column<T>(rightColumn);
+        default:
+            @throw RLMPredicateException(@"Unsupported operator", @"Only ==, !=, <, <=, >, and >= are supported comparison operators");
+    }
+}
+
+// Core's conditions comparing two numeric columns of each row, which compare
+// the columns a leaf at a time rather than evaluating an expression per row.
+typedef Query& (Query::*TwoColumnCondition)(size_t, size_t);
+
+TwoColumnCondition two_column_condition(NSPredicateOperatorType operatorType,
+                                        TwoColumnCondition equal, TwoColumnCondition notEqual,
+                                        TwoColumnCondition less, TwoColumnCondition lessEqual,
+                                        TwoColumnCondition greater, TwoColumnCondition greaterEqual) {
+    switch (operatorType) {
+        case NSEqualToPredicateOperatorType:
+            return equal;
+        case NSNotEqualToPredicateOperatorType:
+            return notEqual;
+        case NSLessThanPredicateOperatorType:
+            return less;
+        case NSGreaterThanPredicateOperatorType:
+            return greater;
+        case NSLessThanOrEqualToPredicateOperatorType:
+            return lessEqual;
+        case NSGreaterThanOrEqualToPredicateOperatorType:
+            return greaterEqual;
+        default:
+            @throw RLMPredicateException(@"Unsupported operator", @"Only ==, !=, <, <=, >, and >= are supported comparison operators");
+    }
+}
+
+void compile_column_comparison(CompiledPredicate &compiled, RLMObjectSchema *scheme,
+                               NSString *leftColumnName, NSString *rightColumnName)
+{
+    // Validate object types
+    NSUInteger leftIndex = RLMValidatedColumnIndex(scheme, leftColumnName);
+    RLMPropertyType leftType = [scheme[leftColumnName] type];
+    RLMPrecondition(leftType != RLMPropertyTypeArray, @"Invalid predicate",
+                    @"RLMArray predicates must contain the ANY modifier");
+
+    NSUInteger rightIndex = RLMValidatedColumnIndex(scheme, rightColumnName);
+    RLMPropertyType rightType = [scheme[rightColumnName] type];
+    RLMPrecondition(rightType != RLMPropertyTypeArray, @"Invalid predicate",
+                    @"RLMArray predicates must contain the ANY modifier");
+
+    // NOTE: It's assumed that column type must match and no automatic type conversion is supported.
+    RLMPrecondition(leftType == rightType,
+                    RLMPropertiesComparisonTypeMismatchException,
+                    RLMPropertiesComparisonTypeMismatchReason,
+                    RLMTypeToString(leftType),
+                    RLMTypeToString(rightType));
+
+    compiled.type = CompiledPredicate::Type::KeyPathKeyPath;
+    compiled.keyPath = leftColumnName;
+    compiled.rightKeyPath = rightColumnName;
+    compiled.leftColumn = leftIndex;
+    compiled.rightColumn = rightIndex;
+    compiled.columnType = leftType;
+    compiled.rightColumnType = rightType;
+}
+
+void apply_column_comparison(CompiledPredicate const& compiled, Query &query)
+{
+    // TODO: Should we handle special case where left row is the same as right row (tautology)
+    Table *table = query.get_table().get();
+    NSPredicateOperatorType type = compiled.operatorType;
+    NSUInteger leftIndex = compiled.leftColumn, rightIndex = compiled.rightColumn;
+    switch (compiled.columnType) {
+        case type_Bool:
+            query.and_query(column_expression<Bool>(type, leftIndex, rightIndex, table));
+            break;
+        case type_Int:
+            (query.*two_column_condition(type, &Query::equal_int, &Query::not_equal_int,
+                                         &Query::less_int, &Query::less_equal_int,
+                                         &Query::greater_int, &Query::greater_equal_int))(leftIndex, rightIndex);
+            break;
+        case type_Float:
+            (query.*two_column_condition(type, &Query::equal_float, &Query::not_equal_float,
+                                         &Query::less_float, &Query::less_equal_float,
+                                         &Query::greater_float, &Query::greater_equal_float))(leftIndex, rightIndex);
+            break;
+        case type_Double:
+            (query.*two_column_condition(type, &Query::equal_double, &Query::not_equal_double,
+                                         &Query::less_double, &Query::less_equal_double,
+                                         &Query::greater_double, &Query::greater_equal_double))(leftIndex, rightIndex);
+            break;
+        case type_DateTime:
+            // FIXME: int64_t should be DateTime but that doesn't work on 32 bit
+            // FIXME: as time_t(32bit) != time_t(64bit)
+            query.and_query(column_expression<int64_t>(type, leftIndex, rightIndex, table));
+            break;
+        case type_String: {
+            bool caseSensitive = (compiled.options & NSCaseInsensitivePredicateOption) == 0;
+            switch (type) {
+                case NSBeginsWithPredicateOperatorType:
+                    query.and_query(table->column<String>(leftIndex).begins_with(table->column<String>(rightIndex), caseSensitive));
+                    break;
+                case NSEndsWithPredicateOperatorType:
+                    query.and_query(table->column<String>(leftIndex).ends_with(table->column<String>(rightIndex), caseSensitive));
+                    break;
+                case NSContainsPredicateOperatorType:
+                    query.and_query(table->column<String>(leftIndex).contains(table->column<String>(rightIndex), caseSensitive));
+                    break;
+                case NSEqualToPredicateOperatorType:
+                    query.and_query(table->column<String>(leftIndex).equal(table->column<String>(rightIndex), caseSensitive));
+                    break;
+                case NSNotEqualToPredicateOperatorType:
+                    query.and_query(table->column<String>(leftIndex).not_equal(table->column<String>(rightIndex), caseSensitive));
+                    break;
+                default:
+                    @throw RLMPredicateException(@"Invalid operator type",
+                                                 @"Operator type %lu not supported for string type", (unsigned long)type);
+            }
+            break;
+        }
+        default:
+            @throw RLMPredicateException(RLMUnsupportedTypesFoundInPropertyComparisonException,
+                                         RLMUnsupportedTypesFoundInPropertyComparisonReason,
+                                         RLMTypeToString(compiled.columnType),
+                                         RLMTypeToString(compiled.rightColumnType));
+    }
+}
+
+CompiledPredicate compile_predicate(NSPredicate *predicate, RLMSchema *schema,
+                                    RLMObjectSchema *objectSchema, size_t &argumentCount);
+void apply_predicate(CompiledPredicate const& compiled, tightdb::Query &query, std::vector<id> const& arguments);
+
+LinkListAggregateExpression::Aggregate collection_operator_aggregate(NSString *name) {
+    if ([name isEqualToString:@"@count"]) {
+        return LinkListAggregateExpression::Aggregate::Count;
+    }
+    if ([name isEqualToString:@"@sum"]) {
+        return LinkListAggregateExpression::Aggregate::Sum;
+    }
+    if ([name isEqualToString:@"@min"]) {
+        return LinkListAggregateExpression::Aggregate::Min;
+    }
+    if ([name isEqualToString:@"@max"]) {
+        return LinkListAggregateExpression::Aggregate::Max;
+    }
+    if ([name isEqualToString:@"@avg"]) {
+        return LinkListAggregateExpression::Aggregate::Average;
+    }
+    @throw RLMPredicateException(@"Invalid predicate", @"Unsupported collection operator '%@'", name);
+}
+
+void validate_collection_operator_comparison(NSComparisonPredicate *pred) {
+    RLMPrecondition(pred.comparisonPredicateModifier == NSDirectPredicateModifier, @"Invalid predicate",
+                    @"Collection operators and SUBQUERY can't be used with the ANY or ALL modifiers");
+    switch (pred.predicateOperatorType) {
+        case NSEqualToPredicateOperatorType:
+        case NSNotEqualToPredicateOperatorType:
+        case NSLessThanPredicateOperatorType:
+        case NSLessThanOrEqualToPredicateOperatorType:
+        case NSGreaterThanPredicateOperatorType:
+        case NSGreaterThanOrEqualToPredicateOperatorType:
+        case NSBetweenPredicateOperatorType:
+            break;
+        default:
+            @throw RLMPredicateException(@"Invalid operator type",
+                                         @"Only ==, !=, <, <=, >, >= and BETWEEN are supported for collection operators");
+    }
+}
+
+// compile a comparison of a key path of the form `array.@count` or
+// `array.@sum.property` (or @min, @max or @avg) with a value
+void compile_collection_operator_comparison(CompiledPredicate &compiled, RLMSchema *schema, RLMObjectSchema *desc,
+                                            NSString *keyPath, NSComparisonPredicate *pred, size_t argument)
+{
+    validate_collection_operator_comparison(pred);
+
+    NSArray *paths = [keyPath componentsSeparatedByString:@"."];
+    RLMPrecondition(paths.count >= 2 && [paths[1] hasPrefix:@"@"], @"Invalid predicate",
+                    @"Collection operators must be applied to an RLMArray property of the queried object, not '%@'", keyPath);
+    RLMProperty *prop = desc[paths[0]];
+    RLMPrecondition(prop, @"Invalid column name", @"Column name %@ not found in table", paths[0]);
+    RLMPrecondition(prop.type == RLMPropertyTypeArray, @"Invalid predicate",
+                    @"Collection operators can only be applied to RLMArray properties, not '%@'", paths[0]);
+
+    compiled.type = CompiledPredicate::Type::CollectionOperator;
+    compiled.keyPath = keyPath;
+    compiled.property = prop;
+    compiled.objectSchema = schema[prop.objectClassName];
+    compiled.aggregate = collection_operator_aggregate(paths[1]);
+    compiled.aggregateProperty = nil;
+    compiled.argument = argument;
+
+    if (compiled.aggregate == LinkListAggregateExpression::Aggregate::Count) {
+        RLMPrecondition(paths.count == 2, @"Invalid predicate",
+                        @"@count must be the last component of the key path '%@'", keyPath);
+        return;
+    }
+
+    RLMPrecondition(paths.count == 3, @"Invalid predicate",
+                    @"%@ must be followed by the name of a property of the objects in the RLMArray in '%@'",
+                    paths[1], keyPath);
+    RLMProperty *aggregateProp = compiled.objectSchema[paths[2]];
+    RLMPrecondition(aggregateProp, @"Invalid column name", @"Column name %@ not found in table", paths[2]);
+    bool isMinMax = compiled.aggregate == LinkListAggregateExpression::Aggregate::Min
+                 || compiled.aggregate == LinkListAggregateExpression::Aggregate::Max;
+    bool isNumeric = aggregateProp.type == RLMPropertyTypeInt
+                  || aggregateProp.type == RLMPropertyTypeFloat
+                  || aggregateProp.type == RLMPropertyTypeDouble;
+    RLMPrecondition(isNumeric || (isMinMax && aggregateProp.type == RLMPropertyTypeDate), @"Invalid predicate",
+                    @"%@ is not supported for %@ property '%@'", paths[1], RLMTypeToString(aggregateProp.type), paths[2]);
+    compiled.aggregateProperty = aggregateProp;
+}
+
+// whether an expression is SUBQUERY(...).@count, which NSPredicate parses as
+// valueForKeyPath: applied to the subquery expression
+bool is_subquery_count(NSExpression *exp) {
+    if (exp.expressionType != NSFunctionExpressionType
+        || ![exp.function isEqualToString:@"valueForKeyPath:"]
+        || exp.operand.expressionType != NSSubqueryExpressionType
+        || exp.arguments.count != 1) {
+        return false;
+    }
+    NSExpression *path = exp.arguments.firstObject;
+    return (path.expressionType == NSKeyPathExpressionType && [path.keyPath isEqualToString:@"@count"])
+        || (path.expressionType == NSConstantValueExpressionType && [path.constantValue isEqual:@"@count"]);
+}
+
+// Rewrite the expressions of a SUBQUERY's predicate which refer to properties
+// of the subquery's variable (`$item.price`) to plain key paths, so that the
+// predicate can be compiled against the linked objects' schema like any other
+NSExpression *subquery_expression(NSExpression *exp, NSString *variable) {
+    if (exp.expressionType == NSFunctionExpressionType
+        && [exp.function isEqualToString:@"valueForKeyPath:"]
+        && exp.operand.expressionType == NSVariableExpressionType
+        && [exp.operand.variable isEqualToString:variable]
+        && exp.arguments.count == 1) {
+        NSExpression *path = exp.arguments.firstObject;
+        if (path.expressionType == NSKeyPathExpressionType) {
+            return [NSExpression expressionForKeyPath:path.keyPath];
+        }
+        if (path.expressionType == NSConstantValueExpressionType && [path.constantValue isKindOfClass:NSString.class]) {
+            return [NSExpression expressionForKeyPath:path.constantValue];
+        }
+    }
+    RLMPrecondition(exp.expressionType != NSVariableExpressionType || ![exp.variable isEqualToString:variable],
+                    @"Invalid predicate",
+                    @"SUBQUERY predicates must compare properties of $%@ rather than the objects themselves", variable);
+    return exp;
+}
+
+NSPredicate *subquery_predicate(NSPredicate *predicate, NSString *variable) {
+    if ([predicate isMemberOfClass:[NSCompoundPredicate class]]) {
+        NSCompoundPredicate *comp = (NSCompoundPredicate *)predicate;
+        NSMutableArray *subpredicates = [NSMutableArray arrayWithCapacity:comp.subpredicates.count];
+        for (NSPredicate *subp in comp.subpredicates) {
+            [subpredicates addObject:subquery_predicate(subp, variable)];
+        }
+        return [[NSCompoundPredicate alloc] initWithType:comp.compoundPredicateType subpredicates:subpredicates];
+    }
+    if ([predicate isMemberOfClass:[NSComparisonPredicate class]]) {
+        NSComparisonPredicate *compp = (NSComparisonPredicate *)predicate;
+        return [NSComparisonPredicate predicateWithLeftExpression:subquery_expression(compp.leftExpression, variable)
+                                                  rightExpression:subquery_expression(compp.rightExpression, variable)
+                                                         modifier:compp.comparisonPredicateModifier
+                                                             type:compp.predicateOperatorType
+                                                          options:compp.options];
+    }
+    return predicate;
+}
+
+NSPredicate *subquery_predicate(NSExpression *subquery) {
+    return subquery_predicate(subquery.predicate, subquery.variable);
+}
+
+// compile a comparison of the number of objects in an RLMArray which match a
+// SUBQUERY with a value. The SUBQUERY's predicate is compiled against the
+// schema of the linked objects, and its values take the argument slots before
+// the one for the value the count is compared with.
+void compile_subquery_count_comparison(CompiledPredicate &compiled, RLMSchema *schema, RLMObjectSchema *desc,
+                                       NSExpression *exp, NSComparisonPredicate *pred, size_t &argumentCount)
+{
+    validate_collection_operator_comparison(pred);
+
+    NSExpression *subquery = exp.operand;
+    NSExpression *collection = RLMDynamicCast<NSExpression>(subquery.collection);
+    RLMPrecondition(collection.expressionType == NSKeyPathExpressionType, @"Invalid predicate",
+                    @"SUBQUERY must be applied to an RLMArray property of the queried object");
+    RLMProperty *prop = desc[collection.keyPath];
+    RLMPrecondition(prop, @"Invalid column name", @"Column name %@ not found in table", collection.keyPath);
+    RLMPrecondition(prop.type == RLMPropertyTypeArray, @"Invalid predicate",
+                    @"SUBQUERY can only be applied to RLMArray properties, not '%@'", collection.keyPath);
+
+    compiled.type = CompiledPredicate::Type::CollectionOperator;
+    compiled.keyPath = [NSString stringWithFormat:@"SUBQUERY(%@).@count", collection.keyPath];
+    compiled.property = prop;
+    compiled.objectSchema = schema[prop.objectClassName];
+    compiled.aggregate = LinkListAggregateExpression::Aggregate::Count;
+    compiled.aggregateProperty = nil;
+    compiled.subpredicates.push_back(compile_predicate(subquery_predicate(subquery), schema,
+                                                       compiled.objectSchema, argumentCount));
+    compiled.argument = argumentCount++;
+}
+
+void compile_key_path_comparison(CompiledPredicate &compiled, RLMSchema *schema, RLMObjectSchema *desc,
+                                 NSString *keyPath, NSComparisonPredicate *pred, size_t argument)
+{
+    if ([keyPath rangeOfString:@"@"].location != NSNotFound) {
+        compile_collection_operator_comparison(compiled, schema, desc, keyPath, pred, argument);
+    }
+    else {
+        compile_value_comparison(compiled, schema, desc, keyPath, pred, argument);
+    }
+}
+
+void apply_collection_operator_comparison(CompiledPredicate const& compiled, Query &query,
+                                          std::vector<id> const& arguments)
+{
+    // @min and @max of a date property are compared with dates, and
+    // everything else with numbers
+    bool isDate = compiled.aggregateProperty.type == RLMPropertyTypeDate;
+    auto bound_value = [&](id value) -> double {
+        value = value_from_constant_expression_or_value(value);
+        if (isDate) {
+            RLMPrecondition([value isKindOfClass:NSDate.class], @"Invalid value",
+                            @"%@ must be compared with a date", compiled.keyPath);
+            return Int([value timeIntervalSince1970]);
+        }
+        RLMPrecondition([value isKindOfClass:NSNumber.class], @"Invalid value",
+                        @"%@ must be compared with a number", compiled.keyPath);
+        return [value doubleValue];
+    };
+
+    id value = arguments[compiled.argument];
+    std::vector<LinkListAggregateExpression::Bound> bounds;
+    if (compiled.operatorType == NSBetweenPredicateOperatorType) {
+        NSArray *array = RLMDynamicCast<NSArray>(value);
+        RLMPrecondition(array.count == 2, @"Invalid value",
+                        @"BETWEEN operations require an NSArray containing exactly two objects");
+        bounds.emplace_back(NSGreaterThanOrEqualToPredicateOperatorType, bound_value(array.firstObject));
+        bounds.emplace_back(NSLessThanOrEqualToPredicateOperatorType, bound_value(array.lastObject));
+    }
+    else {
+        bounds.emplace_back(compiled.operatorType, bound_value(value));
+    }
+
+    std::unique_ptr<Query> filter;
+    if (!compiled.subpredicates.empty()) {
+        TableRef target = query.get_table()->get_link_target(compiled.property.column);
+        filter.reset(new Query(target->where()));
+        apply_predicate(compiled.subpredicates.front(), *filter, arguments);
+    }
+
+    size_t targetColumn = compiled.aggregateProperty ? compiled.aggregateProperty.column : tightdb::not_found;
+    query.expression(new LinkListAggregateExpression(query.get_table().get(), compiled.property.column,
+                                                     compiled.aggregate, targetColumn,
+                                                     std::move(bounds), std::move(filter)), true);
+}
+
+CompiledPredicate compile_predicate(NSPredicate *predicate, RLMSchema *schema,
+                                    RLMObjectSchema *objectSchema, size_t &argumentCount)
+{
+    CompiledPredicate compiled;
+
+    // Compound predicates.
+    if ([predicate isMemberOfClass:[NSCompoundPredicate class]]) {
+        NSCompoundPredicate *comp = (NSCompoundPredicate *)predicate;
+
+        switch ([comp compoundPredicateType]) {
+            case NSAndPredicateType:
+                compiled.type = CompiledPredicate::Type::And;
+                for (NSPredicate *subp in comp.subpredicates) {
+                    compiled.subpredicates.push_back(compile_predicate(subp, schema, objectSchema, argumentCount));
+                }
+                break;
+
+            case NSOrPredicateType:
+                compiled.type = CompiledPredicate::Type::Or;
+                for (NSPredicate *subp in comp.subpredicates) {
+                    compiled.subpredicates.push_back(compile_predicate(subp, schema, objectSchema, argumentCount));
+                }
+                break;
+
+            case NSNotPredicateType:
+                compiled.type = CompiledPredicate::Type::Not;
+                compiled.subpredicates.push_back(compile_predicate(comp.subpredicates.firstObject, schema,
+                                                                   objectSchema, argumentCount));
+                break;
+
+            default:
+                @throw RLMPredicateException(@"Invalid compound predicate type",
+                                             @"Only support AND, OR and NOT predicate types");
+        }
+    }
+    else if ([predicate isMemberOfClass:[NSComparisonPredicate class]]) {
+        NSComparisonPredicate *compp = (NSComparisonPredicate *)predicate;
+
+        NSExpressionType exp1Type = compp.leftExpression.expressionType;
+        NSExpressionType exp2Type = compp.rightExpression.expressionType;
+
+        // the placeholders of prepared predicates are filled in with a value
+        // each time the predicate is applied
+        if (exp1Type == NSVariableExpressionType) {
+            exp1Type = NSConstantValueExpressionType;
+        }
+        if (exp2Type == NSVariableExpressionType) {
+            exp2Type = NSConstantValueExpressionType;
+        }
+
+        // SUBQUERY(...).@count is compared with a value like a key path
+        bool isSubqueryCount = exp1Type == NSFunctionExpressionType && is_subquery_count(compp.leftExpression);
+
+        if (compp.comparisonPredicateModifier == NSAnyPredicateModifier
+            || compp.comparisonPredicateModifier == NSAllPredicateModifier) {
+            // for ANY and ALL queries
+            RLMPrecondition(exp1Type == NSKeyPathExpressionType && exp2Type == NSConstantValueExpressionType,
+                            @"Invalid predicate",
+                            @"Predicate with %s modifier must compare a KeyPath with RLMArray with a value",
+                            compp.comparisonPredicateModifier == NSAnyPredicateModifier ? "ANY" : "ALL");
+        }
+
+        if (compp.predicateOperatorType == NSBetweenPredicateOperatorType || compp.predicateOperatorType == NSInPredicateOperatorType) {
+            // Inserting an array via %@ gives NSConstantValueExpressionType, but
+            // including it directly gives NSAggregateExpressionType
+            if ((exp1Type != NSKeyPathExpressionType && !isSubqueryCount) || (exp2Type != NSAggregateExpressionType && exp2Type != NSConstantValueExpressionType)) {
+                @throw RLMPredicateException(@"Invalid predicate",
+                                             @"Predicate with %s operator must compare a KeyPath with an aggregate with two values",
+                                             compp.predicateOperatorType == NSBetweenPredicateOperatorType ? "BETWEEN" : "IN");
+            }
+            exp2Type = NSConstantValueExpressionType;
+        }
+
+        compiled.operatorType = compp.predicateOperatorType;
+        compiled.options = compp.options;
+        compiled.modifier = compp.comparisonPredicateModifier;
+
+        if (isSubqueryCount && exp2Type == NSConstantValueExpressionType) {
+            compile_subquery_count_comparison(compiled, schema, objectSchema, compp.leftExpression,
+                                              compp, argumentCount);
+        }
+        else if (exp1Type == NSKeyPathExpressionType && exp2Type == NSKeyPathExpressionType) {
+            // both expression are KeyPaths
+            compile_column_comparison(compiled, objectSchema, compp.leftExpression.keyPath,
+                                      compp.rightExpression.keyPath);
+        }
+        else if (exp1Type == NSKeyPathExpressionType && exp2Type == NSConstantValueExpressionType) {
+            // comparing keypath to value
+            compile_key_path_comparison(compiled, schema, objectSchema, compp.leftExpression.keyPath,
+                                        compp, argumentCount++);
+        }
+        else if (exp1Type == NSConstantValueExpressionType && exp2Type == NSKeyPathExpressionType) {
+            // comparing value to keypath
+            compile_key_path_comparison(compiled, schema, objectSchema, compp.rightExpression.keyPath,
+                                        compp, argumentCount++);
+        }
+        else {
+            @throw RLMPredicateException(@"Invalid predicate expressions",
+                                         @"Predicate expressions must compare a keypath and another keypath or a constant value");
+        }
+    }
+    else {
+        // invalid predicate type
+        @throw RLMPredicateException(@"Invalid predicate",
+                                     @"Only support compound and comparison predicates");
+    }
+
+    return compiled;
+}
+
+// Adjust a bound of a range to the equivalent inclusive bound, returning false
+// if there is no such value
+bool inclusive_bound(int64_t &value, NSPredicateOperatorType operatorType) {
+    if (operatorType == NSGreaterThanPredicateOperatorType) {
+        if (value == std::numeric_limits<int64_t>::max()) {
+            return false;
+        }
+        ++value;
+    }
+    else if (operatorType == NSLessThanPredicateOperatorType) {
+        if (value == std::numeric_limits<int64_t>::min()) {
+            return false;
+        }
+        --value;
+    }
+    return true;
+}
+
+template<typename Float>
+bool inclusive_bound(Float &value, NSPredicateOperatorType operatorType) {
+    if (operatorType == NSGreaterThanPredicateOperatorType) {
+        value = std::nextafter(value, std::numeric_limits<Float>::infinity());
+    }
+    else if (operatorType == NSLessThanPredicateOperatorType) {
+        value = std::nextafter(value, -std::numeric_limits<Float>::infinity());
+    }
+    return true;
+}
+
+template<typename T>
+bool add_range_constraint_to_query(Query &query, size_t column, CompiledPredicate const& lower, T from,
+                                   CompiledPredicate const& upper, T to) {
+    if (!inclusive_bound(from, lower.operatorType) || !inclusive_bound(to, upper.operatorType)) {
+        return false;
+    }
+    query.between(column, from, to);
+    return true;
+}
+
+void apply_range_comparison(CompiledPredicate const& compiled, Query &query, std::vector<id> const& arguments)
+{
+    CompiledPredicate const& lower = compiled.subpredicates[0];
+    CompiledPredicate const& upper = compiled.subpredicates[1];
+    RLMProperty *prop = lower.property;
+    id from = arguments[lower.argument], to = arguments[upper.argument];
+    validate_property_value(prop, from, @"object must be of type %@");
+    validate_property_value(prop, to, @"object must be of type %@");
+
+    if (uses_ordered_index(compiled)) {
+        add_ordered_index_constraint_to_query(query, lower.objectSchema, prop,
+                                              {{lower.operatorType, from}, {upper.operatorType, to}});
+        return;
+    }
+
+    bool added = false;
+    switch (prop.type) {
+        case type_Int: {
+            int64_t fromInt = [from longLongValue];
+            int64_t toInt = [to longLongValue];
+            if (inclusive_bound(fromInt, lower.operatorType) && inclusive_bound(toInt, upper.operatorType)) {
+                if (!add_indexed_range_constraint_to_query(query, prop.type, prop.column, fromInt, toInt)) {
+                    query.between(prop.column, fromInt, toInt);
+                }
+                added = true;
+            }
+            break;
+        }
+        case type_Float:
+            added = add_range_constraint_to_query<float>(query, prop.column, lower, [from floatValue],
+                                                         upper, [to floatValue]);
+            break;
+        case type_Double:
+            added = add_range_constraint_to_query<double>(query, prop.column, lower, [from doubleValue],
+                                                          upper, [to doubleValue]);
+            break;
+        case type_DateTime: {
+            // dates are compared at the resolution at which they're stored
+            int64_t fromSeconds = int64_t([from timeIntervalSince1970]);
+            int64_t toSeconds = int64_t([to timeIntervalSince1970]);
+            if (inclusive_bound(fromSeconds, lower.operatorType) && inclusive_bound(toSeconds, upper.operatorType)) {
+                if (!add_indexed_range_constraint_to_query(query, prop.type, prop.column, fromSeconds, toSeconds)) {
+                    query.between_datetime(prop.column, time_t(fromSeconds), time_t(toSeconds));
+                }
+                added = true;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (!added) {
+        // a strict bound at the limit of the type, so just add both comparisons
+        apply_value_comparison(lower, query, from);
+        apply_value_comparison(upper, query, to);
+    }
+}
+
+void apply_compound_index_comparison(CompiledPredicate const& compiled, Query &query, std::vector<id> const& arguments)
+{
+    RLMObjectSchema *objectSchema = compiled.objectSchema;
+    NSArray *propertyNames = compiled.indexProperties;
+
+    std::string key;
+    std::vector<CompoundIndexExpression::Bound> bounds;
+    for (size_t i = 0; i < compiled.subpredicates.size(); ++i) {
+        CompiledPredicate const& subp = compiled.subpredicates[i];
+        if (subp.type == CompiledPredicate::Type::Range) {
+            for (auto const& bound : subp.subpredicates) {
+                id value = arguments[bound.argument];
+                validate_property_value(bound.property, value, @"object must be of type %@");
+                bounds.emplace_back(bound.operatorType, value);
+            }
+            continue;
+        }
+
+        id value = arguments[subp.argument];
+        validate_property_value(subp.property, value, @"object must be of type %@");
+        if (i + 1 == propertyNames.count) {
+            bounds.emplace_back(subp.operatorType, value);
+            continue;
+        }
+        switch (subp.property.type) {
+            case RLMPropertyTypeString:
+                RLMAppendCompoundIndexKey(key, RLMStringDataWithNSString(value));
+                break;
+            case RLMPropertyTypeDate:
+                // dates are compared at the resolution at which they're stored
+                RLMAppendCompoundIndexKey(key, int64_t([value timeIntervalSince1970]));
+                break;
+            default:
+                RLMAppendCompoundIndexKey(key, int64_t([value longLongValue]));
+                break;
+        }
+    }
+
+    TableRef index = index_table_for_query(query, RLMCompoundIndexTableName(objectSchema.className, propertyNames));
+    query.expression(new CompoundIndexExpression(query.get_table().get(), index, std::move(key),
+                                                 objectSchema[propertyNames.lastObject].type, std::move(bounds)), true);
+}
+
+// whether the predicate looks up its matches in a search index rather than
+// checking each row
+bool uses_search_index(CompiledPredicate const& compiled) {
+    if (compiled.type == CompiledPredicate::Type::KeyPathValue
+        && compiled.operatorType == NSMatchesPredicateOperatorType) {
+        // MATCHES is always answered from the full-text index
+        return true;
+    }
+    if (compiled.type != CompiledPredicate::Type::KeyPathValue
+        || !compiled.linkColumns.empty()
+        || !compiled.property.indexed
+        || (compiled.operatorType != NSEqualToPredicateOperatorType
+            && compiled.operatorType != NSInPredicateOperatorType)) {
+        return false;
+    }
+    switch (compiled.property.type) {
+        case RLMPropertyTypeString:
+            return !(compiled.options & (NSCaseInsensitivePredicateOption | NSDiacriticInsensitivePredicateOption));
+        case RLMPropertyTypeInt:
+        case RLMPropertyTypeDate:
+            return true;
+        default:
+            // bool equality is evaluated as an expression over the column,
+            // and bool IN as an OR group of them, so neither reads the index
+            return false;
+    }
+}
+
+// The relative cost of evaluating a predicate for a row, used to decide the
+// order in which ANDed predicates are added to the query. Core starts
+// evaluating each group with the condition which was added first, so putting
+// the cheap and selective conditions first means the more expensive ones are
+// evaluated for fewer rows.
+int estimated_cost(CompiledPredicate const& compiled) {
+    switch (compiled.type) {
+        case CompiledPredicate::Type::KeyPathValue: {
+            RLMProperty *prop = compiled.property;
+            bool isEquality = compiled.operatorType == NSEqualToPredicateOperatorType
+                           || compiled.operatorType == NSInPredicateOperatorType;
+            bool isString = prop.type == RLMPropertyTypeString;
+            int cost = 0;
+            if (!compiled.linkColumns.empty()) {
+                // following links requires looking up the row in the target table
+                cost += 40;
+            }
+            if (uses_search_index(compiled) || uses_ordered_index(compiled)) {
+                return cost;
+            }
+            if (isEquality) {
+                return cost + (isString ? 15 : 10);
+            }
+            if (isString || prop.type == RLMPropertyTypeData) {
+                // substring searches and non-equality string comparisons
+                return cost + ((compiled.options & NSCaseInsensitivePredicateOption) ? 35 : 30);
+            }
+            return cost + 20;
+        }
+        case CompiledPredicate::Type::Range:
+            return uses_ordered_index(compiled) ? 0 : 15;
+        case CompiledPredicate::Type::CompoundIndex:
+            return 0;
+        case CompiledPredicate::Type::CollectionOperator:
+            // counts are stored with the link list, but anything else has to
+            // read each of the linked objects
+            if (compiled.subpredicates.empty() && compiled.aggregate == LinkListAggregateExpression::Aggregate::Count) {
+                return 25;
+            }
+            return 60;
+        case CompiledPredicate::Type::KeyPathKeyPath:
+            return 50;
+        case CompiledPredicate::Type::Not:
+            return estimated_cost(compiled.subpredicates.front()) + 1;
+        case CompiledPredicate::Type::And: {
+            // an AND group is rejected as soon as its cheapest condition fails
+            int cost = std::numeric_limits<int>::max();
+            for (auto const& subp : compiled.subpredicates) {
+                cost = std::min(cost, estimated_cost(subp));
+            }
+            return cost + 5;
+        }
+        case CompiledPredicate::Type::Or: {
+            // every branch of an OR group has to be checked for rows which don't match
+            int cost = 0;
+            for (auto const& subp : compiled.subpredicates) {
+                cost += estimated_cost(subp);
+            }
+            return cost + 5;
+        }
+    }
+}
+
+bool is_range_bound(CompiledPredicate const& compiled, bool lower) {
+    if (compiled.type != CompiledPredicate::Type::KeyPathValue || !compiled.linkColumns.empty()) {
+        return false;
+    }
+    switch (compiled.property.type) {
+        case RLMPropertyTypeInt:
+        case RLMPropertyTypeFloat:
+        case RLMPropertyTypeDouble:
+        case RLMPropertyTypeDate:
+            break;
+        default:
+            return false;
+    }
+    if (lower) {
+        return compiled.operatorType == NSGreaterThanPredicateOperatorType
+            || compiled.operatorType == NSGreaterThanOrEqualToPredicateOperatorType;
+    }
+    return compiled.operatorType == NSLessThanPredicateOperatorType
+        || compiled.operatorType == NSLessThanOrEqualToPredicateOperatorType;
+}
+
+// whether a condition of an AND group can be answered by a compound index
+// which includes the property named, either as one of the properties whose
+// values make up the index's key, or as its last property
+bool is_compound_index_condition(CompiledPredicate const& compiled, NSString *propertyName, bool inKey) {
+    if (compiled.type == CompiledPredicate::Type::Range) {
+        return !inKey && [compiled.subpredicates[0].property.name isEqualToString:propertyName];
+    }
+    if (compiled.type != CompiledPredicate::Type::KeyPathValue
+        || !compiled.linkColumns.empty()
+        || ![compiled.property.name isEqualToString:propertyName]) {
+        return false;
+    }
+    if (compiled.operatorType == NSEqualToPredicateOperatorType) {
+        return !(compiled.options & (NSCaseInsensitivePredicateOption | NSDiacriticInsensitivePredicateOption));
+    }
+    return !inKey && (is_range_bound(compiled, true) || is_range_bound(compiled, false));
+}
+
+// Replace the conditions of an AND group which can be answered by one of the
+// object's compound indexes with a single lookup in the index. An index is
+// used when there is an equality condition on each of its properties but the
+// last, and it then also answers an equality condition, a bound or a range on
+// the last property if there is one.
+void use_compound_index(std::vector<CompiledPredicate> &conditions, RLMObjectSchema *objectSchema) {
+    for (NSArray *propertyNames in objectSchema.compoundIndexes) {
+        std::vector<size_t> used;
+        for (NSUInteger i = 0; i < propertyNames.count; ++i) {
+            bool inKey = i + 1 < propertyNames.count;
+            auto it = std::find_if(conditions.begin(), conditions.end(), [&](auto const& condition) {
+                return is_compound_index_condition(condition, propertyNames[i], inKey);
+            });
+            if (it == conditions.end()) {
+                break;
+            }
+            used.push_back(it - conditions.begin());
+        }
+        if (used.size() + 1 < propertyNames.count) {
+            continue;
+        }
+
+        CompiledPredicate index;
+        index.type = CompiledPredicate::Type::CompoundIndex;
+        index.objectSchema = objectSchema;
+        index.indexProperties = propertyNames;
+        for (size_t i : used) {
+            index.subpredicates.push_back(std::move(conditions[i]));
+        }
+        std::sort(used.begin(), used.end(), std::greater<size_t>());
+        for (size_t i : used) {
+            conditions.erase(conditions.begin() + i);
+        }
+        conditions.push_back(std::move(index));
+        return;
+    }
+}
+
+// Rewrite a compiled predicate into an equivalent one which is cheaper to
+// evaluate: nested AND groups are flattened, pairs of lower and upper bounds on
+// the same column become a single range check, conditions covered by a
+// compound index become a single lookup in the index, and the conditions of
+// each AND group are sorted by their estimated cost. Conditions with the same
+// cost keep the order they were written in.
+void plan_predicate(CompiledPredicate &compiled, RLMObjectSchema *objectSchema) {
+    // a SUBQUERY's predicate is evaluated against the linked objects
+    RLMObjectSchema *subpredicateSchema = compiled.type == CompiledPredicate::Type::CollectionOperator
+                                        ? compiled.objectSchema : objectSchema;
+    for (auto &subp : compiled.subpredicates) {
+        plan_predicate(subp, subpredicateSchema);
+    }
+
+    if (compiled.type != CompiledPredicate::Type::And) {
+        return;
+    }
+
+    std::vector<CompiledPredicate> conditions;
+    for (auto &subp : compiled.subpredicates) {
+        if (subp.type == CompiledPredicate::Type::And) {
+            std::move(subp.subpredicates.begin(), subp.subpredicates.end(), std::back_inserter(conditions));
+        }
+        else {
+            conditions.push_back(std::move(subp));
+        }
+    }
+
+    for (size_t i = 0; i < conditions.size(); ++i) {
+        bool lower = is_range_bound(conditions[i], true);
+        if (!lower && !is_range_bound(conditions[i], false)) {
+            continue;
+        }
+        for (size_t j = i + 1; j < conditions.size(); ++j) {
+            if (is_range_bound(conditions[j], !lower) && conditions[j].property == conditions[i].property) {
+                CompiledPredicate range;
+                range.type = CompiledPredicate::Type::Range;
+                range.subpredicates.push_back(std::move(conditions[lower ? i : j]));
+                range.subpredicates.push_back(std::move(conditions[lower ? j : i]));
+                conditions[i] = std::move(range);
+                conditions.erase(conditions.begin() + j);
+                break;
+            }
+        }
+    }
+
+    use_compound_index(conditions, objectSchema);
 
-template<typename T>
-Query column_expression(NSComparisonPredicateOptions operatorType,
-                                            NSUInteger leftColumn,
-                                            NSUInteger rightColumn,
-                                            Table *table) {
-    switch (operatorType) {
-        case NSEqualToPredicateOperatorType:
-            return table->column<T>(leftColumn) == table->column<T>(rightColumn);
-        case NSNotEqualToPredicateOperatorType:
-            return table->column<T>(leftColumn) != table->column<T>(rightColumn);
-        case NSLessThanPredicateOperatorType:
-            return table->column<T>(leftColumn) < table->column<T>(rightColumn);
-        case NSGreaterThanPredicateOperatorType:
-            return table->column<T>(leftColumn) > table->column<T>(rightColumn);
-        case NSLessThanOrEqualToPredicateOperatorType:
-            return table->column<T>(leftColumn) <= table->column<T>(rightColumn);
-        case NSGreaterThanOrEqualToPredicateOperatorType:
-            return table->column<T>(leftColumn) >= table->column<T>(rightColumn);
-        default:
-            @throw RLMPredicateException(@"Unsupported operator", @"Only ==, !=, <, <=, >, and >= are supported comparison operators");
-    }
+    std::stable_sort(conditions.begin(), conditions.end(), [](auto const& a, auto const& b) {
+        return estimated_cost(a) < estimated_cost(b);
+    });
+    compiled.subpredicates = std::move(conditions);
 }
 
-void update_query_with_column_expression(RLMObjectSchema *scheme, Query &query,
-                                         NSString *leftColumnName, NSString *rightColumnName,
-                                         NSComparisonPredicate *predicate)
+void apply_predicate(CompiledPredicate const& compiled, tightdb::Query &query, std::vector<id> const& arguments)
 {
-    // Validate object types
-    NSUInteger leftIndex = RLMValidatedColumnIndex(scheme, leftColumnName);
-    RLMPropertyType leftType = [scheme[leftColumnName] type];
-    RLMPrecondition(leftType != RLMPropertyTypeArray, @"Invalid predicate",
-                    @"RLMArray predicates must contain the ANY modifier");
+    switch (compiled.type) {
+        case CompiledPredicate::Type::And:
+            // Add all of the subpredicates.
+            query.group();
+            for (auto const& subp : compiled.subpredicates) {
+                apply_predicate(subp, query, arguments);
+            }
+            query.end_group();
+            break;
 
-    NSUInteger rightIndex = RLMValidatedColumnIndex(scheme, rightColumnName);
-    RLMPropertyType rightType = [scheme[rightColumnName] type];
-    RLMPrecondition(rightType != RLMPropertyTypeArray, @"Invalid predicate",
-                    @"RLMArray predicates must contain the ANY modifier");
+        case CompiledPredicate::Type::Or:
+            // Add all of the subpredicates with ors inbetween.
+            process_or_group(query, [&](auto&& next) {
+                for (auto const& subp : compiled.subpredicates) {
+                    next();
+                    apply_predicate(subp, query, arguments);
+                }
+            });
+            break;
 
-    // NOTE: It's assumed that column type must match and no automatic type conversion is supported.
-    RLMPrecondition(leftType == rightType,
-                    RLMPropertiesComparisonTypeMismatchException,
-                    RLMPropertiesComparisonTypeMismatchReason,
-                    RLMTypeToString(leftType),
-                    RLMTypeToString(rightType));
+        case CompiledPredicate::Type::Not:
+            // Add the negated subpredicate
+            query.Not();
+            apply_predicate(compiled.subpredicates.front(), query, arguments);
+            break;
 
-    // TODO: Should we handle special case where left row is the same as right row (tautology)
-    Table *table = query.get_table().get();
-    NSPredicateOperatorType type = predicate.predicateOperatorType;
-    switch (leftType) {
-        case type_Bool:
-            query.and_query(column_expression<Bool>(type, leftIndex, rightIndex, table));
+        case CompiledPredicate::Type::KeyPathValue:
+            apply_value_comparison(compiled, query, arguments[compiled.argument]);
             break;
-        case type_Int:
-            query.and_query(column_expression<Int>(type, leftIndex, rightIndex, table));
+
+        case CompiledPredicate::Type::KeyPathKeyPath:
+            apply_column_comparison(compiled, query);
             break;
-        case type_Float:
-            query.and_query(column_expression<Float>(type, leftIndex, rightIndex, table));
+
+        case CompiledPredicate::Type::Range:
+            apply_range_comparison(compiled, query, arguments);
             break;
-        case type_Double:
-            query.and_query(column_expression<Double>(type, leftIndex, rightIndex, table));
+
+        case CompiledPredicate::Type::CompoundIndex:
+            apply_compound_index_comparison(compiled, query, arguments);
             break;
-        case type_DateTime:
-            // FIXME: int64_t should be DateTime but that doesn't work on 32 bit
-            // FIXME: as time_t(32bit) != time_t(64bit)
-            query.and_query(column_expression<int64_t>(type, leftIndex, rightIndex, table));
+
+        case CompiledPredicate::Type::CollectionOperator:
+            apply_collection_operator_comparison(compiled, query, arguments);
             break;
-        case type_String: {
-            bool caseSensitive = (predicate.options & NSCaseInsensitivePredicateOption) == 0;
-            switch (type) {
-                case NSBeginsWithPredicateOperatorType:
-                    query.and_query(table->column<String>(leftIndex).begins_with(table->column<String>(rightIndex), caseSensitive));
-                    break;
-                case NSEndsWithPredicateOperatorType:
-                    query.and_query(table->column<String>(leftIndex).ends_with(table->column<String>(rightIndex), caseSensitive));
-                    break;
-                case NSContainsPredicateOperatorType:
-                    query.and_query(table->column<String>(leftIndex).contains(table->column<String>(rightIndex), caseSensitive));
-                    break;
-                case NSEqualToPredicateOperatorType:
-                    query.and_query(table->column<String>(leftIndex).equal(table->column<String>(rightIndex), caseSensitive));
-                    break;
-                case NSNotEqualToPredicateOperatorType:
-                    query.and_query(table->column<String>(leftIndex).not_equal(table->column<String>(rightIndex), caseSensitive));
-                    break;
-                default:
-                    @throw RLMPredicateException(@"Invalid operator type",
-                                                 @"Operator type %lu not supported for string type", (unsigned long)type);
+    }
+}
+
+void append_predicate_key(NSPredicate *predicate, NSMutableString *key, std::vector<id> &arguments);
+
+void append_expression_key(NSExpression *exp, NSMutableString *key, std::vector<id> &arguments) {
+    switch (exp.expressionType) {
+        case NSKeyPathExpressionType:
+            [key appendFormat:@",%@", exp.keyPath];
+            break;
+        case NSConstantValueExpressionType:
+        case NSAggregateExpressionType:
+            [key appendString:@",?"];
+            arguments.push_back(exp.constantValue);
+            break;
+        case NSVariableExpressionType:
+            [key appendString:@",?"];
+            arguments.push_back(exp);
+            break;
+        case NSFunctionExpressionType:
+            if (is_subquery_count(exp)) {
+                // the values in the SUBQUERY's predicate are arguments too
+                NSExpression *collection = RLMDynamicCast<NSExpression>(exp.operand.collection);
+                [key appendFormat:@",SUBQUERY(%@", collection.expressionType == NSKeyPathExpressionType ? collection.keyPath : @"#"];
+                append_predicate_key(subquery_predicate(exp.operand), key, arguments);
+                [key appendString:@").@count"];
+                break;
             }
+            [key appendFormat:@",#%lu", (unsigned long)exp.expressionType];
             break;
-        }
         default:
-            @throw RLMPredicateException(RLMUnsupportedTypesFoundInPropertyComparisonException,
-                                         RLMUnsupportedTypesFoundInPropertyComparisonReason,
-                                         RLMTypeToString(leftType),
-                                         RLMTypeToString(rightType));
+            [key appendFormat:@",#%lu", (unsigned long)exp.expressionType];
+            break;
     }
 }
 
-void update_query_with_predicate(NSPredicate *predicate, RLMSchema *schema,
-                                 RLMObjectSchema *objectSchema, tightdb::Query & query)
-{
-    // Compound predicates.
+// Append a description of the structure of a predicate to key, and the
+// constant values it compares against to arguments, in the order in which
+// compile_predicate() assigns argument slots. Predicates which produce the same
+// key compile to the same CompiledPredicate for a given object schema.
+void append_predicate_key(NSPredicate *predicate, NSMutableString *key, std::vector<id> &arguments) {
     if ([predicate isMemberOfClass:[NSCompoundPredicate class]]) {
         NSCompoundPredicate *comp = (NSCompoundPredicate *)predicate;
-
-        switch ([comp compoundPredicateType]) {
-            case NSAndPredicateType:
-                // Add all of the subpredicates.
-                query.group();
-                for (NSPredicate *subp in comp.subpredicates) {
-                    update_query_with_predicate(subp, schema, objectSchema, query);
-                }
-                query.end_group();
-                break;
-
-            case NSOrPredicateType: {
-                // Add all of the subpredicates with ors inbetween.
-                process_or_group(query, comp.subpredicates, [&](NSPredicate *subp) {
-                    update_query_with_predicate(subp, schema, objectSchema, query);
-                });
-                break;
-            }
-
-            case NSNotPredicateType:
-                // Add the negated subpredicate
-                query.Not();
-                update_query_with_predicate(comp.subpredicates.firstObject, schema, objectSchema, query);
-                break;
-
-            default:
-                @throw RLMPredicateException(@"Invalid compound predicate type",
-                                             @"Only support AND, OR and NOT predicate types");
+        [key appendFormat:@"(%lu", (unsigned long)comp.compoundPredicateType];
+        for (NSPredicate *subp in comp.subpredicates) {
+            append_predicate_key(subp, key, arguments);
         }
+        [key appendString:@")"];
     }
     else if ([predicate isMemberOfClass:[NSComparisonPredicate class]]) {
         NSComparisonPredicate *compp = (NSComparisonPredicate *)predicate;
+        [key appendFormat:@"[%lu,%lu,%lu", (unsigned long)compp.comparisonPredicateModifier,
+                          (unsigned long)compp.predicateOperatorType, (unsigned long)compp.options];
+        append_expression_key(compp.leftExpression, key, arguments);
+        append_expression_key(compp.rightExpression, key, arguments);
+        [key appendString:@"]"];
+    }
+    else {
+        [key appendFormat:@"<%@>", NSStringFromClass(predicate.class)];
+    }
+}
 
-        // check modifier
-        RLMPrecondition(compp.comparisonPredicateModifier != NSAllPredicateModifier,
-                        @"Invalid predicate", @"ALL modifier not supported");
+// Placeholders in prepared predicate formats are written as $0, $1, etc., which
+// aren't valid variable names for NSPredicate, so they're renamed to
+// $RLMArgument0 and so on before parsing the format
+NSString * const RLMPlaceholderPrefix = @"RLMArgument";
+
+NSString *predicate_format_with_named_placeholders(NSString *format) {
+    NSUInteger length = format.length;
+    std::vector<unichar> chars(length);
+    [format getCharacters:chars.data() range:NSMakeRange(0, length)];
+
+    NSMutableString *result = [NSMutableString stringWithCapacity:length];
+    NSUInteger copied = 0;
+    unichar quote = 0;
+    for (NSUInteger i = 0; i < length; ++i) {
+        unichar c = chars[i];
+        if (quote) {
+            // skip over the contents of string literals
+            if (c == '\\') {
+                ++i;
+            }
+            else if (c == quote) {
+                quote = 0;
+            }
+        }
+        else if (c == '\'' || c == '"') {
+            quote = c;
+        }
+        else if (c == '$' && i + 1 < length && chars[i + 1] >= '0' && chars[i + 1] <= '9') {
+            [result appendString:[format substringWithRange:NSMakeRange(copied, i + 1 - copied)]];
+            [result appendString:RLMPlaceholderPrefix];
+            copied = i + 1;
+        }
+    }
+    [result appendString:[format substringFromIndex:copied]];
+    return result;
+}
 
-        NSExpressionType exp1Type = compp.leftExpression.expressionType;
-        NSExpressionType exp2Type = compp.rightExpression.expressionType;
+// whether a value from a predicate is a variable expression rather than a constant
+bool is_variable(id value) {
+    return RLMDynamicCast<NSExpression>(value).expressionType == NSVariableExpressionType;
+}
 
-        if (compp.comparisonPredicateModifier == NSAnyPredicateModifier) {
-            // for ANY queries
-            RLMPrecondition(exp1Type == NSKeyPathExpressionType && exp2Type == NSConstantValueExpressionType,
-                            @"Invalid predicate",
-                            @"Predicate with ANY modifier must compare a KeyPath with RLMArray with a value");
-        }
+// return the argument index of a placeholder expression in a prepared
+// predicate, or NSNotFound if the value isn't a variable
+NSUInteger placeholder_index(id value) {
+    if (!is_variable(value)) {
+        return NSNotFound;
+    }
 
-        if (compp.predicateOperatorType == NSBetweenPredicateOperatorType || compp.predicateOperatorType == NSInPredicateOperatorType) {
-            // Inserting an array via %@ gives NSConstantValueExpressionType, but
-            // including it directly gives NSAggregateExpressionType
-            if (exp1Type != NSKeyPathExpressionType || (exp2Type != NSAggregateExpressionType && exp2Type != NSConstantValueExpressionType)) {
-                @throw RLMPredicateException(@"Invalid predicate",
-                                             @"Predicate with %s operator must compare a KeyPath with an aggregate with two values",
-                                             compp.predicateOperatorType == NSBetweenPredicateOperatorType ? "BETWEEN" : "IN");
+    // the index must be all digits, as NSString's integerValue would ignore
+    // anything after them and accept a sign
+    NSString *name = [value variable];
+    NSString *digits = [name hasPrefix:RLMPlaceholderPrefix] ? [name substringFromIndex:RLMPlaceholderPrefix.length] : nil;
+    NSUInteger index = digits.length ? 0 : NSNotFound;
+    for (NSUInteger i = 0; i < digits.length && index != NSNotFound; ++i) {
+        unichar c = [digits characterAtIndex:i];
+        bool valid = c >= '0' && c <= '9' && index <= (NSNotFound - 1 - (c - '0')) / 10;
+        index = valid ? index * 10 + (c - '0') : NSNotFound;
+    }
+    RLMPrecondition(index != NSNotFound, @"Invalid predicate",
+                    @"Prepared query placeholders must be of the form $0, $1, ... but found $%@", digits ?: name);
+    return index;
+}
+
+// replace any placeholders in the value with the corresponding argument,
+// including placeholders within aggregates for IN and BETWEEN
+id bind_placeholders(id value, NSArray *arguments) {
+    NSUInteger index = placeholder_index(value);
+    if (index != NSNotFound) {
+        id argument = arguments[index];
+        return argument == NSNull.null ? nil : argument;
+    }
+
+    if (NSArray *array = RLMDynamicCast<NSArray>(value)) {
+        NSMutableArray *bound;
+        for (NSUInteger i = 0; i < array.count; ++i) {
+            index = placeholder_index(array[i]);
+            if (index == NSNotFound) {
+                continue;
             }
-            exp2Type = NSConstantValueExpressionType;
+            if (!bound) {
+                bound = [array mutableCopy];
+            }
+            bound[i] = arguments[index];
         }
+        return bound ?: array;
+    }
 
-        if (exp1Type == NSKeyPathExpressionType && exp2Type == NSKeyPathExpressionType) {
-            // both expression are KeyPaths
-            update_query_with_column_expression(objectSchema, query, compp.leftExpression.keyPath,
-                                                compp.rightExpression.keyPath, compp);
-        }
-        else if (exp1Type == NSKeyPathExpressionType && exp2Type == NSConstantValueExpressionType) {
-            // comparing keypath to value
-            update_query_with_value_expression(schema, objectSchema, query, compp.leftExpression.keyPath,
-                                               compp.rightExpression.constantValue, compp);
+    return value;
+}
+
+NSString *operator_description(NSPredicateOperatorType operatorType) {
+    switch (operatorType) {
+        case NSLessThanPredicateOperatorType: return @"<";
+        case NSLessThanOrEqualToPredicateOperatorType: return @"<=";
+        case NSGreaterThanPredicateOperatorType: return @">";
+        case NSGreaterThanOrEqualToPredicateOperatorType: return @">=";
+        case NSEqualToPredicateOperatorType: return @"==";
+        case NSNotEqualToPredicateOperatorType: return @"!=";
+        case NSBeginsWithPredicateOperatorType: return @"BEGINSWITH";
+        case NSEndsWithPredicateOperatorType: return @"ENDSWITH";
+        case NSContainsPredicateOperatorType: return @"CONTAINS";
+        case NSInPredicateOperatorType: return @"IN";
+        case NSBetweenPredicateOperatorType: return @"BETWEEN";
+        case NSMatchesPredicateOperatorType: return @"MATCHES";
+        default: return [NSString stringWithFormat:@"<operator %lu>", (unsigned long)operatorType];
+    }
+}
+
+NSString *value_description(id value) {
+    value = value_from_constant_expression_or_value(value);
+    if (!value) {
+        return @"nil";
+    }
+    if (NSString *string = RLMDynamicCast<NSString>(value)) {
+        return [NSString stringWithFormat:@"\"%@\"", string];
+    }
+    if (NSData *data = RLMDynamicCast<NSData>(value)) {
+        return [NSString stringWithFormat:@"<%lu bytes>", (unsigned long)data.length];
+    }
+    if (RLMObject *object = RLMDynamicCast<RLMObject>(value)) {
+        return [NSString stringWithFormat:@"<%@ object>", object.objectSchema.className];
+    }
+    if (NSArray *array = RLMDynamicCast<NSArray>(value)) {
+        // large IN clauses would make the description unreadable
+        const NSUInteger maxValues = 5;
+        if (array.count > maxValues) {
+            return [NSString stringWithFormat:@"{%lu values}", (unsigned long)array.count];
         }
-        else if (exp1Type == NSConstantValueExpressionType && exp2Type == NSKeyPathExpressionType) {
-            // comparing value to keypath
-            update_query_with_value_expression(schema, objectSchema, query, compp.rightExpression.keyPath,
-                                               compp.leftExpression.constantValue, compp);
+        NSMutableArray *values = [NSMutableArray arrayWithCapacity:array.count];
+        for (id item in array) {
+            [values addObject:value_description(item)];
         }
-        else {
-            @throw RLMPredicateException(@"Invalid predicate expressions",
-                                         @"Predicate expressions must compare a keypath and another keypath or a constant value");
+        return [NSString stringWithFormat:@"{%@}", [values componentsJoinedByString:@", "]];
+    }
+    return [value description];
+}
+
+NSString *comparison_description(CompiledPredicate const& compiled, std::vector<id> const& arguments) {
+    NSString *options = @"";
+    if (compiled.options & (NSCaseInsensitivePredicateOption | NSDiacriticInsensitivePredicateOption)) {
+        options = [NSString stringWithFormat:@"[%@%@]",
+                   (compiled.options & NSCaseInsensitivePredicateOption) ? @"c" : @"",
+                   (compiled.options & NSDiacriticInsensitivePredicateOption) ? @"d" : @""];
+    }
+    NSString *rhs = compiled.type == CompiledPredicate::Type::KeyPathKeyPath
+                  ? compiled.rightKeyPath
+                  : value_description(arguments[compiled.argument]);
+    NSString *modifier = compiled.modifier == NSAnyPredicateModifier ? @"ANY "
+                       : compiled.modifier == NSAllPredicateModifier ? @"ALL " : @"";
+    return [NSString stringWithFormat:@"%@%@ %@%@ %@", modifier, compiled.keyPath,
+            operator_description(compiled.operatorType), options, rhs];
+}
+
+NSString *node_description(CompiledPredicate const& compiled, std::vector<id> const& arguments) {
+    switch (compiled.type) {
+        case CompiledPredicate::Type::And:
+            return @"AND";
+        case CompiledPredicate::Type::Or:
+            return @"OR";
+        case CompiledPredicate::Type::Not:
+            return @"NOT";
+        case CompiledPredicate::Type::KeyPathValue:
+            if (uses_search_index(compiled)) {
+                return [comparison_description(compiled, arguments) stringByAppendingString:@" using index"];
+            }
+            if (uses_ordered_index(compiled)) {
+                return [comparison_description(compiled, arguments) stringByAppendingString:@" using ordered index"];
+            }
+            return comparison_description(compiled, arguments);
+        case CompiledPredicate::Type::KeyPathKeyPath:
+        case CompiledPredicate::Type::CollectionOperator:
+            return comparison_description(compiled, arguments);
+        case CompiledPredicate::Type::Range:
+            return [NSString stringWithFormat:@"%@ AND %@ as range%@",
+                    comparison_description(compiled.subpredicates[0], arguments),
+                    comparison_description(compiled.subpredicates[1], arguments),
+                    uses_ordered_index(compiled) ? @" using ordered index" : @""];
+        case CompiledPredicate::Type::CompoundIndex: {
+            NSMutableArray *comparisons = [NSMutableArray array];
+            for (auto const& subp : compiled.subpredicates) {
+                if (subp.type == CompiledPredicate::Type::Range) {
+                    for (auto const& bound : subp.subpredicates) {
+                        [comparisons addObject:comparison_description(bound, arguments)];
+                    }
+                }
+                else {
+                    [comparisons addObject:comparison_description(subp, arguments)];
+                }
+            }
+            return [NSString stringWithFormat:@"%@ using compound index",
+                    [comparisons componentsJoinedByString:@" AND "]];
         }
     }
-    else {
-        // invalid predicate type
-        @throw RLMPredicateException(@"Invalid predicate",
-                                     @"Only support compound and comparison predicates");
+}
+
+size_t count_matching(Query const& base, std::vector<CompiledPredicate const*> const& conditions,
+                      std::vector<id> const& arguments) {
+    Query query(base, Query::TCopyExpressionTag{});
+    for (auto condition : conditions) {
+        apply_predicate(*condition, query, arguments);
+    }
+    return query.count();
+}
+
+// Append a description of each node of the predicate to out, along with the
+// number of rows which reach the node (i.e. match the base query and all of
+// the conditions ANDed before it) and the number of those which it matches.
+void explain_predicate(CompiledPredicate const& compiled, Query const& base,
+                       std::vector<CompiledPredicate const*> &context,
+                       std::vector<id> const& arguments, NSMutableString *out, NSUInteger depth) {
+    size_t scanned = count_matching(base, context, arguments);
+    context.push_back(&compiled);
+    size_t matched = count_matching(base, context, arguments);
+    context.pop_back();
+
+    [out appendFormat:@"%@%@ (scanned %zu, matched %zu)\n",
+                      [@"" stringByPaddingToLength:depth * 2 withString:@" " startingAtIndex:0],
+                      node_description(compiled, arguments), scanned, matched];
+
+    switch (compiled.type) {
+        case CompiledPredicate::Type::And: {
+            size_t contextSize = context.size();
+            for (auto const& subp : compiled.subpredicates) {
+                explain_predicate(subp, base, context, arguments, out, depth + 1);
+                context.push_back(&subp);
+            }
+            context.resize(contextSize);
+            break;
+        }
+        case CompiledPredicate::Type::Or:
+        case CompiledPredicate::Type::Not:
+            for (auto const& subp : compiled.subpredicates) {
+                explain_predicate(subp, base, context, arguments, out, depth + 1);
+            }
+            break;
+        default:
+            break;
     }
 }
 
@@ -652,6 +2933,32 @@ RLMProperty *RLMValidatedPropertyForSort(RLMObjectSchema *schema, NSString *prop
 
 } // namespace
 
+// Apps tend to run a small number of distinct predicates many times with
+// different values, so compiled predicates are cached on the object schema
+// keyed on the structure of the predicate. The limit only exists to bound the
+// memory used by apps which build predicates with varying structure.
+static const NSUInteger RLMCompiledPredicateCacheLimit = 128;
+
+@interface RLMCompiledPredicate : NSObject {
+  @public
+    CompiledPredicate _predicate;
+}
+@end
+
+@implementation RLMCompiledPredicate
+@end
+
+@implementation RLMPreparedPredicate {
+  @public
+    RLMCompiledPredicate *_compiled;
+    NSUInteger _argumentCount;
+
+    // the constant values from the format, or placeholder expressions which
+    // are replaced with the arguments each time the predicate is applied
+    std::vector<id> _values;
+}
+@end
+
 void RLMUpdateQueryWithPredicate(tightdb::Query *query, NSPredicate *predicate, RLMSchema *schema,
                                  RLMObjectSchema *objectSchema)
 {
@@ -663,12 +2970,185 @@ void RLMUpdateQueryWithPredicate(tightdb::Query *query, NSPredicate *predicate,
     RLMPrecondition([predicate isKindOfClass:NSPredicate.class], @"Invalid argument",
                     @"predicate must be an NSPredicate object");
 
-    update_query_with_predicate(predicate, schema, objectSchema, *query);
+    std::vector<id> arguments;
+    NSMutableString *key = [NSMutableString string];
+    append_predicate_key(predicate, key, arguments);
+
+    for (id argument : arguments) {
+        RLMPrecondition(!is_variable(argument), @"Invalid predicate expressions",
+                        @"Predicate expressions must compare a keypath and another keypath or a constant value");
+    }
+
+    // a predicate with the same structure only needs compiling once, but the
+    // query is validated each time as it may hold other conditions
+    NSMutableDictionary *cache = objectSchema.compiledPredicates;
+    RLMCompiledPredicate *compiled = cache[key];
+    bool cached = compiled != nil;
+    if (!cached) {
+        compiled = [[RLMCompiledPredicate alloc] init];
+        size_t argumentCount = 0;
+        compiled->_predicate = compile_predicate(predicate, schema, objectSchema, argumentCount);
+        plan_predicate(compiled->_predicate, objectSchema);
+    }
+    apply_predicate(compiled->_predicate, *query, arguments);
 
     // Test the constructed query in core
     std::string validateMessage = query->validate();
     RLMPrecondition(validateMessage.empty(), @"Invalid query", @"%.*s",
                     (int)validateMessage.size(), validateMessage.c_str());
+
+    if (!cached) {
+        if (cache.count >= RLMCompiledPredicateCacheLimit) {
+            [cache removeAllObjects];
+        }
+        cache[key] = compiled;
+    }
+}
+
+RLMPreparedPredicate *RLMPreparePredicate(NSString *predicateFormat, RLMSchema *schema,
+                                          RLMObjectSchema *objectSchema)
+{
+    RLMPrecondition([predicateFormat isKindOfClass:NSString.class], @"Invalid argument",
+                    @"predicate format must be an NSString");
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:predicate_format_with_named_placeholders(predicateFormat)
+                                                argumentArray:nil];
+
+    RLMPreparedPredicate *prepared = [[RLMPreparedPredicate alloc] init];
+    NSMutableString *key = [NSMutableString string];
+    append_predicate_key(predicate, key, prepared->_values);
+
+    NSUInteger argumentCount = 0;
+    auto count_placeholder = [&](id value) {
+        NSUInteger index = placeholder_index(value);
+        if (index != NSNotFound) {
+            argumentCount = std::max(argumentCount, index + 1);
+        }
+    };
+    for (id value : prepared->_values) {
+        count_placeholder(value);
+        if (NSArray *array = RLMDynamicCast<NSArray>(value)) {
+            for (id item in array) {
+                count_placeholder(item);
+            }
+        }
+    }
+    prepared->_argumentCount = argumentCount;
+
+    // share the compiled form with non-prepared predicates of the same structure
+    prepared->_compiled = objectSchema.compiledPredicates[key];
+    if (!prepared->_compiled) {
+        prepared->_compiled = [[RLMCompiledPredicate alloc] init];
+        size_t slotCount = 0;
+        prepared->_compiled->_predicate = compile_predicate(predicate, schema, objectSchema, slotCount);
+        plan_predicate(prepared->_compiled->_predicate, objectSchema);
+    }
+    return prepared;
+}
+
+void RLMUpdateQueryWithPreparedPredicate(tightdb::Query *query, RLMPreparedPredicate *predicate,
+                                         NSArray *arguments)
+{
+    RLMPrecondition(arguments.count == predicate->_argumentCount, @"Invalid argument count",
+                    @"Prepared query requires %lu arguments but %lu were given",
+                    (unsigned long)predicate->_argumentCount, (unsigned long)arguments.count);
+
+    std::vector<id> values;
+    values.reserve(predicate->_values.size());
+    for (id value : predicate->_values) {
+        values.push_back(bind_placeholders(value, arguments));
+    }
+    apply_predicate(predicate->_compiled->_predicate, *query, values);
+
+    // the query is validated each time as it may hold other conditions
+    std::string validateMessage = query->validate();
+    RLMPrecondition(validateMessage.empty(), @"Invalid query", @"%.*s",
+                    (int)validateMessage.size(), validateMessage.c_str());
+}
+
+void RLMExplainPredicate(NSMutableString *explanation, tightdb::Query &query, NSPredicate *predicate,
+                         RLMSchema *schema, RLMObjectSchema *objectSchema)
+{
+    std::vector<id> arguments;
+    NSMutableString *key = [NSMutableString string];
+    append_predicate_key(predicate, key, arguments);
+
+    // applying the predicate compiles it if it isn't already cached
+    Query base(query, Query::TCopyExpressionTag{});
+    RLMUpdateQueryWithPredicate(&query, predicate, schema, objectSchema);
+    RLMCompiledPredicate *compiled = objectSchema.compiledPredicates[key];
+
+    std::vector<CompiledPredicate const*> context;
+    explain_predicate(compiled->_predicate, base, context, arguments, explanation, 1);
+}
+
+void RLMExplainPreparedPredicate(NSMutableString *explanation, tightdb::Query &query,
+                                 RLMPreparedPredicate *predicate, NSArray *arguments)
+{
+    Query base(query, Query::TCopyExpressionTag{});
+    RLMUpdateQueryWithPreparedPredicate(&query, predicate, arguments);
+
+    std::vector<id> values;
+    for (id value : predicate->_values) {
+        values.push_back(bind_placeholders(value, arguments));
+    }
+    std::vector<CompiledPredicate const*> context;
+    explain_predicate(predicate->_compiled->_predicate, base, context, values, explanation, 1);
+}
+
+static bool RLMExpressionContainsObjects(NSExpression *expression);
+
+// whether a value from a predicate is or contains an RLMObject or collection
+// of them, which can only be read on the thread of their realm
+static bool RLMValueContainsObjects(id value) {
+    if ([value isKindOfClass:[RLMObject class]] || [value conformsToProtocol:@protocol(RLMCollection)]) {
+        return true;
+    }
+    if ([value isKindOfClass:[NSExpression class]]) {
+        return RLMExpressionContainsObjects(value);
+    }
+    if ([value isKindOfClass:[NSArray class]] || [value isKindOfClass:[NSSet class]]) {
+        for (id item in value) {
+            if (RLMValueContainsObjects(item)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool RLMExpressionContainsObjects(NSExpression *expression) {
+    switch (expression.expressionType) {
+        case NSConstantValueExpressionType:
+            return RLMValueContainsObjects(expression.constantValue);
+        case NSAggregateExpressionType:
+            return RLMValueContainsObjects(expression.collection);
+        case NSFunctionExpressionType:
+            return RLMExpressionContainsObjects(expression.operand) || RLMValueContainsObjects(expression.arguments);
+        case NSSubqueryExpressionType:
+            return RLMValueContainsObjects(expression.collection) || RLMPredicateContainsObjects(expression.predicate);
+        default:
+            return false;
+    }
+}
+
+bool RLMPredicateContainsObjects(NSPredicate *predicate) {
+    if (NSCompoundPredicate *compound = RLMDynamicCast<NSCompoundPredicate>(predicate)) {
+        for (NSPredicate *subpredicate in compound.subpredicates) {
+            if (RLMPredicateContainsObjects(subpredicate)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (NSComparisonPredicate *comparison = RLMDynamicCast<NSComparisonPredicate>(predicate)) {
+        return RLMExpressionContainsObjects(comparison.leftExpression)
+            || RLMExpressionContainsObjects(comparison.rightExpression);
+    }
+    return false;
+}
+
+bool RLMArgumentsContainObjects(NSArray *arguments) {
+    return RLMValueContainsObjects(arguments);
 }
 
 void RLMGetColumnIndices(RLMObjectSchema *schema, NSArray *properties,
@@ -682,10 +3162,3 @@ void RLMGetColumnIndices(RLMObjectSchema *schema, NSArray *properties,
     }
 }
 
-void RLMUpdateViewWithOrder(tightdb::TableView &view, RLMObjectSchema *schema, NSArray *properties)
-{
-    std::vector<size_t> columns;
-    std::vector<bool> order;
-    RLMGetColumnIndices(schema, properties, columns, order);
-    view.sort(move(columns), move(order));
-}
@@ -18,7 +18,7 @@
 
 #import <Foundation/Foundation.h>
 
-@class RLMObject, RLMSchema, RLMMigration, RLMNotificationToken;
+@class RLMObject, RLMSchema, RLMMigration, RLMNotificationToken, RLMPreparedQuery;
 
 /**
  An RLMRealm instance (also referred to as "a realm") represents a Realm
@@ -463,6 +463,28 @@ typedef void(^RLMNotificationBlock)(NSString *notification, RLMRealm *realm);
  */
 - (void)deleteAllObjects;
 
+/**---------------------------------------------------------------------------------------
+ *  @name Preparing Queries
+ * ---------------------------------------------------------------------------------------
+ */
+/**
+ Prepare a query on the objects of a given type in this Realm which can be run
+ repeatedly with different values.
+
+ The predicate format is parsed and validated once rather than every time the
+ query is run, and uses the placeholders `$0`, `$1`, etc. in place of values:
+
+     RLMPreparedQuery *query = [realm prepareQuery:@"age > $0 AND name BEGINSWITH $1"
+                                          forClass:Person.class];
+     RLMResults *adults = [query resultsWithArguments:@[@18, @"J"]];
+
+ @param predicateFormat The predicate format string, with placeholders for the values.
+ @param objectClass     The RLMObject subclass to query.
+
+ @return    An RLMPreparedQuery for objects of the given type.
+ */
+- (RLMPreparedQuery *)prepareQuery:(NSString *)predicateFormat forClass:(Class)objectClass;
+
 
 #pragma mark - Migrations
 
@@ -141,6 +141,7 @@ static NSString * const c_defaultRealmFileName = @"default.realm";
     Group *_group;
     BOOL _readOnly;
     BOOL _inMemory;
+    NSData *_encryptionKey;
 }
 
 + (BOOL)isCoreDebug {
@@ -167,6 +168,7 @@ static NSString * const c_defaultRealmFileName = @"default.realm";
         _inMemory = inMemory;
         _dynamic = dynamic;
         _autorefresh = YES;
+        _encryptionKey = key;
 
         NSError *error = nil;
         try {
@@ -224,10 +226,30 @@ static NSString * const c_defaultRealmFileName = @"default.realm";
 - (tightdb::Group *)getOrCreateGroup {
     if (!_group) {
         _group = &const_cast<Group&>(_sharedGroup->begin_read());
+        ++_readGeneration;
     }
     return _group;
 }
 
+- (BOOL)isReadingLatestVersion {
+    return !_readOnly && _group && !_sharedGroup->has_changed();
+}
+
+- (RLMRealm *(^)())backgroundRealmFactory {
+    NSString *path = _path;
+    NSData *key = _encryptionKey;
+    BOOL inMemory = _inMemory, dynamic = _dynamic;
+    RLMSchema *schema = [_schema shallowCopy];
+    return ^{
+        // not cached or given a notifier, as it's used only for a single read
+        // on a thread without a run loop
+        RLMRealm *realm = [[RLMRealm alloc] initWithPath:path key:key readOnly:NO
+                                                inMemory:inMemory dynamic:dynamic error:nil];
+        RLMRealmSetSchema(realm, [schema shallowCopy], false);
+        return realm;
+    };
+}
+
 + (NSString *)defaultRealmPath
 {
     static dispatch_once_t onceToken;
@@ -493,6 +515,7 @@ static void CheckReadWrite(RLMRealm *realm, NSString *msg=@"Cannot write to a re
             [self getOrCreateGroup];
 
             LangBindHelper::promote_to_write(*_sharedGroup);
+            ++_readGeneration;
 
             // update state and make all objects in this realm writable
             _inWriteTransaction = YES;
@@ -519,6 +542,7 @@ static void CheckReadWrite(RLMRealm *realm, NSString *msg=@"Cannot write to a re
     if (self.inWriteTransaction) {
         try {
             LangBindHelper::commit_and_continue_as_read(*_sharedGroup);
+            ++_readGeneration;
 
             // update state and make all objects in this realm read-only
             _inWriteTransaction = NO;
@@ -552,6 +576,7 @@ static void CheckReadWrite(RLMRealm *realm, NSString *msg=@"Cannot write to a re
     if (self.inWriteTransaction) {
         try {
             LangBindHelper::rollback_and_continue_as_read(*_sharedGroup);
+            ++_readGeneration;
             _inWriteTransaction = NO;
         }
         catch (std::exception& ex) {
@@ -578,6 +603,7 @@ static void CheckReadWrite(RLMRealm *realm, NSString *msg=@"Cannot write to a re
 
     _sharedGroup->end_read();
     _group = nullptr;
+    ++_readGeneration;
     for (RLMObjectSchema *objectSchema in _schema.objectSchema) {
         objectSchema.table = nullptr;
     }
@@ -601,6 +627,7 @@ static void CheckReadWrite(RLMRealm *realm, NSString *msg=@"Cannot write to a re
             if (_autorefresh) {
                 if (_group) {
                     LangBindHelper::advance_read(*_sharedGroup);
+                    ++_readGeneration;
                 }
                 [self sendNotifications:RLMRealmDidChangeNotification];
             }
@@ -628,6 +655,7 @@ static void CheckReadWrite(RLMRealm *realm, NSString *msg=@"Cannot write to a re
         if (_sharedGroup->has_changed()) { // Throws
             if (_group) {
                 LangBindHelper::advance_read(*_sharedGroup);
+                ++_readGeneration;
             }
             else {
                 // Create the read transaction
@@ -727,6 +755,10 @@ static void CheckReadWrite(RLMRealm *realm, NSString *msg=@"Cannot write to a re
     return RLMGetObjects(self, objectClassName, predicate);
 }
 
+- (RLMPreparedQuery *)prepareQuery:(NSString *)predicateFormat forClass:(Class)objectClass {
+    return [RLMGetObjects(self, [objectClass className], nil) prepareQuery:predicateFormat];
+}
+
 + (void)setDefaultRealmSchemaVersion:(NSUInteger)version withMigrationBlock:(RLMMigrationBlock)block {
     [RLMRealm setSchemaVersion:version forRealmAtPath:[RLMRealm defaultRealmPath] withMigrationBlock:block];
 }
@@ -29,7 +29,21 @@ namespace tightdb {
 
 @interface RLMRealm ()
 @property (nonatomic, readonly, getter=getOrCreateGroup) tightdb::Group *group;
+
+// incremented each time the version of the data the realm reads changes, i.e.
+// when a read transaction is begun, advanced or ended and when a write
+// transaction is begun, committed or cancelled
+@property (nonatomic, readonly) uint64_t readGeneration;
+
 - (void)handleExternalCommit;
+
+// whether the realm is in a read transaction on the latest version of the data
+- (BOOL)isReadingLatestVersion;
+
+// Returns a block which opens a new instance of this realm using its schema
+// when called. The instance is not cached and not notified of changes, so it
+// can be used from a background thread to read the latest version of the data.
+- (RLMRealm *(^)())backgroundRealmFactory;
 @end
 
 // throw an exception if the realm is being used from the wrong thread
@@ -19,7 +19,7 @@
 #import <Foundation/Foundation.h>
 #import <Realm/RLMCollection.h>
 
-@class RLMObject, RLMRealm;
+@class RLMObject, RLMRealm, RLMPreparedQuery;
 
 /**
  RLMResults is an auto-updating container type in Realm returned from object
@@ -141,6 +141,20 @@
  */
 - (RLMResults *)objectsWithPredicate:(NSPredicate *)predicate;
 
+/**
+ Prepare a query on the RLMResults which can be run repeatedly with different values.
+
+ The predicate format is parsed and validated once, and uses the placeholders
+ `$0`, `$1`, etc. in place of values, which are supplied each time the query is run:
+
+     RLMPreparedQuery *query = [results prepareQuery:@"age > $0 AND name BEGINSWITH $1"];
+     RLMResults *adults = [query resultsWithArguments:@[@18, @"J"]];
+
+ @param predicateFormat The predicate format string, with placeholders for the values.
+ @return                An RLMPreparedQuery which filters the objects in this RLMResults.
+ */
+- (RLMPreparedQuery *)prepareQuery:(NSString *)predicateFormat;
+
 /**
  Get a sorted `RLMResults` from an existing `RLMResults` sorted by a property.
 
@@ -160,6 +174,133 @@
  */
 - (RLMResults *)sortedResultsUsingDescriptors:(NSArray *)properties;
 
+/**
+ Get an `RLMResults` containing at most `limit` objects from an existing
+ `RLMResults`, starting with the object at index `offset`.
+
+ Unsorted results stop running their query once enough objects are found, and
+ sorted results only sort the objects up to the end of the limit, so showing
+ the first few objects of a large set of results is much cheaper than
+ evaluating all of them. The count of limited results is also found without
+ evaluating them.
+
+ Limited results cannot be filtered or sorted further, so filter and sort the
+ results before limiting them.
+
+ @param limit   The maximum number of objects in the returned results.
+ @param offset  The number of objects to skip at the start of the results.
+
+ @return    An RLMResults with at most `limit` objects from the receiver.
+ */
+- (RLMResults *)resultsLimitedTo:(NSUInteger)limit offset:(NSUInteger)offset;
+
+/**
+ Get an `RLMResults` containing only the first object with each value of the
+ given property from an existing `RLMResults`.
+
+ Duplicates are found in a single pass over the results. Distinct results of
+ all of the objects of a type use the search index for the property if it has one.
+ Distinct results can be limited, but cannot be filtered or sorted further.
+
+ @param property    The name of a bool, date, double, float, int or string property.
+
+ @return    An RLMResults with one object for each distinct value of the property.
+ */
+- (RLMResults *)distinctResultsUsingProperty:(NSString *)property;
+
+/**
+ Count the objects in the results with each value of the given property.
+
+ NSDictionary *counts = [results groupedCountsByProperty:@"city"];
+
+ The counts are found in a single pass over the results without creating any
+ objects. For all of the objects of a type, counts for an indexed string property
+ are looked up in the search index.
+
+ @param property    The name of a bool, date, double, float, int or string property.
+
+ @return    A dictionary mapping each value of the property to the number of
+            objects in the results which have that value.
+ */
+- (NSDictionary *)groupedCountsByProperty:(NSString *)property;
+
+/**
+ Describe how the query for this RLMResults is evaluated, for diagnosing slow queries.
+
+ The description lists the conditions of each predicate applied to the results
+ in the order they are evaluated, noting which use a search index, along with
+ the number of objects which were checked against each condition and the number
+ which matched it. It also includes the time taken to run the query and to sort
+ the results when they were last evaluated.
+
+ @warning Counting the objects checked and matched by each condition runs the
+          query once for each condition, so this can be slow for large Realms.
+
+ @return    A human-readable description of how the results are evaluated.
+ */
+- (NSString *)explain;
+
+/**
+ Evaluate the query and sort for these results on a background thread, and then
+ call the completion block on the current thread once the results are ready.
+
+ Results are otherwise evaluated on their own thread the first time they are
+ accessed after being created or after the Realm changes, which can block the
+ thread for a long time for queries which check many objects. The objects found
+ in the background are handed to these results only if this thread's Realm is
+ still reading the same version of the data, so accessing the results in the
+ completion block does not have to run the query again. If the Realm changes
+ while the query runs it is run again, and if that keeps happening the results
+ are evaluated on this thread instead.
+
+ Results whose query is over an RLMArray, or which are accessed during a write
+ transaction, are evaluated on this thread before the completion block is called.
+
+ @warning The completion block is called from the current thread's run loop, which
+          must be running, as it is on the main thread.
+
+ @param completion  The block to call with these results once they are evaluated.
+ */
+- (void)evaluateAsync:(void (^)(RLMResults *results))completion;
+
+/**
+ Get an `RLMResults` with the same objects as an existing `RLMResults` whose
+ query is run on several threads at once.
+
+ The objects are split into ranges which are searched concurrently, each by
+ its own instance of the Realm reading the same version of the data, and the
+ objects found are merged back in order. Counting the results and the min, max,
+ sum and average of int, float and double properties are run in parallel too.
+ Results filtered, sorted, limited or made distinct from the returned results
+ are also evaluated in parallel.
+
+ Queries over fewer than 100,000 objects, over an RLMArray, or run during a
+ write transaction are run on the current thread as usual, as are queries for
+ which the Realm changes while the other threads are running them.
+
+ @return    An RLMResults with the same objects as the receiver.
+ */
+- (RLMResults *)resultsEvaluatedInParallel;
+
+/**
+ Get an `RLMResults` with the same objects as an existing `RLMResults` which
+ finds its objects as they are read rather than all at once.
+
+ Results otherwise find all of their objects the first time they are accessed,
+ holding the index of every object found. Lazy results search for 1,000 objects
+ at a time, resuming the query where the previous search stopped, and keep only
+ the objects found most recently. Reading the first few objects of a large set
+ of results or enumerating them thus uses a small, constant amount of memory.
+ The count of lazy results is found by running the query without keeping the
+ objects found.
+
+ Results filtered from the returned results are also lazy. Sorted, distinct and
+ limited results and results over an RLMArray find all of their objects as usual.
+
+ @return    An RLMResults with the same objects as the receiver.
+ */
+- (RLMResults *)resultsEvaluatedLazily;
+
 #pragma mark -
 
 
@@ -176,6 +317,7 @@
  @warning You cannot use this method on RLMObject, RLMArray, and NSData properties.
 
  @param property The property to look for a minimum on. Only properties of type int, float, double and NSDate are supported.
+                 May be a key path through RLMObject and RLMArray properties, such as `@"employees.age"`.
 
  @return The minimum value for the property amongst objects in an RLMResults.
  */
@@ -189,6 +331,7 @@
  @warning You cannot use this method on RLMObject, RLMArray, and NSData properties.
 
  @param property The property to look for a maximum on. Only properties of type int, float, double and NSDate are supported.
+                 May be a key path through RLMObject and RLMArray properties, such as `@"employees.age"`.
 
  @return The maximum value for the property amongst objects in an RLMResults
  */
@@ -202,6 +345,7 @@
  @warning You cannot use this method on RLMObject, RLMArray, and NSData properties.
 
  @param property The property to calculate sum on. Only properties of type int, float and double are supported.
+                 May be a key path through RLMObject and RLMArray properties, such as `@"employees.age"`.
 
  @return The sum of the given property over all objects in an RLMResults.
  */
@@ -215,12 +359,56 @@
  @warning You cannot use this method on RLMObject, RLMArray, and NSData properties.
 
  @param property The property to calculate average on. Only properties of type int, float and double are supported.
+                 May be a key path through RLMObject and RLMArray properties, such as `@"employees.age"`.
 
  @return    The average for the given property amongst objects in an RLMResults. This will be of type double for both
  float and double properties.
  */
 -(NSNumber *)averageOfProperty:(NSString *)property;
 
+/**
+ Returns the count, minimum, maximum, sum and average of each of the given properties for objects in an RLMResults,
+ computed in a single pass over the objects.
+
+ NSDictionary *statistics = [results statisticsForProperties:@[@"age", @"salary"]];
+ NSNumber *maxAge = statistics[@"age"][@"max"];
+
+ @warning You cannot use this method on RLMObject, RLMArray, and NSData properties.
+
+ @param properties The properties to calculate statistics for. Only properties of type int, float, double and NSDate
+                   are supported. Each may be a key path through RLMObject and RLMArray properties, as for minOfProperty:.
+
+ @return A dictionary mapping each property to a dictionary with the keys `count`, `min`, `max`, `sum` and `average`.
+         `min`, `max` and `average` are omitted when there are no values, and `sum` and `average` are omitted for
+         NSDate properties.
+ */
+-(NSDictionary *)statisticsForProperties:(NSArray *)properties;
+
+#pragma mark -
+
+
+/**---------------------------------------------------------------------------------------
+ *  @name Receiving Notification when Results Change
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/**
+ Add a notification block which is called with the indices of the objects which
+ were inserted into, removed from and modified in this RLMResults each time a
+ write transaction which changes it is committed.
+
+ The results are re-evaluated when the Realm changes, and the block is only
+ called when the objects matching the query, their order or their properties
+ actually changed. This lets a table view update only the affected rows rather
+ than reloading all of its data after every write transaction.
+
+ @param block   The block to call with the results and the changes made to them.
+
+ @return A token which must be held on to for as long as notifications are
+         wanted and then passed to `-[RLMRealm removeNotification:]`.
+ */
+- (RLMNotificationToken *)addNotificationBlock:(RLMCollectionNotificationBlock)block;
+
 #pragma mark -
 
 - (id)objectAtIndexedSubscript:(NSUInteger)index;
@@ -246,3 +434,42 @@
 
 @end
 
+/**
+ A query which has been parsed and validated once, and can be run repeatedly
+ with different values for its placeholders.
+
+ RLMPreparedQuery cannot be created directly. Use `-[RLMRealm prepareQuery:forClass:]`
+ or `-[RLMResults prepareQuery:]` to create one.
+ */
+@interface RLMPreparedQuery : NSObject
+
+/**
+ The number of values which must be supplied to run the query.
+ */
+@property (nonatomic, readonly) NSUInteger argumentCount;
+
+/**
+ The class name (i.e. type) of the RLMObjects returned by this query.
+ */
+@property (nonatomic, readonly, copy) NSString *objectClassName;
+
+/**
+ The Realm this `RLMPreparedQuery` is associated with.
+ */
+@property (nonatomic, readonly) RLMRealm *realm;
+
+/**
+ Run the query with the given values for its placeholders.
+
+ @param arguments   The values for the placeholders, with the value for `$0` first.
+                    Use `NSNull` to compare against `nil`.
+ @return            An RLMResults of objects that match the query.
+ */
+- (RLMResults *)resultsWithArguments:(NSArray *)arguments;
+
+/**
+ -[RLMPreparedQuery init] is not available because RLMPreparedQuery cannot be created directly.
+ */
+- (instancetype)init __attribute__((unavailable("RLMPreparedQuery cannot be created directly")));
+
+@end
@@ -23,13 +23,357 @@
 #import "RLMObject_Private.hpp"
 #import "RLMObjectSchema_Private.hpp"
 #import "RLMObjectStore.h"
+#import "RLMProperty_Private.h"
 #import "RLMQueryUtil.hpp"
 #import "RLMRealm_Private.hpp"
 #import "RLMSchema_Private.h"
 #import "RLMUtil.hpp"
 
+#import <array>
+#import <chrono>
+#import <numeric>
 #import <objc/runtime.h>
 #import <tightdb/table_view.hpp>
+#import <tightdb/utf8.hpp>
+#import <unordered_map>
+#import <unordered_set>
+
+// Orders rows of a table by the values in the sort columns, using the same
+// comparisons as core's TableView::sort(). Rows with equal values are ordered
+// by row index, which is the order core's stable sort leaves them in as
+// find_all() returns rows in index order.
+class RLMRowComparator {
+public:
+    RLMRowComparator(tightdb::Table const& table, RowIndexes::Sorter const& sorter)
+    : m_table(table), m_columns(sorter.m_columns), m_ascending(sorter.m_ascending)
+    {
+        for (size_t column : m_columns) {
+            m_types.push_back(table.get_column_type(column));
+        }
+    }
+
+    bool operator()(size_t a, size_t b) const {
+        for (size_t i = 0; i < m_columns.size(); ++i) {
+            int c = compare(m_columns[i], m_types[i], a, b);
+            if (c != 0) {
+                return m_ascending[i] ? c < 0 : c > 0;
+            }
+        }
+        return a < b;
+    }
+
+private:
+    template<typename T>
+    static int compare_values(T const& a, T const& b) {
+        return a < b ? -1 : b < a ? 1 : 0;
+    }
+
+    int compare(size_t column, tightdb::DataType type, size_t a, size_t b) const {
+        switch (type) {
+            case tightdb::type_Int:
+                return compare_values(m_table.get_int(column, a), m_table.get_int(column, b));
+            case tightdb::type_Bool:
+                return compare_values(m_table.get_bool(column, a), m_table.get_bool(column, b));
+            case tightdb::type_DateTime:
+                return compare_values(m_table.get_datetime(column, a).get_datetime(),
+                                      m_table.get_datetime(column, b).get_datetime());
+            case tightdb::type_Float:
+                return compare_values(m_table.get_float(column, a), m_table.get_float(column, b));
+            case tightdb::type_Double:
+                return compare_values(m_table.get_double(column, a), m_table.get_double(column, b));
+            case tightdb::type_String: {
+                tightdb::StringData sa = m_table.get_string(column, a), sb = m_table.get_string(column, b);
+                if (sa == sb) {
+                    return 0;
+                }
+                return tightdb::utf8_compare(sa, sb) ? -1 : 1;
+            }
+            default:
+                TIGHTDB_ASSERT(false); // RLMValidatedPropertyForSort() rejects other types
+                return 0;
+        }
+    }
+
+    tightdb::Table const& m_table;
+    std::vector<size_t> const& m_columns;
+    std::vector<bool> const& m_ascending;
+    std::vector<tightdb::DataType> m_types;
+};
+
+// sorts of fewer rows than this compare the rows directly, as reading the
+// sort keys into a buffer costs more than it saves
+static const size_t RLMKeySortMinimumRows = 512;
+
+namespace {
+// a sort key, and the position in the rows being sorted of the row it's for
+struct RLMSortEntry {
+    uint64_t key;
+    size_t position;
+};
+}
+
+// Stable LSD radix sort of entries by key a byte at a time, skipping the bytes
+// which are the same for every key, so small ranges of values such as bools
+// or string ranks only take a pass or two.
+static void RLMRadixSort(std::vector<RLMSortEntry>& entries, std::vector<RLMSortEntry>& buffer) {
+    if (entries.empty()) {
+        return;
+    }
+    std::vector<std::array<size_t, 256>> counts(sizeof(uint64_t));
+    for (auto const& entry : entries) {
+        for (size_t byte = 0; byte < sizeof(uint64_t); ++byte) {
+            ++counts[byte][(entry.key >> (byte * 8)) & 0xff];
+        }
+    }
+
+    buffer.resize(entries.size());
+    for (size_t byte = 0; byte < sizeof(uint64_t); ++byte) {
+        if (counts[byte][(entries[0].key >> (byte * 8)) & 0xff] == entries.size()) {
+            continue;
+        }
+        std::array<size_t, 256> offsets;
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            offsets[digit] = offset;
+            offset += counts[byte][digit];
+        }
+        for (auto const& entry : entries) {
+            buffer[offsets[(entry.key >> (byte * 8)) & 0xff]++] = entry;
+        }
+        entries.swap(buffer);
+    }
+}
+
+// unsigned integers which order the same way as the values they're made from
+static inline uint64_t RLMSortKeyForInt(int64_t value) {
+    return uint64_t(value) ^ (uint64_t(1) << 63);
+}
+
+static inline uint64_t RLMSortKeyForDouble(double value) {
+    if (value == 0) {
+        // -0.0 compares equal to 0.0
+        value = 0;
+    }
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits & (uint64_t(1) << 63) ? ~bits : bits | (uint64_t(1) << 63);
+}
+
+// Read the value of the column for each of the rows as a sort key. Strings
+// are ordered by utf8_compare(), which isn't the order of their bytes, so
+// rather than using a prefix of their bytes as the key they're sorted once
+// with the values read into a buffer and ranked, with equal strings sharing
+// a rank.
+static void RLMReadSortKeys(tightdb::Table const& table, size_t column, std::vector<size_t> const& rows,
+                            std::vector<uint64_t>& keys) {
+    size_t count = rows.size();
+    keys.resize(count);
+    switch (table.get_column_type(column)) {
+        case tightdb::type_Int:
+            for (size_t i = 0; i < count; ++i) {
+                keys[i] = RLMSortKeyForInt(table.get_int(column, rows[i]));
+            }
+            break;
+        case tightdb::type_Bool:
+            for (size_t i = 0; i < count; ++i) {
+                keys[i] = table.get_bool(column, rows[i]);
+            }
+            break;
+        case tightdb::type_DateTime:
+            for (size_t i = 0; i < count; ++i) {
+                keys[i] = RLMSortKeyForInt(table.get_datetime(column, rows[i]).get_datetime());
+            }
+            break;
+        case tightdb::type_Float:
+            for (size_t i = 0; i < count; ++i) {
+                keys[i] = RLMSortKeyForDouble(table.get_float(column, rows[i]));
+            }
+            break;
+        case tightdb::type_Double:
+            for (size_t i = 0; i < count; ++i) {
+                keys[i] = RLMSortKeyForDouble(table.get_double(column, rows[i]));
+            }
+            break;
+        case tightdb::type_String: {
+            std::vector<tightdb::StringData> values;
+            values.reserve(count);
+            for (size_t row : rows) {
+                values.push_back(table.get_string(column, row));
+            }
+            std::vector<size_t> byValue(count);
+            std::iota(byValue.begin(), byValue.end(), 0);
+            std::sort(byValue.begin(), byValue.end(), [&](size_t a, size_t b) {
+                return values[a] != values[b] && tightdb::utf8_compare(values[a], values[b]);
+            });
+            uint64_t rank = 0;
+            for (size_t i = 0; i < count; ++i) {
+                if (i > 0 && values[byValue[i]] != values[byValue[i - 1]]) {
+                    ++rank;
+                }
+                keys[byValue[i]] = rank;
+            }
+            break;
+        }
+        default:
+            TIGHTDB_ASSERT(false); // RLMValidatedPropertyForSort() rejects other types
+            break;
+    }
+}
+
+// Sort rows into the order given by RLMRowComparator. Larger sorts read the
+// values of each sort column once into a buffer of keys rather than reading
+// them through the table for every comparison, and radix sort the rows by the
+// keys for each column in turn, starting from the last. Each pass is stable
+// and the rows are first put in row index order, so rows with equal values
+// end up ordered by row index as they are by the comparator.
+static void RLMSortRows(tightdb::Table const& table, RowIndexes::Sorter const& sorter, std::vector<size_t>& rows,
+                        RLMRowComparator const& less) {
+    if (rows.size() < RLMKeySortMinimumRows) {
+        std::sort(rows.begin(), rows.end(), less);
+        return;
+    }
+
+    std::vector<RLMSortEntry> entries(rows.size()), buffer;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        entries[i] = {rows[i], i};
+    }
+    RLMRadixSort(entries, buffer);
+
+    std::vector<uint64_t> keys;
+    for (size_t i = sorter.m_columns.size(); i-- > 0; ) {
+        RLMReadSortKeys(table, sorter.m_columns[i], rows, keys);
+        bool ascending = sorter.m_ascending[i];
+        for (auto& entry : entries) {
+            entry.key = ascending ? keys[entry.position] : ~keys[entry.position];
+        }
+        RLMRadixSort(entries, buffer);
+    }
+
+    std::vector<size_t> sorted;
+    sorted.reserve(rows.size());
+    for (auto const& entry : entries) {
+        sorted.push_back(rows[entry.position]);
+    }
+    rows = std::move(sorted);
+}
+
+// Limited results only keep the rows up to the end of the limit, which are
+// found with a partial sort when they're fewer than this fraction of the rows
+static const size_t RLMPartialSortRatio = 8;
+
+namespace {
+template<typename T>
+struct RLMValueHash : std::hash<T> { };
+
+template<>
+struct RLMValueHash<tightdb::StringData> {
+    size_t operator()(tightdb::StringData value) const {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < value.size(); ++i) {
+            hash = (hash ^ static_cast<unsigned char>(value.data()[i])) * 1099511628211ULL;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+}
+
+// Call func with a function which reads the value of the column in a row, as
+// a type which can be hashed and compared for equality, and a function which
+// converts those values to objects.
+template<typename Func>
+static void RLMVisitColumnValues(tightdb::Table const& table, size_t column, Func&& func) {
+    switch (table.get_column_type(column)) {
+        case tightdb::type_Int:
+            func([&](size_t row) { return table.get_int(column, row); },
+                 [](int64_t value) -> id { return @(value); });
+            break;
+        case tightdb::type_Bool:
+            func([&](size_t row) { return table.get_bool(column, row); },
+                 [](bool value) -> id { return @(value); });
+            break;
+        case tightdb::type_DateTime:
+            func([&](size_t row) { return table.get_datetime(column, row).get_datetime(); },
+                 [](time_t value) -> id { return [NSDate dateWithTimeIntervalSince1970:value]; });
+            break;
+        case tightdb::type_Float:
+            func([&](size_t row) { return table.get_float(column, row); },
+                 [](float value) -> id { return @(value); });
+            break;
+        case tightdb::type_Double:
+            func([&](size_t row) { return table.get_double(column, row); },
+                 [](double value) -> id { return @(value); });
+            break;
+        case tightdb::type_String:
+            func([&](size_t row) { return table.get_string(column, row); },
+                 [](tightdb::StringData value) -> id { return RLMStringDataToNSString(value); });
+            break;
+        default:
+            TIGHTDB_ASSERT(false); // RLMValidatedColumnForGrouping() rejects other types
+    }
+}
+
+// keep only the first of the rows with each value of the column
+static void RLMDistinctRows(tightdb::Table const& table, size_t column, std::vector<size_t>& rows) {
+    RLMVisitColumnValues(table, column, [&](auto get, auto) {
+        using T = decltype(get(0));
+        std::unordered_set<T, RLMValueHash<T>> seen;
+        size_t kept = 0;
+        for (size_t row : rows) {
+            if (seen.insert(get(row)).second) {
+                rows[kept++] = row;
+            }
+        }
+        rows.resize(kept);
+    });
+}
+
+// count the rows with each value of the column
+static NSDictionary *RLMGroupedCounts(tightdb::Table const& table, size_t column, std::vector<size_t> const& rows) {
+    NSMutableDictionary *counts = [NSMutableDictionary new];
+    RLMVisitColumnValues(table, column, [&](auto get, auto toObject) {
+        using T = decltype(get(0));
+        std::unordered_map<T, size_t, RLMValueHash<T>> groups;
+        for (size_t row : rows) {
+            ++groups[get(row)];
+        }
+        for (auto const& group : groups) {
+            counts[toObject(group.first)] = @(group.second);
+        }
+    });
+    return counts;
+}
+
+static size_t RLMValidatedColumnForGrouping(RLMObjectSchema *objectSchema, NSString *property) {
+    RLMProperty *prop = objectSchema[property];
+    if (!prop) {
+        @throw RLMException([NSString stringWithFormat:@"Property '%@' not found in objects of type '%@'",
+                                                       property, objectSchema.className]);
+    }
+    switch (prop.type) {
+        case RLMPropertyTypeBool:
+        case RLMPropertyTypeDate:
+        case RLMPropertyTypeDouble:
+        case RLMPropertyTypeFloat:
+        case RLMPropertyTypeInt:
+        case RLMPropertyTypeString:
+            return prop.column;
+        default:
+            @throw RLMException(@"Distinct values and grouped counts are only supported for bool, date, double, float, int and string properties.");
+    }
+}
+
+static NSString *RLMColumnName(RLMObjectSchema *objectSchema, size_t column) {
+    for (RLMProperty *prop in objectSchema.properties) {
+        if (prop.column == column) {
+            return prop.name;
+        }
+    }
+    return nil;
+}
+
+@interface RLMPreparedQuery ()
+- (instancetype)initWithResults:(RLMResults *)results predicate:(RLMPreparedPredicate *)predicate;
+@end
 
 //
 // RLMResults implementation
@@ -40,6 +384,44 @@
     BOOL _viewCreated;
     RowIndexes::Sorter _sortOrder;
 
+    // the link view or table which the query is over, and the predicates which
+    // were applied to it to build the query, for describing the query in -explain
+    tightdb::LinkViewRef _linkView;
+    NSArray *_predicates;
+
+    // the time taken by the most recent query and sort run when creating the view
+    double _findAllDuration;
+    double _sortDuration;
+
+    // the view's rows were found by other realms, so its own query is
+    // empty and syncing it means re-running _backingQuery
+    BOOL _viewHandedOver;
+
+    // only the first object with each value of _distinctColumn is in the results
+    BOOL _distinct;
+    size_t _distinctColumn;
+
+    // only the objects from _offset to _offset + _limit are in the results
+    BOOL _limited;
+    size_t _limit;
+    size_t _offset;
+
+    // the query is run on several threads at once when that's worthwhile
+    BOOL _parallel;
+
+    // lazy results find their objects a chunk at a time as they're read rather
+    // than creating a view of all of them, keeping only the chunk read most
+    // recently and the table row at which the search for each chunk starts
+    BOOL _lazy;
+    tightdb::TableView _window;
+    size_t _windowChunk;
+    std::vector<size_t> _chunkStarts;
+
+    // the number of objects matching the query, which is kept until the empty
+    // view of the query _countVersion is out of sync
+    size_t _cachedCount;
+    tightdb::TableView _countVersion;
+
 @protected
     RLMRealm *_realm;
     NSString *_objectClassName;
@@ -84,6 +466,463 @@
     return ar;
 }
 
+// run func, returning the time it took in seconds
+template<typename Func>
+static double RLMMeasureDuration(Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Walking an ordered index reads the index row of every object in the table,
+// so it's only used to sort rows which are at least this fraction of the table
+static const size_t RLMOrderedIndexSortRatio = 16;
+
+// Order rows by walking the ordered index for the first sort column rather
+// than comparing them, if the column has an ordered index and the rows are a
+// large enough part of the table. Rows with the same value for the first
+// column are then sorted by the remaining columns and row index, which only
+// needs comparisons for runs of equal values. If limit is given, the walk
+// stops once that many rows are found, and only the first limit rows are kept.
+static bool RLMSortRowsWithOrderedIndex(__unsafe_unretained RLMResults *const ar, tightdb::Table const& table,
+                                        std::vector<size_t>& rows, RLMRowComparator const& less,
+                                        size_t limit = size_t(-1)) {
+    if (ar->_sortOrder.m_columns.empty() || rows.size() * RLMOrderedIndexSortRatio < table.size()) {
+        return false;
+    }
+    size_t column = ar->_sortOrder.m_columns[0];
+    RLMProperty *prop = ar->_objectSchema[RLMColumnName(ar->_objectSchema, column)];
+    if (!prop.orderedIndexed) {
+        return false;
+    }
+    tightdb::TableRef index = ar->_realm.group->get_table(RLMOrderedIndexTableName(ar->_objectClassName, prop.name).UTF8String);
+    if (!index) {
+        return false;
+    }
+
+    // the index tables are only maintained by this binding, so rows written
+    // by anything else may have no postings, and are then sorted by comparison
+    std::vector<bool> included(table.size());
+    for (size_t row : rows) {
+        if (table.get_backlink_count(row, *index, c_orderedIndexObjectColumnIndex) == 0) {
+            return false;
+        }
+        included[row] = true;
+    }
+
+    bool ascending = ar->_sortOrder.m_ascending[0];
+    auto same_value = [&](size_t a, size_t b) {
+        return RLMCompareRowValues(table, column, a, table, column, b) == 0;
+    };
+    std::vector<size_t> sorted;
+    sorted.reserve(std::min(rows.size(), limit));
+    for (size_t i = 0, size = index->size(); i < size; ++i) {
+        size_t posting = ascending ? i : size - 1 - i;
+        if (index->is_null_link(c_orderedIndexObjectColumnIndex, posting)) {
+            continue;
+        }
+        size_t row = index->get_link(c_orderedIndexObjectColumnIndex, posting);
+        if (!included[row]) {
+            continue;
+        }
+        // rows with the same value as the last one kept may sort before it
+        if (sorted.size() >= limit && !same_value(sorted.back(), row)) {
+            break;
+        }
+        sorted.push_back(row);
+    }
+
+    // every row has a posting, so the walk only falls short if the index is
+    // inconsistent with the table
+    if (sorted.size() < std::min(rows.size(), limit)) {
+        return false;
+    }
+
+    for (size_t begin = 0, end; begin < sorted.size(); begin = end) {
+        for (end = begin + 1; end < sorted.size() && same_value(sorted[begin], sorted[end]); ++end) { }
+        if (end - begin > 1) {
+            std::vector<size_t> run(sorted.begin() + begin, sorted.begin() + end);
+            RLMSortRows(table, ar->_sortOrder, run, less);
+            std::copy(run.begin(), run.end(), sorted.begin() + begin);
+        }
+    }
+    if (sorted.size() > limit) {
+        sorted.resize(limit);
+    }
+    rows = std::move(sorted);
+    return true;
+}
+
+// whether any of the predicates for results compare against RLMObjects, whose
+// rows can only be read on the thread of their realm
+static bool RLMPredicatesContainObjects(NSArray *predicates) {
+    for (id predicate in predicates) {
+        if ([predicate isKindOfClass:[NSPredicate class]] ? RLMPredicateContainsObjects(predicate)
+                                                          : RLMArgumentsContainObjects(predicate[1])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The query for results can be run by another realm if it was built entirely
+// from predicates on a table, as the same query can then be built in the other
+// realm, the results aren't being read in a write transaction, and building the
+// query doesn't read any objects from this thread's realm.
+static bool RLMResultsCanRunQueryElsewhere(__unsafe_unretained RLMResults *const ar) {
+    return ar->_backingQuery && ar->_predicates && !ar->_linkView && !ar->_realm->_inWriteTransaction
+        && !RLMPredicatesContainObjects(ar->_predicates);
+}
+
+// build the query for results of the given class from their predicates in another realm
+static std::unique_ptr<tightdb::Query> RLMQueryWithPredicates(RLMRealm *realm, NSString *className, NSArray *predicates) {
+    RLMObjectSchema *objectSchema = realm.schema[className];
+    auto query = std::make_unique<tightdb::Query>(objectSchema.table->where());
+    for (id predicate in predicates) {
+        if ([predicate isKindOfClass:[NSPredicate class]]) {
+            RLMUpdateQueryWithPredicate(query.get(), predicate, realm.schema, objectSchema);
+        }
+        else {
+            RLMUpdateQueryWithPreparedPredicate(query.get(), predicate[0], predicate[1]);
+        }
+    }
+    return query;
+}
+
+// queries over tables with fewer rows than this are always run on one thread
+static const size_t RLMParallelEvaluationMinimumRows = 100000;
+// the fewest rows given to each thread when a query is run in parallel
+static const size_t RLMParallelEvaluationRowsPerThread = 50000;
+
+// Run func(query, start, end) over consecutive ranges of the table's rows on
+// several threads at once, and store what it returns for each range in order.
+// Each thread builds the query in its own instance of the realm, which reads
+// the version of the data the results are reading as long as that's still the
+// latest version when all of the threads are done. Returns false if the
+// results weren't asked to be evaluated in parallel, if the table is too small
+// for it to be worthwhile, or if any of the threads failed or may have read a
+// different version, in which case the caller runs the query itself.
+template<typename Result, typename Func>
+static bool RLMResultsRunInParallel(__unsafe_unretained RLMResults *const ar, std::vector<Result>& results, Func&& func) {
+    if (!ar->_parallel || !RLMResultsCanRunQueryElsewhere(ar) || ![ar->_realm isReadingLatestVersion]) {
+        return false;
+    }
+    size_t size = ar->_objectSchema.table->size();
+    size_t threads = std::min<size_t>([NSProcessInfo processInfo].activeProcessorCount,
+                                      size / RLMParallelEvaluationRowsPerThread);
+    if (size < RLMParallelEvaluationMinimumRows || threads < 2) {
+        return false;
+    }
+
+    RLMRealm *(^openRealm)() = [ar->_realm backgroundRealmFactory];
+    NSString *className = ar->_objectClassName;
+    NSArray *predicates = ar->_predicates;
+    results.assign(threads, Result());
+    std::vector<char> succeeded(threads);
+    // blocks copy the C++ objects they capture, so the workers write through pointers
+    Result *resultsData = results.data();
+    char *succeededData = succeeded.data();
+    auto funcPtr = &func;
+    dispatch_apply(threads, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        @autoreleasepool {
+            @try {
+                auto query = RLMQueryWithPredicates(openRealm(), className, predicates);
+                resultsData[i] = (*funcPtr)(*query, size * i / threads, size * (i + 1) / threads);
+                succeededData[i] = true;
+            }
+            @catch (NSException *) {
+                // run on the calling thread instead
+            }
+        }
+    });
+
+    return [ar->_realm isReadingLatestVersion]
+        && std::all_of(succeeded.begin(), succeeded.end(), [](char s) { return s; });
+}
+
+// find the rows matching the query for the results in parallel, and put them
+// into an empty view of the table, which can't be synced by re-running its query
+static bool RLMResultsFindAllInParallel(__unsafe_unretained RLMResults *const ar, tightdb::TableView& view) {
+    std::vector<std::vector<size_t>> found;
+    bool parallel = RLMResultsRunInParallel(ar, found, [](tightdb::Query& query, size_t start, size_t end) {
+        tightdb::TableView view = query.find_all(start, end);
+        std::vector<size_t> rows;
+        rows.reserve(view.size());
+        for (size_t i = 0; i < view.size(); ++i) {
+            rows.push_back(view.get_source_ndx(i));
+        }
+        return rows;
+    });
+    if (!parallel) {
+        return false;
+    }
+
+    std::vector<size_t> rows;
+    for (auto const& rangeRows : found) {
+        rows.insert(rows.end(), rangeRows.begin(), rangeRows.end());
+    }
+    view = ar->_objectSchema.table->where().find_all(0, size_t(-1), 0);
+    RLMSetViewRows(view, rows);
+    return true;
+}
+
+// run the query for the results, in parallel if they're evaluated in parallel
+static tightdb::TableView RLMResultsFindAll(__unsafe_unretained RLMResults *const ar) {
+    tightdb::TableView view;
+    if (!RLMResultsFindAllInParallel(ar, view)) {
+        view = ar->_backingQuery->find_all();
+    }
+    return view;
+}
+
+// create a plain view of the results' query, which is marked as handed over
+// when it was found in parallel as syncing it wouldn't re-run the query
+static void RLMResultsCreateView(__unsafe_unretained RLMResults *const ar) {
+    bool parallel = false;
+    ar->_findAllDuration = RLMMeasureDuration([&] {
+        parallel = RLMResultsFindAllInParallel(ar, ar->_backingView);
+        if (!parallel) {
+            ar->_backingView = ar->_backingQuery->find_all();
+        }
+    });
+    ar->_viewCreated = YES;
+    ar->_viewHandedOver = parallel;
+}
+
+// Re-run the query for sorted results and sort the rows found. Rather than
+// sorting from scratch, the previous order of the view is reused: rows which
+// are still in the results and still in order relative to their neighbours keep
+// their place, and only the new rows and those whose values changed are sorted
+// and merged in. A single changed row thus costs a linear pass over the results
+// rather than a full sort. When many rows have to be placed, such as the first
+// time the results are sorted, they're read from an ordered index on the
+// first sort column if it has one.
+//
+// Row indexes may refer to different objects than when the view was last
+// synced (deleting an object moves the last row into its place), but as every
+// row kept from the old order is checked against the current values the
+// result is always the same as that of a full sort.
+static void RLMResultsUpdateSortedView(__unsafe_unretained RLMResults *const ar) {
+    tightdb::TableView view;
+    ar->_findAllDuration = RLMMeasureDuration([&] {
+        view = RLMResultsFindAll(ar);
+    });
+
+    ar->_sortDuration = RLMMeasureDuration([&] {
+        tightdb::Table const& table = view.get_parent();
+        size_t count = view.size();
+        RLMRowComparator less(table, ar->_sortOrder);
+
+        // rows which match the query and haven't been placed yet
+        std::vector<bool> unplaced(table.size());
+        for (size_t i = 0; i < count; ++i) {
+            unplaced[view.get_source_ndx(i)] = true;
+        }
+
+        // the previous order, limited to the rows which still match
+        std::vector<size_t> previous;
+        if (ar->_viewCreated) {
+            previous.reserve(count);
+            for (size_t i = 0, size = ar->_backingView.size(); i < size; ++i) {
+                size_t row = ar->_backingView.get_source_ndx(i);
+                if (row < unplaced.size() && unplaced[row]) {
+                    previous.push_back(row);
+                    unplaced[row] = false;
+                }
+            }
+        }
+
+        // keep the rows which are in order relative to both neighbours, and
+        // then check the kept rows again as removing rows from between them
+        // can leave their new neighbours out of order
+        std::vector<size_t> kept, pending;
+        kept.reserve(previous.size());
+        for (size_t i = 0; i < previous.size(); ++i) {
+            bool inOrder = (i == 0 || less(previous[i - 1], previous[i]))
+                        && (i + 1 == previous.size() || less(previous[i], previous[i + 1]));
+            (inOrder ? kept : pending).push_back(previous[i]);
+        }
+        size_t keptCount = 0;
+        for (size_t row : kept) {
+            if (keptCount == 0 || less(kept[keptCount - 1], row)) {
+                kept[keptCount++] = row;
+            }
+            else {
+                pending.push_back(row);
+            }
+        }
+        kept.resize(keptCount);
+
+        for (size_t i = 0; i < count; ++i) {
+            size_t row = view.get_source_ndx(i);
+            if (unplaced[row]) {
+                pending.push_back(row);
+            }
+        }
+
+        if (!RLMSortRowsWithOrderedIndex(ar, table, pending, less)) {
+            RLMSortRows(table, ar->_sortOrder, pending, less);
+        }
+        std::vector<size_t> sorted;
+        sorted.reserve(count);
+        std::merge(kept.begin(), kept.end(), pending.begin(), pending.end(), std::back_inserter(sorted), less);
+
+        for (size_t i = 0; i < count; ++i) {
+            view.m_row_indexes.set(i, sorted[i]);
+        }
+    });
+
+    ar->_backingView = move(view);
+    ar->_viewCreated = YES;
+}
+
+// replace the rows in a view
+static void RLMSetViewRows(tightdb::TableView& view, std::vector<size_t> const& rows) {
+    view.m_row_indexes.clear();
+    for (size_t row : rows) {
+        view.m_row_indexes.add(row);
+    }
+}
+
+// the predicates the query for the results was built from, or nil if they
+// aren't known; results which aren't built from a query are all of the
+// objects in the table, so they have none
+static inline NSArray *RLMResultsPredicates(__unsafe_unretained RLMResults *const ar) {
+    return ar->_predicates ?: (ar->_backingQuery ? nil : @[]);
+}
+
+// whether the query for the results matches all of the objects in their table
+static inline bool RLMResultsQueryIsWholeTable(__unsafe_unretained RLMResults *const ar) {
+    return !ar->_backingQuery || (ar->_predicates.count == 0 && !ar->_linkView);
+}
+
+// the number of rows to find for limited results before skipping the offset
+static inline size_t RLMResultsLimitEnd(__unsafe_unretained RLMResults *const ar) {
+    return ar->_limit > size_t(-1) - ar->_offset ? size_t(-1) : ar->_offset + ar->_limit;
+}
+
+// Run the query for distinct or limited results. Unsorted limited results stop
+// the query once enough rows are found, while sorted results find all of the
+// rows but only sort the ones which are kept, using a partial sort which keeps
+// them in a bounded heap when they're a small part of the rows found and a full
+// sort by extracted keys otherwise. Distinct results of all of the objects in a table use
+// the search index for the column if it has one, and otherwise keep the first
+// row with each value found in a single pass over the rows.
+static void RLMResultsUpdateDistinctOrLimitedView(__unsafe_unretained RLMResults *const ar) {
+    size_t end = ar->_limited ? RLMResultsLimitEnd(ar) : size_t(-1);
+    bool sorted = !ar->_sortOrder.m_columns.empty();
+    tightdb::Table& table = *ar->_objectSchema.table;
+    bool useIndex = ar->_distinct && !sorted && RLMResultsQueryIsWholeTable(ar)
+                 && table.get_column_type(ar->_distinctColumn) == tightdb::type_String
+                 && table.has_search_index(ar->_distinctColumn);
+
+    tightdb::TableView view;
+    ar->_findAllDuration = RLMMeasureDuration([&] {
+        if (useIndex) {
+            view = table.get_distinct_view(ar->_distinctColumn);
+        }
+        else {
+            view = sorted || ar->_distinct ? RLMResultsFindAll(ar) : ar->_backingQuery->find_all(0, size_t(-1), end);
+        }
+    });
+
+    std::vector<size_t> rows;
+    rows.reserve(view.size());
+    for (size_t i = 0; i < view.size(); ++i) {
+        rows.push_back(view.get_source_ndx(i));
+    }
+    if (sorted) {
+        ar->_sortDuration = RLMMeasureDuration([&] {
+            RLMRowComparator less(table, ar->_sortOrder);
+            if (ar->_distinct) {
+                if (!RLMSortRowsWithOrderedIndex(ar, table, rows, less)) {
+                    RLMSortRows(table, ar->_sortOrder, rows, less);
+                }
+            }
+            else if (!RLMSortRowsWithOrderedIndex(ar, table, rows, less, end)) {
+                size_t count = std::min(end, rows.size());
+                if (count * RLMPartialSortRatio < rows.size()) {
+                    std::partial_sort(rows.begin(), rows.begin() + count, rows.end(), less);
+                }
+                else {
+                    RLMSortRows(table, ar->_sortOrder, rows, less);
+                }
+                rows.resize(count);
+            }
+        });
+    }
+    if (useIndex) {
+        // the distinct view is in the order of the index, and the row it has
+        // for each value is the first one with that value
+        std::sort(rows.begin(), rows.end());
+    }
+    else if (ar->_distinct) {
+        RLMDistinctRows(table, ar->_distinctColumn, rows);
+    }
+    if (ar->_limited) {
+        rows.resize(std::min(end, rows.size()));
+        rows.erase(rows.begin(), rows.begin() + std::min(ar->_offset, rows.size()));
+    }
+
+    // the distinct view isn't over the results' query, but it's never synced
+    // as this is run again whenever the view is out of sync
+    RLMSetViewRows(view, rows);
+    ar->_backingView = move(view);
+    ar->_viewCreated = YES;
+}
+
+// the number of rows found at a time by lazy results and when reading the rows
+// matching a query without creating a view
+static const size_t RLMLazyResultsChunkSize = 1000;
+
+// Results are only evaluated lazily if their objects are in the order of the
+// table and their query can be resumed from any row, which isn't the case for
+// sorted, distinct or limited results or queries over an RLMArray.
+static inline bool RLMResultsIsLazy(__unsafe_unretained RLMResults *const ar) {
+    return ar->_lazy && ar->_backingQuery && !ar->_linkView && ar->_sortOrder.m_columns.empty()
+        && !ar->_distinct && !ar->_limited;
+}
+
+// The table row of the object at the given index of lazy results, or not_found
+// if there are fewer objects. The chunk containing the index is found by
+// resuming the search from the start of the closest chunk before it whose
+// start is known, so reading the objects in order runs the query once, and
+// going back to an earlier object only searches the rows of its chunk. All of
+// the chunks are found again if the data changes.
+static size_t RLMLazyResultsRow(__unsafe_unretained RLMResults *const ar, size_t index) {
+    if (ar->_chunkStarts.empty() || !ar->_window.is_in_sync()) {
+        ar->_chunkStarts.assign(1, 0);
+        ar->_windowChunk = tightdb::not_found;
+    }
+
+    size_t chunk = index / RLMLazyResultsChunkSize;
+    if (chunk != ar->_windowChunk) {
+        size_t current = std::min(chunk, ar->_chunkStarts.size() - 1);
+        while (true) {
+            ar->_window = ar->_backingQuery->find_all(ar->_chunkStarts[current], size_t(-1), RLMLazyResultsChunkSize);
+            ar->_windowChunk = current;
+            size_t size = ar->_window.size();
+            if (size < RLMLazyResultsChunkSize) {
+                // there are no more objects after this chunk
+                break;
+            }
+            if (current + 1 == ar->_chunkStarts.size()) {
+                ar->_chunkStarts.push_back(ar->_window.get_source_ndx(size - 1) + 1);
+            }
+            if (current == chunk) {
+                break;
+            }
+            ++current;
+        }
+        if (current != chunk) {
+            return tightdb::not_found;
+        }
+    }
+
+    size_t offset = index - chunk * RLMLazyResultsChunkSize;
+    return offset < ar->_window.size() ? ar->_window.get_source_ndx(offset) : tightdb::not_found;
+}
+
 //
 // validation helper
 //
@@ -93,23 +932,62 @@ static inline void RLMResultsValidateAttached(__unsafe_unretained RLMResults *co
         if (!ar->_backingView.is_attached()) {
             @throw RLMException(@"RLMResults is no longer valid");
         }
-        ar->_backingView.sync_if_needed();
+        if (ar->_limited || ar->_distinct) {
+            if (!ar->_backingView.is_in_sync()) {
+                RLMResultsUpdateDistinctOrLimitedView(ar);
+            }
+        }
+        else if (ar->_sortOrder.m_columns.empty()) {
+            if (!ar->_viewHandedOver) {
+                ar->_backingView.sync_if_needed();
+            }
+            else if (!ar->_backingView.is_in_sync()) {
+                RLMResultsCreateView(ar);
+            }
+        }
+        else if (!ar->_backingView.is_in_sync()) {
+            RLMResultsUpdateSortedView(ar);
+        }
+    }
+    else if (RLMResultsIsLazy(ar)) {
+        // lazy results don't have a view, and only check the chunk of objects
+        // they last read
+        if (!ar->_chunkStarts.empty() && !ar->_window.is_attached()) {
+            @throw RLMException(@"RLMResults is no longer valid");
+        }
     }
     else if (ar->_backingQuery) {
         // create backing view if needed
-        ar->_backingView = ar->_backingQuery->find_all();
-        ar->_viewCreated = YES;
-        if (!ar->_sortOrder.m_columns.empty()) {
-            ar->_backingView.sort(ar->_sortOrder.m_columns, ar->_sortOrder.m_ascending);
+        if (ar->_limited || ar->_distinct) {
+            RLMResultsUpdateDistinctOrLimitedView(ar);
+        }
+        else if (!ar->_sortOrder.m_columns.empty()) {
+            RLMResultsUpdateSortedView(ar);
+        }
+        else {
+            RLMResultsCreateView(ar);
         }
     }
     // otherwise we're backed by a table and don't need to update anything
 }
+
+// the order of the results: either the sort applied by RLMResults, or the
+// order of a sorted view it was created with
+static inline RowIndexes::Sorter const& RLMResultsSortOrder(__unsafe_unretained RLMResults *const ar) {
+    return ar->_sortOrder.m_columns.empty() ? ar->_backingView.m_sorting_predicate : ar->_sortOrder;
+}
 static inline void RLMResultsValidate(__unsafe_unretained RLMResults *const ar) {
     RLMResultsValidateAttached(ar);
     RLMCheckThread(ar->_realm);
 }
 
+static inline void RLMResultsValidateNotDistinctOrLimited(__unsafe_unretained RLMResults *const ar) {
+    if (ar->_limited || ar->_distinct) {
+        @throw RLMException(@"Distinct and limited results cannot be filtered, sorted or made distinct. "
+                            @"Filter and sort the results before taking distinct values or limiting them.");
+    }
+}
+
 static inline void RLMResultsValidateInWriteTransaction(__unsafe_unretained RLMResults *const ar) {
     // first verify attached
     RLMResultsValidate(ar);
@@ -119,18 +997,201 @@ static inline void RLMResultsValidateInWriteTransaction(__unsafe_unretained RLMR
     }
 }
 
+// the table rows of the objects in the results, in order
+static BOOL RLMResultsGetRows(__unsafe_unretained RLMResults *const ar, std::vector<size_t>& rows) {
+    if (ar->_viewCreated && !ar->_backingView.is_attached()) {
+        return NO;
+    }
+    RLMResultsValidateAttached(ar);
+    NSUInteger count = ar.count;
+    rows.reserve(count);
+    for (NSUInteger i = 0; i < count; ++i) {
+        rows.push_back([ar indexInSource:i]);
+    }
+    return YES;
+}
+
+// Results can be evaluated by another realm if they are out of date and their
+// query can be run elsewhere. Lazy results are never evaluated up front.
+static bool RLMResultsCanEvaluateInBackground(__unsafe_unretained RLMResults *const ar) {
+    if (!RLMResultsCanRunQueryElsewhere(ar) || RLMResultsIsLazy(ar)) {
+        return false;
+    }
+    return !ar->_viewCreated || (ar->_backingView.is_attached() && !ar->_backingView.is_in_sync());
+}
+
+// the number of times background evaluation is retried when the data changes
+// while it's running before the results are evaluated on their own thread
+static const unsigned RLMMaxBackgroundEvaluationAttempts = 3;
+
+static void RLMPerformOnRunLoop(CFRunLoopRef runLoop, dispatch_block_t block) {
+    CFRunLoopPerformBlock(runLoop, kCFRunLoopCommonModes, block);
+    CFRunLoopWakeUp(runLoop);
+}
+
+// use rows found by a background realm reading the same version of the data
+// as the backing view of the results
+static void RLMResultsHandOverRows(__unsafe_unretained RLMResults *const ar, std::vector<size_t> const& rows) {
+    // an empty view of the table, filled in with the rows
+    tightdb::TableView view = ar->_objectSchema.table->where().find_all(0, size_t(-1), 0);
+    RLMSetViewRows(view, rows);
+    ar->_backingView = move(view);
+    ar->_viewCreated = YES;
+    ar->_viewHandedOver = YES;
+}
+
+// Run the query and sort for the results on a background queue against a new
+// instance of the realm, then hand the rows found back to the results on the
+// calling thread's run loop. The rows are only used if the calling thread's
+// realm is still reading the version of the data which was the latest when the
+// work was dispatched: if it hasn't moved to a different version and no newer
+// version exists, the background realm can only have read that version too.
+// Otherwise the work is retried, and eventually done on the calling thread.
+static void RLMResultsEvaluateAsync(RLMResults *ar, void (^completion)(RLMResults *), unsigned attempt) {
+    CFRunLoopRef runLoop = CFRunLoopGetCurrent();
+    if (attempt == RLMMaxBackgroundEvaluationAttempts || !RLMResultsCanEvaluateInBackground(ar)) {
+        RLMPerformOnRunLoop(runLoop, ^{
+            RLMResultsValidate(ar);
+            completion(ar);
+        });
+        return;
+    }
+
+    RLMRealm *(^openRealm)() = [ar->_realm backgroundRealmFactory];
+    NSString *className = ar->_objectClassName;
+    NSArray *predicates = ar->_predicates;
+    RowIndexes::Sorter sortOrder = ar->_sortOrder;
+    BOOL distinct = ar->_distinct, limited = ar->_limited;
+    size_t distinctColumn = ar->_distinctColumn, limit = ar->_limit, offset = ar->_offset;
+    uint64_t generation = ar->_realm.readGeneration;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        auto rows = std::make_shared<std::vector<size_t>>();
+        double findAllDuration = 0, sortDuration = 0;
+        bool found = false;
+        @autoreleasepool {
+            @try {
+                RLMRealm *realm = openRealm();
+                RLMResults *results = [RLMResults resultsWithObjectClassName:className
+                                                                       query:RLMQueryWithPredicates(realm, className, predicates)
+                                                                        sort:sortOrder realm:realm];
+                results->_distinct = distinct;
+                results->_distinctColumn = distinctColumn;
+                results->_limited = limited;
+                results->_limit = limit;
+                results->_offset = offset;
+                RLMResultsValidate(results);
+                found = RLMResultsGetRows(results, *rows);
+                findAllDuration = results->_findAllDuration;
+                sortDuration = results->_sortDuration;
+            }
+            @catch (NSException *) {
+                // evaluated on the calling thread instead
+            }
+        }
+
+        RLMPerformOnRunLoop(runLoop, ^{
+            if (!found) {
+                RLMResultsEvaluateAsync(ar, completion, RLMMaxBackgroundEvaluationAttempts);
+            }
+            else if (ar->_realm.readGeneration != generation || ![ar->_realm isReadingLatestVersion]) {
+                RLMResultsEvaluateAsync(ar, completion, attempt + 1);
+            }
+            else {
+                RLMResultsHandOverRows(ar, *rows);
+                ar->_findAllDuration = findAllDuration;
+                ar->_sortDuration = sortDuration;
+                completion(ar);
+            }
+        });
+    });
+}
+
+// Count the objects matching a single equality comparison between a string or
+// int property with a search index and a constant using the index, rather than
+// checking each object.
+static bool RLMResultsCountWithIndex(__unsafe_unretained RLMResults *const ar, size_t& count) {
+    if (ar->_linkView || ar->_predicates.count != 1 || ![ar->_predicates[0] isKindOfClass:[NSComparisonPredicate class]]) {
+        return false;
+    }
+    NSComparisonPredicate *predicate = ar->_predicates[0];
+    if (predicate.predicateOperatorType != NSEqualToPredicateOperatorType
+        || predicate.comparisonPredicateModifier != NSDirectPredicateModifier || predicate.options) {
+        return false;
+    }
+    NSExpression *keyPath = predicate.leftExpression, *value = predicate.rightExpression;
+    if (keyPath.expressionType == NSConstantValueExpressionType) {
+        std::swap(keyPath, value);
+    }
+    if (keyPath.expressionType != NSKeyPathExpressionType || value.expressionType != NSConstantValueExpressionType) {
+        return false;
+    }
+
+    RLMProperty *property = ar->_objectSchema[keyPath.keyPath];
+    tightdb::Table& table = *ar->_objectSchema.table;
+    if (!property || !table.has_search_index(property.column)) {
+        return false;
+    }
+    id constant = value.constantValue;
+    if (property.type == RLMPropertyTypeString && [constant isKindOfClass:[NSString class]]) {
+        count = table.count_string(property.column, RLMStringDataWithNSString(constant));
+        return true;
+    }
+    if (property.type == RLMPropertyTypeInt && [constant isKindOfClass:[NSNumber class]]
+        && [@([constant longLongValue]) isEqualToNumber:constant]) {
+        count = table.count_int(property.column, [constant longLongValue]);
+        return true;
+    }
+    return false;
+}
+
+// Count the objects matching the query for the results without creating a view
+// of them. The count is kept until the tables the query reads are changed, so
+// asking for it again after changes to other tables or without any changes
+// doesn't run the query.
+static size_t RLMResultsCountQuery(__unsafe_unretained RLMResults *const ar) {
+    if (ar->_countVersion.is_attached() && ar->_countVersion.is_in_sync()) {
+        return ar->_cachedCount;
+    }
+
+    size_t count;
+    if (!RLMResultsCountWithIndex(ar, count)) {
+        std::vector<size_t> counts;
+        bool parallel = RLMResultsRunInParallel(ar, counts, [](tightdb::Query& query, size_t start, size_t end) {
+            return query.count(start, end);
+        });
+        count = parallel ? std::accumulate(counts.begin(), counts.end(), size_t(0)) : ar->_backingQuery->count();
+    }
+    ar->_countVersion = ar->_backingQuery->find_all(0, 0, 0);
+    ar->_cachedCount = count;
+    return count;
+}
+
 //
 // public method implementations
 //
 - (NSUInteger)count {
+    RLMCheckThread(_realm);
     if (_viewCreated) {
+        if (!_backingView.is_attached()) {
+            @throw RLMException(@"RLMResults is no longer valid");
+        }
+        // an up to date view has the count, and otherwise the query is run
+        // without syncing the view until the objects are read
+        if (_backingView.is_in_sync() || _distinct || _linkView) {
+            RLMResultsValidate(self);
+            return _backingView.size();
+        }
+    }
+    else if (_distinct) {
         RLMResultsValidate(self);
         return _backingView.size();
     }
-    else {
-        RLMCheckThread(_realm);
-        return _backingQuery->count();
+
+    if (_limited) {
+        size_t count = _backingQuery->count(0, size_t(-1), RLMResultsLimitEnd(self));
+        return count > _offset ? count - _offset : 0;
     }
+    return RLMResultsCountQuery(self);
 }
 
 - (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
@@ -138,29 +1199,38 @@ static inline void RLMResultsValidateInWriteTransaction(__unsafe_unretained RLMR
                                     count:(NSUInteger)len {
     RLMResultsValidate(self);
 
+    // lazy results are enumerated until no more objects are found rather
+    // than counting them first
+    bool lazy = RLMResultsIsLazy(self);
     __autoreleasing RLMCArrayHolder *items;
     if (state->state == 0) {
         items = [[RLMCArrayHolder alloc] initWithSize:len];
         state->extra[0] = (long)items;
-        state->extra[1] = self.count;
+        state->extra[1] = lazy ? 0 : self.count;
     }
     else {
         // FIXME: mutationsPtr should be pointing to a value updated by core
         // whenever the results are changed rather than doing this check
-        if (state->extra[1] != self.count) {
+        if (lazy ? !_window.is_in_sync() : state->extra[1] != self.count) {
             @throw RLMException(@"Collection was mutated while being enumerated.");
         }
         items = (__bridge id)(void *)state->extra[0];
         [items resize:len];
     }
 
-    NSUInteger batchCount = 0, index = state->state, count = state->extra[1];
+    NSUInteger batchCount = 0, index = state->state, count = lazy ? NSUIntegerMax : state->extra[1];
 
     Class accessorClass = _objectSchema.accessorClass;
     while (index < count && batchCount < len) {
+        size_t row = [self indexInSource:index];
+        if (row == tightdb::not_found) {
+            break;
+        }
+        ++index;
+
         // get acessor fot the object class
         RLMObject *accessor = [[accessorClass alloc] initWithRealm:_realm schema:_objectSchema];
-        accessor->_row = (*_objectSchema.table)[[self indexInSource:index++]];
+        accessor->_row = (*_objectSchema.table)[row];
         items->array[batchCount] = accessor;
         buffer[batchCount] = accessor;
         batchCount++;
@@ -189,6 +1259,25 @@ static inline void RLMResultsValidateInWriteTransaction(__unsafe_unretained RLMR
 }
 
 - (NSUInteger)indexOfObjectWithPredicate:(NSPredicate *)predicate {
+    if (_limited || _distinct) {
+        // find the matching rows in the whole table and return the first of
+        // the results which is one of them
+        RLMResultsValidate(self);
+        tightdb::Query query = _objectSchema.table->where();
+        RLMUpdateQueryWithPredicate(&query, predicate, _realm.schema, _objectSchema);
+        tightdb::TableView matches = query.find_all();
+        std::unordered_set<size_t> rows;
+        for (size_t i = 0; i < matches.size(); ++i) {
+            rows.insert(matches.get_source_ndx(i));
+        }
+        for (size_t i = 0; i < _backingView.size(); ++i) {
+            if (rows.count(_backingView.get_source_ndx(i))) {
+                return i;
+            }
+        }
+        return NSNotFound;
+    }
+
     RLMResults *objects = [self objectsWithPredicate:predicate];
     if ([objects count] == 0) {
         return NSNotFound;
@@ -199,6 +1288,13 @@ static inline void RLMResultsValidateInWriteTransaction(__unsafe_unretained RLMR
 - (id)objectAtIndex:(NSUInteger)index {
     RLMResultsValidate(self);
 
+    if (RLMResultsIsLazy(self)) {
+        size_t row = RLMLazyResultsRow(self, index);
+        if (row == tightdb::not_found) {
+            @throw RLMException(@"Index is out of bounds.", @{@"index": @(index)});
+        }
+        return RLMCreateObjectAccessor(_realm, _objectSchema, row);
+    }
     if (index >= self.count) {
         @throw RLMException(@"Index is out of bounds.", @{@"index": @(index)});
     }
@@ -208,6 +1304,10 @@ static inline void RLMResultsValidateInWriteTransaction(__unsafe_unretained RLMR
 - (id)firstObject {
     RLMResultsValidate(self);
 
+    if (RLMResultsIsLazy(self)) {
+        size_t row = RLMLazyResultsRow(self, 0);
+        return row == tightdb::not_found ? nil : RLMCreateObjectAccessor(_realm, _objectSchema, row);
+    }
     if (self.count) {
         return [self objectAtIndex:0];
     }
@@ -231,6 +1331,20 @@ static inline void RLMResultsValidateInWriteTransaction(__unsafe_unretained RLMR
         @throw RLMException(@"RLMObject is no longer valid");
     }
 
+    if (RLMResultsIsLazy(self)) {
+        if (object->_row.get_table() != _objectSchema.table) {
+            @throw RLMException(@"Object type does not match RLMResults");
+        }
+
+        // the objects are in table order, so the index is the number of
+        // matching rows before the object's row
+        size_t row = object->_row.get_index();
+        if (_backingQuery->find(row) != row) {
+            return NSNotFound;
+        }
+        return _backingQuery->count(0, row);
+    }
+
     // check that object types align
     if (object->_row.get_table() != &_backingView.get_parent()) {
         @throw RLMException(@"Object type does not match RLMResults");
@@ -257,15 +1371,45 @@ static inline void RLMResultsValidateInWriteTransaction(__unsafe_unretained RLMR
 }
 
 - (RLMResults *)objectsWithPredicate:(NSPredicate *)predicate {
+    RLMResultsValidateNotDistinctOrLimited(self);
     RLMResultsValidate(self);
 
     // copy array and apply new predicate creating a new query and view
     auto query = [self cloneQuery];
     RLMUpdateQueryWithPredicate(query.get(), predicate, _realm.schema, _realm.schema[self.objectClassName]);
-    return [RLMResults resultsWithObjectClassName:self.objectClassName
-                                            query:move(query)
-                                             sort:_backingView.m_sorting_predicate
-                                            realm:_realm];
+    RLMResults *results = [RLMResults resultsWithObjectClassName:self.objectClassName
+                                                           query:move(query)
+                                                            sort:RLMResultsSortOrder(self)
+                                                           realm:_realm];
+    results->_parallel = _parallel;
+    results->_lazy = _lazy;
+    NSArray *predicates = RLMResultsPredicates(self);
+    [results setPredicates:predicate ? [(predicates ?: @[]) arrayByAddingObject:predicate] : predicates
+                  linkView:_linkView];
+    return results;
+}
+
+- (RLMPreparedQuery *)prepareQuery:(NSString *)predicateFormat {
+    RLMCheckThread(_realm);
+    RLMPreparedPredicate *predicate = RLMPreparePredicate(predicateFormat, _realm.schema,
+                                                          _realm.schema[_objectClassName]);
+    return [[RLMPreparedQuery alloc] initWithResults:self predicate:predicate];
+}
+
+- (RLMResults *)objectsWithPreparedPredicate:(RLMPreparedPredicate *)predicate arguments:(NSArray *)arguments {
+    RLMResultsValidateNotDistinctOrLimited(self);
+    RLMResultsValidate(self);
+
+    auto query = [self cloneQuery];
+    RLMUpdateQueryWithPreparedPredicate(query.get(), predicate, arguments);
+    RLMResults *results = [RLMResults resultsWithObjectClassName:self.objectClassName
+                                                           query:move(query)
+                                                            sort:RLMResultsSortOrder(self)
+                                                           realm:_realm];
+    results->_parallel = _parallel;
+    results->_lazy = _lazy;
+    [results setPredicates:[(_predicates ?: @[]) arrayByAddingObject:@[predicate, arguments]] linkView:_linkView];
+    return results;
 }
 
 - (RLMResults *)sortedResultsUsingProperty:(NSString *)property ascending:(BOOL)ascending {
@@ -273,17 +1417,154 @@ static inline void RLMResultsValidateInWriteTransaction(__unsafe_unretained RLMR
 }
 
 - (RLMResults *)sortedResultsUsingDescriptors:(NSArray *)properties {
+    RLMResultsValidateNotDistinctOrLimited(self);
     RLMResultsValidate(self);
 
-    auto query = [self cloneQuery];
-    RLMResults *r = [RLMResults resultsWithObjectClassName:self.objectClassName query:move(query) realm:_realm];
+    RowIndexes::Sorter sorter;
+    RLMGetColumnIndices(_realm.schema[self.objectClassName], properties, sorter.m_columns, sorter.m_ascending);
 
-    // attach new table view
-    RLMResultsValidateAttached(r);
-    RLMUpdateViewWithOrder(r->_backingView, _realm.schema[self.objectClassName], properties);
+    auto query = [self cloneQuery];
+    RLMResults *r = [RLMResults resultsWithObjectClassName:self.objectClassName query:move(query)
+                                                      sort:sorter realm:_realm];
+    r->_parallel = _parallel;
+    r->_lazy = _lazy;
+    [r setPredicates:RLMResultsPredicates(self) linkView:_linkView];
     return r;
 }
 
+// new results with the same objects as the given results
+static RLMResults *RLMResultsCopy(__unsafe_unretained RLMResults *const ar) {
+    RLMCheckThread(ar->_realm);
+
+    RLMResults *results = [RLMResults resultsWithObjectClassName:ar.objectClassName
+                                                           query:[ar cloneQuery]
+                                                            sort:RLMResultsSortOrder(ar)
+                                                           realm:ar->_realm];
+    results->_distinct = ar->_distinct;
+    results->_distinctColumn = ar->_distinctColumn;
+    results->_limited = ar->_limited;
+    results->_limit = ar->_limit;
+    results->_offset = ar->_offset;
+    results->_parallel = ar->_parallel;
+    results->_lazy = ar->_lazy;
+    [results setPredicates:RLMResultsPredicates(ar) linkView:ar->_linkView];
+    return results;
+}
+
+- (RLMResults *)resultsLimitedTo:(NSUInteger)limit offset:(NSUInteger)offset {
+    RLMCheckThread(_realm);
+
+    // limiting limited results limits them further
+    size_t newLimit = limit, newOffset = offset;
+    if (_limited) {
+        newLimit = std::min<size_t>(limit, offset < _limit ? _limit - offset : 0);
+        newOffset = offset > size_t(-1) - _offset ? size_t(-1) : _offset + offset;
+    }
+
+    // distinct results stay distinct when they're limited
+    RLMResults *results = RLMResultsCopy(self);
+    results->_limited = YES;
+    results->_limit = newLimit;
+    results->_offset = newOffset;
+    return results;
+}
+
+- (RLMResults *)distinctResultsUsingProperty:(NSString *)property {
+    RLMResultsValidateNotDistinctOrLimited(self);
+    RLMCheckThread(_realm);
+
+    size_t column = RLMValidatedColumnForGrouping(_objectSchema, property);
+    RLMResults *results = [RLMResults resultsWithObjectClassName:self.objectClassName
+                                                           query:[self cloneQuery]
+                                                            sort:RLMResultsSortOrder(self)
+                                                           realm:_realm];
+    results->_distinct = YES;
+    results->_distinctColumn = column;
+    results->_parallel = _parallel;
+    results->_lazy = _lazy;
+    [results setPredicates:RLMResultsPredicates(self) linkView:_linkView];
+    return results;
+}
+
+- (RLMResults *)resultsEvaluatedInParallel {
+    RLMResults *results = RLMResultsCopy(self);
+    results->_parallel = YES;
+    return results;
+}
+
+- (RLMResults *)resultsEvaluatedLazily {
+    RLMResults *results = RLMResultsCopy(self);
+    results->_lazy = YES;
+    return results;
+}
+
+- (NSDictionary *)groupedCountsByProperty:(NSString *)property {
+    RLMResultsValidate(self);
+
+    size_t column = RLMValidatedColumnForGrouping(_objectSchema, property);
+    tightdb::Table &table = *_objectSchema.table;
+    if (RLMResultsQueryIsWholeTable(self) && !_distinct && !_limited
+        && table.get_column_type(column) == tightdb::type_String && table.has_search_index(column)) {
+        // count the objects with each distinct value using the search index
+        tightdb::TableView distinct = table.get_distinct_view(column);
+        NSMutableDictionary *counts = [NSMutableDictionary dictionaryWithCapacity:distinct.size()];
+        for (size_t i = 0; i < distinct.size(); ++i) {
+            tightdb::StringData value = table.get_string(column, distinct.get_source_ndx(i));
+            counts[RLMStringDataToNSString(value)] = @(table.count_string(column, value));
+        }
+        return counts;
+    }
+
+    std::vector<size_t> rows;
+    RLMResultsGetRows(self, rows);
+    return RLMGroupedCounts(table, column, rows);
+}
+
+- (void)setPredicates:(NSArray *)predicates linkView:(tightdb::LinkViewRef)linkView {
+    _predicates = predicates;
+    _linkView = move(linkView);
+}
+
+- (NSString *)explain {
+    RLMResultsValidate(self);
+
+    NSMutableString *explanation = [NSMutableString stringWithFormat:@"RLMResults <0x%lx> of %@ (%lu objects)\n",
+                                                                     (long)self, _objectClassName, (unsigned long)self.count];
+    if (_backingQuery) {
+        [explanation appendFormat:@"find_all: %.3f ms\n", _findAllDuration * 1000.0];
+    }
+
+    auto const& sort = RLMResultsSortOrder(self);
+    if (!sort.m_columns.empty()) {
+        NSMutableArray *properties = [NSMutableArray arrayWithCapacity:sort.m_columns.size()];
+        for (size_t i = 0; i < sort.m_columns.size(); ++i) {
+            [properties addObject:[NSString stringWithFormat:@"%@ %@", RLMColumnName(_objectSchema, sort.m_columns[i]),
+                                   sort.m_ascending[i] ? @"ascending" : @"descending"]];
+        }
+        [explanation appendFormat:@"sort by %@: %.3f ms\n", [properties componentsJoinedByString:@", "],
+                                  _sortDuration * 1000.0];
+    }
+    if (_distinct) {
+        [explanation appendFormat:@"distinct %@\n", RLMColumnName(_objectSchema, _distinctColumn)];
+    }
+    if (_limited) {
+        [explanation appendFormat:@"limit %zu offset %zu\n", _limit, _offset];
+    }
+
+    tightdb::Table &table = *_objectSchema.table;
+    tightdb::Query query = _linkView ? table.where(_linkView) : table.where();
+    [explanation appendFormat:@"%@ (%zu objects)\n", _linkView ? @"objects in RLMArray" : @"all objects", query.count()];
+    for (id predicate in _predicates) {
+        if (NSArray *prepared = RLMDynamicCast<NSArray>(predicate)) {
+            RLMExplainPreparedPredicate(explanation, query, prepared[0], prepared[1]);
+        }
+        else {
+            RLMExplainPredicate(explanation, query, predicate, _realm.schema, _objectSchema);
+        }
+    }
+    return explanation;
+}
+
 - (id)objectAtIndexedSubscript:(NSUInteger)index {
     return [self objectAtIndex:index];
 }
@@ -315,102 +1596,571 @@ static id minOfProperty(TableType const& table, RLMRealm *realm, NSString *objec
     }
 }
 
-- (id)minOfProperty:(NSString *)property {
-    RLMResultsValidate(self);
-    return minOfProperty(_backingView, _realm, _objectClassName, property);
+template<typename TableType>
+static id maxOfProperty(TableType const& table, RLMRealm *realm, NSString *objectClassName, NSString *property) {
+    if (table.size() == 0) {
+        return nil;
+    }
+
+    NSUInteger colIndex = RLMValidatedColumnIndex(realm.schema[objectClassName], property);
+    RLMPropertyType colType = RLMPropertyType(table.get_column_type(colIndex));
+
+    switch (colType) {
+        case RLMPropertyTypeInt:
+            return @(table.maximum_int(colIndex));
+        case RLMPropertyTypeDouble:
+            return @(table.maximum_double(colIndex));
+        case RLMPropertyTypeFloat:
+            return @(table.maximum_float(colIndex));
+        case RLMPropertyTypeDate: {
+            tightdb::DateTime dt = table.maximum_datetime(colIndex);
+            return [NSDate dateWithTimeIntervalSince1970:dt.get_datetime()];
+        }
+        default:
+            @throw [NSException exceptionWithName:@"RLMOperationNotSupportedException"
+                                           reason:@"maxOfProperty only supported for int, float, double and date properties."
+                                         userInfo:nil];
+    }
+}
+
+template<typename TableType>
+static NSNumber *sumOfProperty(TableType const& table, RLMRealm *realm, NSString *objectClassName, NSString *property) {
+    if (table.size() == 0) {
+        return @0;
+    }
+
+    NSUInteger colIndex = RLMValidatedColumnIndex(realm.schema[objectClassName], property);
+    RLMPropertyType colType = RLMPropertyType(table.get_column_type(colIndex));
+
+    switch (colType) {
+        case RLMPropertyTypeInt:
+            return @(table.sum_int(colIndex));
+        case RLMPropertyTypeDouble:
+            return @(table.sum_double(colIndex));
+        case RLMPropertyTypeFloat:
+            return @(table.sum_float(colIndex));
+        default:
+            @throw [NSException exceptionWithName:@"RLMOperationNotSupportedException"
+                                           reason:@"sumOfProperty only supported for int, float and double properties."
+                                         userInfo:nil];
+    }
 }
 
-template<typename TableType>
-static id maxOfProperty(TableType const& table, RLMRealm *realm, NSString *objectClassName, NSString *property) {
-    if (table.size() == 0) {
-        return nil;
+template<typename TableType>
+static NSNumber *averageOfProperty(TableType const& table, RLMRealm *realm, NSString *objectClassName, NSString *property) {
+    if (table.size() == 0) {
+        return nil;
+    }
+
+    NSUInteger colIndex = RLMValidatedColumnIndex(realm.schema[objectClassName], property);
+    RLMPropertyType colType = RLMPropertyType(table.get_column_type(colIndex));
+
+    switch (colType) {
+        case RLMPropertyTypeInt:
+            return @(table.average_int(colIndex));
+        case RLMPropertyTypeDouble:
+            return @(table.average_double(colIndex));
+        case RLMPropertyTypeFloat:
+            return @(table.average_float(colIndex));
+        default:
+            @throw [NSException exceptionWithName:@"RLMOperationNotSupportedException"
+                                           reason:@"averageOfProperty only supported for int, float and double properties."
+                                         userInfo:nil];
+    }
+}
+
+// Aggregates over key paths through links and RLMArray properties are
+// computed in a single pass over the rows matched by the query, following the
+// links from each row as it's found, so that no TableView of the matches has
+// to be built. Aggregates over top-level properties are computed by the query
+// itself when there is no up-to-date view to compute them over.
+enum class RLMAggregate { Min, Max, Sum, Average };
+
+static void RLMValidateAggregateType(RLMAggregate aggregate, RLMPropertyType type) {
+    switch (type) {
+        case RLMPropertyTypeInt:
+        case RLMPropertyTypeDouble:
+        case RLMPropertyTypeFloat:
+            return;
+        case RLMPropertyTypeDate:
+            if (aggregate == RLMAggregate::Min || aggregate == RLMAggregate::Max) {
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+
+    NSString *reason;
+    switch (aggregate) {
+        case RLMAggregate::Min:
+            reason = @"minOfProperty only supported for int, float, double and date properties.";
+            break;
+        case RLMAggregate::Max:
+            reason = @"maxOfProperty only supported for int, float, double and date properties.";
+            break;
+        case RLMAggregate::Sum:
+            reason = @"sumOfProperty only supported for int, float and double properties.";
+            break;
+        case RLMAggregate::Average:
+            reason = @"averageOfProperty only supported for int, float and double properties.";
+            break;
+    }
+    @throw [NSException exceptionWithName:@"RLMOperationNotSupportedException" reason:reason userInfo:nil];
+}
+
+// a link or RLMArray property followed by a key path, and the table it links to
+struct RLMAggregateLink {
+    size_t column;
+    bool isList;
+    tightdb::TableRef target;
+};
+
+struct RLMAggregateKeyPath {
+    std::vector<RLMAggregateLink> links;
+    // the property aggregated over, in the objects at the end of the links
+    RLMObjectSchema *objectSchema;
+    NSString *property;
+};
+
+static RLMAggregateKeyPath RLMValidatedAggregateKeyPath(RLMRealm *realm, RLMObjectSchema *objectSchema, NSString *keyPath) {
+    RLMAggregateKeyPath path;
+    NSArray *components = [keyPath componentsSeparatedByString:@"."];
+    for (NSUInteger i = 0; i + 1 < components.count; ++i) {
+        RLMProperty *prop = objectSchema[components[i]];
+        if (!prop) {
+            @throw RLMException([NSString stringWithFormat:@"Property '%@' in key path '%@' not found in objects of type '%@'",
+                                                           components[i], keyPath, objectSchema.className]);
+        }
+        if (prop.type != RLMPropertyTypeObject && prop.type != RLMPropertyTypeArray) {
+            @throw RLMException([NSString stringWithFormat:@"Property '%@' in key path '%@' is not a link or RLMArray property",
+                                                           components[i], keyPath]);
+        }
+        path.links.push_back({prop.column, prop.type == RLMPropertyTypeArray,
+                              objectSchema.table->get_link_target(prop.column)});
+        objectSchema = realm.schema[prop.objectClassName];
+    }
+    path.objectSchema = objectSchema;
+    path.property = components.lastObject;
+    return path;
+}
+
+// call func with the table and row of each object reached by following links
+// from the given row, once per occurrence in the RLMArray properties followed
+template<typename Func>
+static void RLMForEachLinkedRow(tightdb::Table& table, size_t row, std::vector<RLMAggregateLink> const& links,
+                                size_t depth, Func&& func) {
+    if (depth == links.size()) {
+        func(table, row);
+        return;
+    }
+
+    RLMAggregateLink const& link = links[depth];
+    if (link.isList) {
+        tightdb::LinkViewRef linkView = table.get_linklist(link.column, row);
+        for (size_t i = 0; i < linkView->size(); ++i) {
+            RLMForEachLinkedRow(*link.target, linkView->get(i).get_index(), links, depth + 1, func);
+        }
+    }
+    else if (!table.is_null_link(link.column, row)) {
+        RLMForEachLinkedRow(*link.target, table.get_link(link.column, row), links, depth + 1, func);
+    }
+}
+
+// Call func with the table row of each object in the results, reading the
+// rows from the view if useView is set and otherwise from the query as it
+// finds them. The query finds a chunk of rows at a time, as each search sets
+// up all of its conditions again, which for conditions using an index or
+// following links means redoing their lookups.
+template<typename Func>
+static void RLMResultsForEachRow(__unsafe_unretained RLMResults *const ar, bool useView, Func&& func) {
+    if (useView) {
+        for (size_t i = 0; i < ar->_backingView.size(); ++i) {
+            func(ar->_backingView.get_source_ndx(i));
+        }
+    }
+    else if (!ar->_backingQuery) {
+        for (size_t row = 0, size = ar->_objectSchema.table->size(); row < size; ++row) {
+            func(row);
+        }
+    }
+    else {
+        tightdb::Query& query = *ar->_backingQuery;
+        for (size_t start = 0; ; ) {
+            tightdb::TableView chunk = query.find_all(start, size_t(-1), RLMLazyResultsChunkSize);
+            size_t size = chunk.size();
+            for (size_t i = 0; i < size; ++i) {
+                func(chunk.get_source_ndx(i));
+            }
+            if (size < RLMLazyResultsChunkSize) {
+                break;
+            }
+            start = chunk.get_source_ndx(size - 1) + 1;
+        }
+    }
+}
+
+// the count, minimum, maximum and sum of the values added to it
+template<typename T, typename Sum>
+struct RLMRunningAggregate {
+    size_t count = 0;
+    T min = T(), max = T();
+    Sum sum = Sum();
+
+    void add(T value) {
+        if (count == 0 || value < min) {
+            min = value;
+        }
+        if (count == 0 || max < value) {
+            max = value;
+        }
+        sum += value;
+        ++count;
+    }
+};
+
+template<typename T, typename Sum, typename Get, typename ToObject>
+static id RLMStreamingAggregate(__unsafe_unretained RLMResults *const ar, bool useView, RLMAggregateKeyPath const& path,
+                                size_t column, RLMAggregate aggregate, Get get, ToObject toObject) {
+    RLMRunningAggregate<T, Sum> result;
+    RLMResultsForEachRow(ar, useView, [&](size_t row) {
+        RLMForEachLinkedRow(*ar->_objectSchema.table, row, path.links, 0, [&](tightdb::Table& table, size_t targetRow) {
+            result.add(get(table, column, targetRow));
+        });
+    });
+
+    if (aggregate == RLMAggregate::Sum) {
+        return @(result.sum);
+    }
+    if (result.count == 0) {
+        return nil;
+    }
+    if (aggregate == RLMAggregate::Average) {
+        return @(double(result.sum) / result.count);
+    }
+    return toObject(aggregate == RLMAggregate::Min ? result.min : result.max);
+}
+
+// check the thread and that the results are still valid, and return whether
+// the rows to aggregate over should be read from the view rather than the query.
+// distinct and limited results and results from RLMArrays need their view
+// to know which rows they contain; other results only use their view if
+// it's already up to date rather than re-running find_all()
+static bool RLMResultsValidateForAggregate(__unsafe_unretained RLMResults *const ar) {
+    RLMCheckThread(ar->_realm);
+    if (ar->_viewCreated && !ar->_backingView.is_attached()) {
+        @throw RLMException(@"RLMResults is no longer valid");
+    }
+
+    bool useView = ar->_limited || ar->_distinct || ar->_linkView
+                || (ar->_viewCreated && ar->_backingView.is_in_sync());
+    if (useView) {
+        RLMResultsValidateAttached(ar);
+    }
+    return useView;
+}
+
+// Aggregate over the rows matching the query in parallel, combining the
+// aggregate of each range of rows with the number of rows it was taken over.
+// func(query, start, end, &count) takes the minimum or maximum for Min and Max
+// and the sum otherwise.
+template<typename T, typename Sum, typename Func>
+static bool RLMResultsAggregateInParallel(__unsafe_unretained RLMResults *const ar, RLMAggregate aggregate,
+                                          Func func, id& result) {
+    std::vector<std::pair<Sum, size_t>> partials;
+    bool parallel = RLMResultsRunInParallel(ar, partials, [&](tightdb::Query& query, size_t start, size_t end) {
+        size_t count = 0;
+        Sum value = func(query, start, end, &count);
+        return std::make_pair(value, count);
+    });
+    if (!parallel) {
+        return false;
+    }
+
+    Sum total = 0, best = 0;
+    size_t count = 0;
+    for (auto const& partial : partials) {
+        if (partial.second == 0) {
+            continue;
+        }
+        if (count == 0) {
+            best = partial.first;
+        }
+        else if (aggregate == RLMAggregate::Min ? partial.first < best : partial.first > best) {
+            best = partial.first;
+        }
+        total += partial.first;
+        count += partial.second;
     }
 
-    NSUInteger colIndex = RLMValidatedColumnIndex(realm.schema[objectClassName], property);
-    RLMPropertyType colType = RLMPropertyType(table.get_column_type(colIndex));
+    switch (aggregate) {
+        case RLMAggregate::Sum: result = @(total); break;
+        case RLMAggregate::Average: result = count ? @(double(total) / count) : nil; break;
+        default: result = count ? @(T(best)) : nil; break;
+    }
+    return true;
+}
 
-    switch (colType) {
+static bool RLMResultsAggregateQueryInParallel(__unsafe_unretained RLMResults *const ar, RLMPropertyType type,
+                                               size_t column, RLMAggregate aggregate, id& result) {
+    switch (type) {
         case RLMPropertyTypeInt:
-            return @(table.maximum_int(colIndex));
-        case RLMPropertyTypeDouble:
-            return @(table.maximum_double(colIndex));
+            return RLMResultsAggregateInParallel<int64_t, int64_t>(ar, aggregate,
+                [=](tightdb::Query& query, size_t start, size_t end, size_t *count) {
+                    switch (aggregate) {
+                        case RLMAggregate::Min: return query.minimum_int(column, count, start, end);
+                        case RLMAggregate::Max: return query.maximum_int(column, count, start, end);
+                        default: return query.sum_int(column, count, start, end);
+                    }
+                }, result);
         case RLMPropertyTypeFloat:
-            return @(table.maximum_float(colIndex));
-        case RLMPropertyTypeDate: {
-            tightdb::DateTime dt = table.maximum_datetime(colIndex);
-            return [NSDate dateWithTimeIntervalSince1970:dt.get_datetime()];
-        }
+            return RLMResultsAggregateInParallel<float, double>(ar, aggregate,
+                [=](tightdb::Query& query, size_t start, size_t end, size_t *count) -> double {
+                    switch (aggregate) {
+                        case RLMAggregate::Min: return query.minimum_float(column, count, start, end);
+                        case RLMAggregate::Max: return query.maximum_float(column, count, start, end);
+                        default: return query.sum_float(column, count, start, end);
+                    }
+                }, result);
+        case RLMPropertyTypeDouble:
+            return RLMResultsAggregateInParallel<double, double>(ar, aggregate,
+                [=](tightdb::Query& query, size_t start, size_t end, size_t *count) {
+                    switch (aggregate) {
+                        case RLMAggregate::Min: return query.minimum_double(column, count, start, end);
+                        case RLMAggregate::Max: return query.maximum_double(column, count, start, end);
+                        default: return query.sum_double(column, count, start, end);
+                    }
+                }, result);
         default:
-            @throw [NSException exceptionWithName:@"RLMOperationNotSupportedException"
-                                           reason:@"maxOfProperty only supported for int, float, double and date properties."
-                                         userInfo:nil];
+            return false;
     }
 }
 
-- (id)maxOfProperty:(NSString *)property {
-    RLMResultsValidate(self);
-    return maxOfProperty(_backingView, _realm, _objectClassName, property);
-}
+static id RLMResultsAggregate(__unsafe_unretained RLMResults *const ar, NSString *keyPath, RLMAggregate aggregate) {
+    bool useView = RLMResultsValidateForAggregate(ar);
+    RLMAggregateKeyPath path = RLMValidatedAggregateKeyPath(ar->_realm, ar->_objectSchema, keyPath);
+    size_t column = RLMValidatedColumnIndex(path.objectSchema, path.property);
+    RLMPropertyType type = path.objectSchema[path.property].type;
+    RLMValidateAggregateType(aggregate, type);
+
+    if (path.links.empty()) {
+        if (useView || !ar->_backingQuery) {
+            auto aggregateTable = [&](auto const& table) -> id {
+                switch (aggregate) {
+                    case RLMAggregate::Min: return minOfProperty(table, ar->_realm, ar->_objectClassName, keyPath);
+                    case RLMAggregate::Max: return maxOfProperty(table, ar->_realm, ar->_objectClassName, keyPath);
+                    case RLMAggregate::Sum: return sumOfProperty(table, ar->_realm, ar->_objectClassName, keyPath);
+                    case RLMAggregate::Average: return averageOfProperty(table, ar->_realm, ar->_objectClassName, keyPath);
+                }
+            };
+            return useView ? aggregateTable(ar->_backingView) : aggregateTable(*ar->_objectSchema.table);
+        }
 
-template<typename TableType>
-static NSNumber *sumOfProperty(TableType const& table, RLMRealm *realm, NSString *objectClassName, NSString *property) {
-    if (table.size() == 0) {
-        return @0;
-    }
+        id parallelResult;
+        if (RLMResultsAggregateQueryInParallel(ar, type, column, aggregate, parallelResult)) {
+            return parallelResult;
+        }
 
-    NSUInteger colIndex = RLMValidatedColumnIndex(realm.schema[objectClassName], property);
-    RLMPropertyType colType = RLMPropertyType(table.get_column_type(colIndex));
+        tightdb::Query& query = *ar->_backingQuery;
+        size_t count = 0;
+        auto result = [&](auto value) -> id { return count ? @(value) : nil; };
+        switch (type) {
+            case RLMPropertyTypeInt:
+                switch (aggregate) {
+                    case RLMAggregate::Min: return result(query.minimum_int(column, &count));
+                    case RLMAggregate::Max: return result(query.maximum_int(column, &count));
+                    case RLMAggregate::Sum: return @(query.sum_int(column));
+                    case RLMAggregate::Average: return result(query.average_int(column, &count));
+                }
+            case RLMPropertyTypeFloat:
+                switch (aggregate) {
+                    case RLMAggregate::Min: return result(query.minimum_float(column, &count));
+                    case RLMAggregate::Max: return result(query.maximum_float(column, &count));
+                    case RLMAggregate::Sum: return @(query.sum_float(column));
+                    case RLMAggregate::Average: return result(query.average_float(column, &count));
+                }
+            case RLMPropertyTypeDouble:
+                switch (aggregate) {
+                    case RLMAggregate::Min: return result(query.minimum_double(column, &count));
+                    case RLMAggregate::Max: return result(query.maximum_double(column, &count));
+                    case RLMAggregate::Sum: return @(query.sum_double(column));
+                    case RLMAggregate::Average: return result(query.average_double(column, &count));
+                }
+            default:
+                // dates are aggregated by the streaming pass below
+                break;
+        }
+    }
 
-    switch (colType) {
+    switch (type) {
         case RLMPropertyTypeInt:
-            return @(table.sum_int(colIndex));
-        case RLMPropertyTypeDouble:
-            return @(table.sum_double(colIndex));
+            return RLMStreamingAggregate<int64_t, int64_t>(ar, useView, path, column, aggregate,
+                [](tightdb::Table& table, size_t col, size_t row) { return table.get_int(col, row); },
+                [](int64_t value) -> id { return @(value); });
         case RLMPropertyTypeFloat:
-            return @(table.sum_float(colIndex));
+            return RLMStreamingAggregate<float, double>(ar, useView, path, column, aggregate,
+                [](tightdb::Table& table, size_t col, size_t row) { return table.get_float(col, row); },
+                [](float value) -> id { return @(value); });
+        case RLMPropertyTypeDouble:
+            return RLMStreamingAggregate<double, double>(ar, useView, path, column, aggregate,
+                [](tightdb::Table& table, size_t col, size_t row) { return table.get_double(col, row); },
+                [](double value) -> id { return @(value); });
         default:
-            @throw [NSException exceptionWithName:@"RLMOperationNotSupportedException"
-                                           reason:@"sumOfProperty only supported for int, float and double properties."
-                                         userInfo:nil];
+            return RLMStreamingAggregate<time_t, double>(ar, useView, path, column, aggregate,
+                [](tightdb::Table& table, size_t col, size_t row) { return table.get_datetime(col, row).get_datetime(); },
+                [](time_t value) -> id { return [NSDate dateWithTimeIntervalSince1970:value]; });
     }
 }
 
+- (id)minOfProperty:(NSString *)property {
+    return RLMResultsAggregate(self, property, RLMAggregate::Min);
+}
+
+- (id)maxOfProperty:(NSString *)property {
+    return RLMResultsAggregate(self, property, RLMAggregate::Max);
+}
+
 -(NSNumber *)sumOfProperty:(NSString *)property {
-    RLMResultsValidate(self);
-    return sumOfProperty(_backingView, _realm, _objectClassName, property);
+    return RLMResultsAggregate(self, property, RLMAggregate::Sum);
 }
 
-template<typename TableType>
-static NSNumber *averageOfProperty(TableType const& table, RLMRealm *realm, NSString *objectClassName, NSString *property) {
-    if (table.size() == 0) {
-        return nil;
+-(NSNumber *)averageOfProperty:(NSString *)property {
+    return RLMResultsAggregate(self, property, RLMAggregate::Average);
+}
+
+// the statistics for one property in -statisticsForProperties:, which are
+// accumulated as int64_t for int and date properties and as double for float
+// and double properties
+struct RLMPropertyStatistics {
+    RLMAggregateKeyPath path;
+    size_t column;
+    RLMPropertyType type;
+    RLMRunningAggregate<int64_t, int64_t> ints;
+    RLMRunningAggregate<double, double> doubles;
+
+    void add(tightdb::Table& table, size_t row) {
+        switch (type) {
+            case RLMPropertyTypeInt:
+                ints.add(table.get_int(column, row));
+                break;
+            case RLMPropertyTypeDate:
+                ints.add(table.get_datetime(column, row).get_datetime());
+                break;
+            case RLMPropertyTypeFloat:
+                doubles.add(table.get_float(column, row));
+                break;
+            default:
+                doubles.add(table.get_double(column, row));
+                break;
+        }
     }
+};
 
-    NSUInteger colIndex = RLMValidatedColumnIndex(realm.schema[objectClassName], property);
-    RLMPropertyType colType = RLMPropertyType(table.get_column_type(colIndex));
+template<typename T, typename Sum, typename ToObject>
+static NSDictionary *RLMStatisticsDictionary(RLMRunningAggregate<T, Sum> const& aggregate, bool hasSum, ToObject toObject) {
+    NSMutableDictionary *statistics = [NSMutableDictionary dictionaryWithObject:@(aggregate.count) forKey:@"count"];
+    if (hasSum) {
+        statistics[@"sum"] = @(aggregate.sum);
+    }
+    if (aggregate.count) {
+        statistics[@"min"] = toObject(aggregate.min);
+        statistics[@"max"] = toObject(aggregate.max);
+        if (hasSum) {
+            statistics[@"average"] = @(double(aggregate.sum) / aggregate.count);
+        }
+    }
+    return statistics;
+}
 
-    switch (colType) {
-        case RLMPropertyTypeInt:
-            return @(table.average_int(colIndex));
-        case RLMPropertyTypeDouble:
-            return @(table.average_double(colIndex));
-        case RLMPropertyTypeFloat:
-            return @(table.average_float(colIndex));
-        default:
+- (NSDictionary *)statisticsForProperties:(NSArray *)properties {
+    bool useView = RLMResultsValidateForAggregate(self);
+
+    std::vector<RLMPropertyStatistics> statistics;
+    statistics.reserve(properties.count);
+    for (NSString *property in properties) {
+        RLMAggregateKeyPath path = RLMValidatedAggregateKeyPath(_realm, _objectSchema, property);
+        size_t column = RLMValidatedColumnIndex(path.objectSchema, path.property);
+        RLMPropertyType type = path.objectSchema[path.property].type;
+        if (type != RLMPropertyTypeInt && type != RLMPropertyTypeFloat &&
+            type != RLMPropertyTypeDouble && type != RLMPropertyTypeDate) {
             @throw [NSException exceptionWithName:@"RLMOperationNotSupportedException"
-                                           reason:@"averageOfProperty only supported for int, float and double properties."
+                                           reason:@"statisticsForProperties only supported for int, float, double and date properties."
                                          userInfo:nil];
+        }
+        statistics.push_back({move(path), column, type, {}, {}});
+    }
+
+    // a single pass over the results, updating the statistics for every
+    // property from each object
+    tightdb::Table& table = *_objectSchema.table;
+    RLMResultsForEachRow(self, useView, [&](size_t row) {
+        for (auto& property : statistics) {
+            RLMForEachLinkedRow(table, row, property.path.links, 0, [&](tightdb::Table& target, size_t targetRow) {
+                property.add(target, targetRow);
+            });
+        }
+    });
+
+    NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:properties.count];
+    for (NSUInteger i = 0; i < properties.count; ++i) {
+        RLMPropertyStatistics const& property = statistics[i];
+        switch (property.type) {
+            case RLMPropertyTypeInt:
+                result[properties[i]] = RLMStatisticsDictionary(property.ints, true, [](int64_t value) -> id {
+                    return @(value);
+                });
+                break;
+            case RLMPropertyTypeDate:
+                result[properties[i]] = RLMStatisticsDictionary(property.ints, false, [](int64_t value) -> id {
+                    return [NSDate dateWithTimeIntervalSince1970:value];
+                });
+                break;
+            case RLMPropertyTypeFloat:
+                result[properties[i]] = RLMStatisticsDictionary(property.doubles, true, [](double value) -> id {
+                    return @(float(value));
+                });
+                break;
+            default:
+                result[properties[i]] = RLMStatisticsDictionary(property.doubles, true, [](double value) -> id {
+                    return @(value);
+                });
+                break;
+        }
     }
+    return result;
 }
 
--(NSNumber *)averageOfProperty:(NSString *)property {
+- (void)evaluateAsync:(void (^)(RLMResults *results))completion {
+    RLMCheckThread(_realm);
+    if (!completion) {
+        @throw RLMException(@"The completion block should not be nil");
+    }
+    RLMResultsEvaluateAsync(self, completion, 0);
+}
+
+- (RLMNotificationToken *)addNotificationBlock:(RLMCollectionNotificationBlock)block {
     RLMResultsValidate(self);
-    return averageOfProperty(_backingView, _realm, _objectClassName, property);
+    tightdb::Table *listOrigin = _linkView ? &_linkView->get_origin_table() : nullptr;
+    return RLMAddCollectionNotificationBlock(self, _objectSchema, listOrigin, block, ^BOOL(std::vector<size_t>& rows) {
+        return RLMResultsGetRows(self, rows);
+    });
 }
 
 - (void)deleteObjectsFromRealm {
     RLMResultsValidateInWriteTransaction(self);
 
+    // the objects' index postings have to be found while their rows still exist
+    if (RLMObjectSchemaHasIndexes(_objectSchema)) {
+        std::vector<size_t> rows;
+        RLMResultsGetRows(self, rows);
+        RLMRemoveFromIndexes(_realm, _objectSchema, rows);
+    }
+
+    if (RLMResultsIsLazy(self)) {
+        _backingQuery->remove();
+        return;
+    }
+
     // call clear to remove all from the realm
     _backingView.clear();
 }
@@ -460,6 +2210,9 @@ static NSNumber *averageOfProperty(TableType const& table, RLMRealm *realm, NSSt
 }
 
 - (NSUInteger)indexInSource:(NSUInteger)index {
+    if (RLMResultsIsLazy(self)) {
+        return RLMLazyResultsRow(self, index);
+    }
     return _backingView.get_source_ndx(index);
 }
 
@@ -497,29 +2250,10 @@ static NSNumber *averageOfProperty(TableType const& table, RLMRealm *realm, NSSt
     return ndx == tightdb::not_found ? NSNotFound : ndx;
 }
 
-- (id)minOfProperty:(NSString *)property {
-    RLMCheckThread(_realm);
-    return minOfProperty(*_table, _realm, _objectClassName, property);
-}
-
-- (id)maxOfProperty:(NSString *)property {
-    RLMCheckThread(_realm);
-    return maxOfProperty(*_table, _realm, _objectClassName, property);
-}
-
-- (NSNumber *)sumOfProperty:(NSString *)property {
-    RLMCheckThread(_realm);
-    return sumOfProperty(*_table, _realm, _objectClassName, property);
-}
-
-- (NSNumber *)averageOfProperty:(NSString *)property {
-    RLMCheckThread(_realm);
-    return averageOfProperty(*_table, _realm, _objectClassName, property);
-}
-
 - (void)deleteObjectsFromRealm {
     RLMResultsValidateInWriteTransaction(self);
     _table->clear();
+    RLMClearIndexes(_realm, _objectSchema);
 }
 
 - (std::unique_ptr<Query>)cloneQuery {
@@ -565,13 +2299,431 @@ static NSNumber *averageOfProperty(TableType const& table, RLMRealm *realm, NSSt
     return self;
 }
 
+- (RLMResults *)objectsWithPreparedPredicate:(RLMPreparedPredicate *)predicate arguments:(NSArray *)arguments {
+    return self;
+}
+
 - (RLMResults *)sortedResultsUsingDescriptors:(NSArray *)properties {
     return self;
 }
 
+- (RLMResults *)resultsLimitedTo:(NSUInteger)limit offset:(NSUInteger)offset {
+    return self;
+}
+
+- (RLMResults *)distinctResultsUsingProperty:(NSString *)property {
+    return self;
+}
+
+- (RLMResults *)resultsEvaluatedInParallel {
+    return self;
+}
+
+- (RLMResults *)resultsEvaluatedLazily {
+    return self;
+}
+
+- (NSDictionary *)groupedCountsByProperty:(NSString *)property {
+    return @{};
+}
+
+- (id)minOfProperty:(NSString *)property {
+    return nil;
+}
+
+- (id)maxOfProperty:(NSString *)property {
+    return nil;
+}
+
+- (NSNumber *)sumOfProperty:(NSString *)property {
+    return @0;
+}
+
+- (NSNumber *)averageOfProperty:(NSString *)property {
+    return nil;
+}
+
+- (NSDictionary *)statisticsForProperties:(NSArray *)properties {
+    NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:properties.count];
+    for (NSString *property in properties) {
+        result[property] = @{@"count": @0};
+    }
+    return result;
+}
+
 #pragma clang diagnostic pop
 
 - (void)deleteObjectsFromRealm {
 }
 
+- (NSString *)explain {
+    return [NSString stringWithFormat:@"RLMResults <0x%lx> of %@ (0 objects)\nno table\n",
+                                      (long)self, _objectClassName];
+}
+
+@end
+
+@implementation RLMPreparedQuery {
+    RLMResults *_results;
+    RLMPreparedPredicate *_predicate;
+}
+
+- (instancetype)initWithResults:(RLMResults *)results predicate:(RLMPreparedPredicate *)predicate {
+    self = [super init];
+    if (self) {
+        _results = results;
+        _predicate = predicate;
+    }
+    return self;
+}
+
+- (NSUInteger)argumentCount {
+    return _predicate.argumentCount;
+}
+
+- (NSString *)objectClassName {
+    return _results.objectClassName;
+}
+
+- (RLMRealm *)realm {
+    return _results.realm;
+}
+
+- (RLMResults *)resultsWithArguments:(NSArray *)arguments {
+    RLMCheckThread(_results.realm);
+    return [_results objectsWithPreparedPredicate:_predicate arguments:arguments];
+}
+
+@end
+
+//
+// Collection change notifications
+//
+@implementation RLMCollectionChange
+
+- (instancetype)initWithDeletions:(NSIndexSet *)deletions
+                       insertions:(NSIndexSet *)insertions
+                    modifications:(NSIndexSet *)modifications {
+    self = [super init];
+    if (self) {
+        _deletions = deletions;
+        _insertions = insertions;
+        _modifications = modifications;
+    }
+    return self;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<RLMCollectionChange: %p> deletions: %@, insertions: %@, modifications: %@",
+                                      self, _deletions, _insertions, _modifications];
+}
+
 @end
+
+namespace {
+// The objects in an RLMResults or RLMArray as of the most recent notification
+// for it: the table row of each object in collection order, and a hash of the
+// values in that row
+struct RLMCollectionSnapshot {
+    std::vector<size_t> rows;
+    std::vector<uint64_t> hashes;
+};
+
+// FNV-1a, fed with the raw bytes of each value in a row
+class RLMRowHasher {
+public:
+    template<typename T>
+    void add(T const& value) {
+        add_bytes(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void add_bytes(const char *data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            m_hash = (m_hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+        }
+    }
+
+    uint64_t get() const { return m_hash; }
+
+private:
+    uint64_t m_hash = 14695981039346656037ULL;
+};
+}
+
+static uint64_t RLMRowHash(tightdb::Table& table, size_t row) {
+    RLMRowHasher hasher;
+    for (size_t col = 0, count = table.get_column_count(); col < count; ++col) {
+        switch (table.get_column_type(col)) {
+            case tightdb::type_Int:
+                hasher.add(table.get_int(col, row));
+                break;
+            case tightdb::type_Bool:
+                hasher.add(table.get_bool(col, row));
+                break;
+            case tightdb::type_Float:
+                hasher.add(table.get_float(col, row));
+                break;
+            case tightdb::type_Double:
+                hasher.add(table.get_double(col, row));
+                break;
+            case tightdb::type_DateTime:
+                hasher.add(table.get_datetime(col, row).get_datetime());
+                break;
+            case tightdb::type_String: {
+                tightdb::StringData value = table.get_string(col, row);
+                hasher.add(value.size());
+                hasher.add_bytes(value.data(), value.size());
+                break;
+            }
+            case tightdb::type_Binary: {
+                tightdb::BinaryData value = table.get_binary(col, row);
+                hasher.add(value.size());
+                hasher.add_bytes(value.data(), value.size());
+                break;
+            }
+            case tightdb::type_Mixed:
+                hasher.add(table.get_mixed_type(col, row));
+                break;
+            case tightdb::type_Link:
+                hasher.add(table.is_null_link(col, row) ? tightdb::not_found : table.get_link(col, row));
+                break;
+            case tightdb::type_LinkList: {
+                tightdb::LinkViewRef linkView = table.get_linklist(col, row);
+                hasher.add(linkView->size());
+                for (size_t i = 0; i < linkView->size(); ++i) {
+                    hasher.add(linkView->get(i).get_index());
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return hasher.get();
+}
+
+// fill in the snapshot of the collection, or return false if it is no longer
+// valid. If the table hasn't changed since the previous snapshot was taken, the
+// hashes of the rows which were already in it are reused.
+static bool RLMTakeCollectionSnapshot(RLMCollectionSnapshot& snapshot, tightdb::Table& table,
+                                      BOOL (^getRows)(std::vector<size_t>& rows),
+                                      RLMCollectionSnapshot const* previous = nullptr) {
+    snapshot.rows.clear();
+    if (!getRows(snapshot.rows)) {
+        return false;
+    }
+
+    std::unordered_map<size_t, uint64_t> previousHashes;
+    if (previous) {
+        for (size_t i = 0; i < previous->rows.size(); ++i) {
+            previousHashes.emplace(previous->rows[i], previous->hashes[i]);
+        }
+    }
+
+    snapshot.hashes.clear();
+    snapshot.hashes.reserve(snapshot.rows.size());
+    for (size_t row : snapshot.rows) {
+        auto it = previousHashes.find(row);
+        snapshot.hashes.push_back(it == previousHashes.end() ? RLMRowHash(table, row) : it->second);
+    }
+    return true;
+}
+
+// the positions in `values` of a longest strictly increasing subsequence of it
+static std::vector<size_t> RLMLongestIncreasingSubsequence(std::vector<size_t> const& values) {
+    std::vector<size_t> tails; // position of the smallest tail of each length
+    std::vector<size_t> previous(values.size(), tightdb::not_found);
+    for (size_t i = 0; i < values.size(); ++i) {
+        auto it = std::lower_bound(tails.begin(), tails.end(), values[i],
+                                   [&](size_t position, size_t value) { return values[position] < value; });
+        if (it != tails.begin()) {
+            previous[i] = *(it - 1);
+        }
+        if (it == tails.end()) {
+            tails.push_back(i);
+        }
+        else {
+            *it = i;
+        }
+    }
+
+    std::vector<size_t> subsequence(tails.size());
+    for (size_t i = tails.size(), position = tails.empty() ? tightdb::not_found : tails.back(); i > 0; --i) {
+        subsequence[i - 1] = position;
+        position = previous[position];
+    }
+    return subsequence;
+}
+
+// Compute the changes between two snapshots of a collection, or return nil if
+// nothing changed.
+//
+// Objects are identified by their row index. Deleting an object moves the last
+// row of the table into the deleted row, so rows which are past the end of the
+// table now are matched by their hash against rows which are new to the
+// collection or whose values changed, and a row taken over by a moved object
+// counts as deleted. Objects which are in both snapshots are deleted and
+// reinserted if they are not part of the longest run of objects which kept
+// their relative order, and are otherwise modified if their hash changed.
+static RLMCollectionChange *RLMCollectionChangeBetween(RLMCollectionSnapshot const& old,
+                                                       RLMCollectionSnapshot const& current,
+                                                       size_t tableSize) {
+    if (old.rows == current.rows && old.hashes == current.hashes) {
+        return nil;
+    }
+
+    std::unordered_map<size_t, uint64_t> oldHashes;
+    for (size_t i = 0; i < old.rows.size(); ++i) {
+        oldHashes[old.rows[i]] = old.hashes[i];
+    }
+
+    // rows now holding objects which weren't at that row before, by hash
+    std::unordered_multimap<uint64_t, size_t> candidates;
+    for (size_t i = 0; i < current.rows.size(); ++i) {
+        auto it = oldHashes.find(current.rows[i]);
+        if (it == oldHashes.end() || it->second != current.hashes[i]) {
+            candidates.emplace(current.hashes[i], current.rows[i]);
+        }
+    }
+
+    // map rows which no longer exist to the rows their objects were moved to
+    std::unordered_map<size_t, size_t> moved;
+    std::unordered_set<size_t> replaced;
+    for (size_t i = 0; i < old.rows.size(); ++i) {
+        size_t row = old.rows[i];
+        if (row < tableSize || moved.count(row)) {
+            continue;
+        }
+        auto it = candidates.find(old.hashes[i]);
+        if (it != candidates.end() && !replaced.count(it->second)) {
+            moved[row] = it->second;
+            replaced.insert(it->second);
+            candidates.erase(it);
+        }
+    }
+
+    // match each object in the old snapshot with the same occurrence of its
+    // row in the current one, as arrays can contain an object more than once
+    std::unordered_map<size_t, std::vector<size_t>> currentPositions;
+    for (size_t i = 0; i < current.rows.size(); ++i) {
+        currentPositions[current.rows[i]].push_back(i);
+    }
+    std::unordered_map<size_t, size_t> occurrences;
+    std::vector<size_t> oldPositionOf(current.rows.size(), tightdb::not_found);
+    NSMutableIndexSet *deletions = [NSMutableIndexSet new];
+    for (size_t i = 0; i < old.rows.size(); ++i) {
+        size_t row = old.rows[i];
+        if (row >= tableSize) {
+            auto it = moved.find(row);
+            row = it == moved.end() ? tightdb::not_found : it->second;
+        }
+        else if (replaced.count(row)) {
+            row = tightdb::not_found;
+        }
+
+        auto it = currentPositions.find(row);
+        size_t occurrence = occurrences[row]++;
+        if (it == currentPositions.end() || occurrence >= it->second.size()) {
+            [deletions addIndex:i];
+        }
+        else {
+            oldPositionOf[it->second[occurrence]] = i;
+        }
+    }
+
+    NSMutableIndexSet *insertions = [NSMutableIndexSet new];
+    std::vector<size_t> matchedOld, matchedCurrent;
+    for (size_t i = 0; i < current.rows.size(); ++i) {
+        if (oldPositionOf[i] == tightdb::not_found) {
+            [insertions addIndex:i];
+        }
+        else {
+            matchedOld.push_back(oldPositionOf[i]);
+            matchedCurrent.push_back(i);
+        }
+    }
+
+    NSMutableIndexSet *modifications = [NSMutableIndexSet new];
+    std::vector<bool> inOrder(matchedOld.size());
+    for (size_t position : RLMLongestIncreasingSubsequence(matchedOld)) {
+        inOrder[position] = true;
+    }
+    for (size_t i = 0; i < matchedOld.size(); ++i) {
+        if (!inOrder[i]) {
+            [deletions addIndex:matchedOld[i]];
+            [insertions addIndex:matchedCurrent[i]];
+        }
+        else if (old.hashes[matchedOld[i]] != current.hashes[matchedCurrent[i]]) {
+            [modifications addIndex:matchedOld[i]];
+        }
+    }
+
+    if (!deletions.count && !insertions.count && !modifications.count) {
+        return nil;
+    }
+    return [[RLMCollectionChange alloc] initWithDeletions:deletions
+                                               insertions:insertions
+                                            modifications:modifications];
+}
+
+// an empty view of a table, which is out of sync once the table or any table
+// linked to or from it has changed
+static tightdb::TableView RLMTableChangeTracker(tightdb::Table& table) {
+    return table.where().find_all(0, size_t(-1), 0);
+}
+
+RLMNotificationToken *RLMAddCollectionNotificationBlock(id<RLMCollection> collection,
+                                                        RLMObjectSchema *objectSchema,
+                                                        tightdb::Table *listOrigin,
+                                                        RLMCollectionNotificationBlock block,
+                                                        BOOL (^getRows)(std::vector<size_t>& rows)) {
+    if (!block) {
+        @throw RLMException(@"The notification block should not be nil");
+    }
+
+    struct State {
+        RLMCollectionSnapshot snapshot;
+        // the objects' table, followed by the table holding the list, if any
+        std::vector<tightdb::TableView> trackers;
+        bool valid;
+    };
+    auto state = std::make_shared<State>();
+    state->trackers.push_back(RLMTableChangeTracker(*objectSchema.table));
+    if (listOrigin) {
+        state->trackers.push_back(RLMTableChangeTracker(*listOrigin));
+    }
+    RLMNotificationToken *token = [collection.realm addNotificationBlock:^(NSString *notification, __unused RLMRealm *realm) {
+        if (!state->valid || ![notification isEqualToString:RLMRealmDidChangeNotification]) {
+            return;
+        }
+
+        // the collection can't have changed if none of its tables did, and the
+        // objects' hashes can't have if their table didn't
+        auto inSync = [](tightdb::TableView const& tracker) {
+            return tracker.is_attached() && tracker.is_in_sync();
+        };
+        if (std::all_of(state->trackers.begin(), state->trackers.end(), inSync)) {
+            return;
+        }
+        bool tableChanged = !inSync(state->trackers[0]);
+        for (auto& tracker : state->trackers) {
+            if (tracker.is_attached()) {
+                tracker.sync_if_needed();
+            }
+        }
+
+        tightdb::Table& table = *objectSchema.table;
+        RLMCollectionSnapshot current;
+        if (!RLMTakeCollectionSnapshot(current, table, getRows, tableChanged ? nullptr : &state->snapshot)) {
+            state->valid = false;
+            return;
+        }
+        RLMCollectionChange *change = RLMCollectionChangeBetween(state->snapshot, current, table.size());
+        state->snapshot = std::move(current);
+        if (change) {
+            block(collection, change);
+        }
+    }];
+    state->valid = RLMTakeCollectionSnapshot(state->snapshot, *objectSchema.table, getRows);
+    return token;
+}
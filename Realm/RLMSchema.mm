@@ -39,6 +39,20 @@ const size_t c_primaryKeyObjectClassColumnIndex =  0;
 const char * const c_primaryKeyPropertyNameColumnName = "pk_property";
 const size_t c_primaryKeyPropertyNameColumnIndex =  1;
 
+NSString * const c_fullTextIndexTableNamePrefix = @"fts_";
+const size_t c_fullTextIndexTokenColumnIndex = 0;
+const size_t c_fullTextIndexObjectColumnIndex = 1;
+const size_t c_fullTextIndexPositionColumnIndex = 2;
+
+NSString * const c_compoundIndexTableNamePrefix = @"cidx_";
+const size_t c_compoundIndexKeyColumnIndex = 0;
+const size_t c_compoundIndexObjectColumnIndex = 1;
+const size_t c_compoundIndexValueColumnIndex = 2;
+
+NSString * const c_orderedIndexTableNamePrefix = @"oidx_";
+const size_t c_orderedIndexValueColumnIndex = 0;
+const size_t c_orderedIndexObjectColumnIndex = 1;
+
 const NSUInteger RLMNotVersioned = (NSUInteger)-1;
 
 
@@ -232,6 +246,28 @@ void RLMRealmSetPrimaryKeyForObjectClass(RLMRealm *realm, NSString *objectClass,
     }
 }
 
+bool RLMRealmHasFullTextIndex(RLMRealm *realm, NSString *objectClass, NSString *property) {
+    tightdb::TableRef table = realm.group->get_table(RLMFullTextIndexTableName(objectClass, property).UTF8String);
+    return table && table->get_column_count() != 0;
+}
+
+bool RLMRealmHasOrderedIndex(RLMRealm *realm, NSString *objectClass, NSString *property) {
+    tightdb::TableRef table = realm.group->get_table(RLMOrderedIndexTableName(objectClass, property).UTF8String);
+    return table && table->get_column_count() != 0;
+}
+
+NSArray *RLMRealmCompoundIndexesForObjectClass(RLMRealm *realm, NSString *objectClass) {
+    NSString *prefix = [NSString stringWithFormat:@"%@%@.", c_compoundIndexTableNamePrefix, objectClass];
+    NSMutableArray *indexes = [NSMutableArray array];
+    for (size_t i = 0; i < realm.group->size(); i++) {
+        NSString *tableName = RLMStringDataToNSString(realm.group->get_table_name(i));
+        if ([tableName hasPrefix:prefix] && realm.group->get_table(i)->get_column_count() != 0) {
+            [indexes addObject:[[tableName substringFromIndex:prefix.length] componentsSeparatedByString:@"."]];
+        }
+    }
+    return indexes;
+}
+
 
 + (Class)classForString:(NSString *)className {
     if (Class cls = s_localNameToClass[className]) {
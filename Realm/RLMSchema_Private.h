@@ -33,7 +33,24 @@ extern "C" {
 //  class_* - any table name beginning with class is used to store objects
 //            of the typename (the rest of the name after class)
 //  metadata - table used for realm metadata storage
+//  fts_*   - full-text index for the property of an object class named by
+//            the rest of the name (<class>.<property>)
+//  cidx_*  - compound index for the properties of an object class named by
+//            the rest of the name (<class>.<property>.<property>...)
+//  oidx_*  - ordered index for the property of an object class named by the
+//            rest of the name (<class>.<property>)
 extern NSString * const c_objectTableNamePrefix;
+extern NSString * const c_fullTextIndexTableNamePrefix;
+extern const size_t c_fullTextIndexTokenColumnIndex;
+extern const size_t c_fullTextIndexObjectColumnIndex;
+extern const size_t c_fullTextIndexPositionColumnIndex;
+extern NSString * const c_compoundIndexTableNamePrefix;
+extern const size_t c_compoundIndexKeyColumnIndex;
+extern const size_t c_compoundIndexObjectColumnIndex;
+extern const size_t c_compoundIndexValueColumnIndex;
+extern NSString * const c_orderedIndexTableNamePrefix;
+extern const size_t c_orderedIndexValueColumnIndex;
+extern const size_t c_orderedIndexObjectColumnIndex;
 extern const char * const c_metadataTableName;
 extern const char * const c_primaryKeyTableName;
 extern const char * const c_versionColumnName;
@@ -50,6 +67,19 @@ static inline NSString *RLMTableNameForClass(NSString *className) {
     return [c_objectTableNamePrefix stringByAppendingString:className];
 }
 
+static inline NSString *RLMFullTextIndexTableName(NSString *className, NSString *propertyName) {
+    return [NSString stringWithFormat:@"%@%@.%@", c_fullTextIndexTableNamePrefix, className, propertyName];
+}
+
+static inline NSString *RLMCompoundIndexTableName(NSString *className, NSArray *propertyNames) {
+    return [NSString stringWithFormat:@"%@%@.%@", c_compoundIndexTableNamePrefix, className,
+            [propertyNames componentsJoinedByString:@"."]];
+}
+
+static inline NSString *RLMOrderedIndexTableName(NSString *className, NSString *propertyName) {
+    return [NSString stringWithFormat:@"%@%@.%@", c_orderedIndexTableNamePrefix, className, propertyName];
+}
+
 
 //
 // Realm schema metadata
@@ -76,6 +106,17 @@ NSString *RLMRealmPrimaryKeyForObjectClass(RLMRealm *realm, NSString *objectClas
 // must be in write transaction to set
 void RLMRealmSetPrimaryKeyForObjectClass(RLMRealm *realm, NSString *objectClass, NSString *primaryKey);
 
+// check if the realm has a full-text index for the given property
+// a removed index is left behind as a table without columns
+bool RLMRealmHasFullTextIndex(RLMRealm *realm, NSString *objectClass, NSString *property);
+
+// get the property names of each compound index the realm has for the object class
+// as with full-text indexes, a removed index is left behind as a table without columns
+NSArray *RLMRealmCompoundIndexesForObjectClass(RLMRealm *realm, NSString *objectClass);
+
+// check if the realm has an ordered index for the given property
+bool RLMRealmHasOrderedIndex(RLMRealm *realm, NSString *objectClass, NSString *property);
+
 
 //
 // RLMSchema private interface
@@ -22,10 +22,16 @@
 #import <tightdb/binary_data.hpp>
 #import <tightdb/string_data.hpp>
 
+#include <string>
+
 @class RLMObjectSchema;
 @class RLMProperty;
 @class RLMSchema;
 
+namespace tightdb {
+    class Table;
+}
+
 NSException *RLMException(NSString *message, NSDictionary *userInfo = nil);
 NSException *RLMException(std::exception const& exception);
 
@@ -55,6 +61,21 @@ NSDictionary *RLMDefaultValuesForObjectSchema(RLMObjectSchema *objectSchema);
 // returns dictionary with default values and allocates child objects when applicable
 NSDictionary *RLMValidatedDictionaryForObjectSchema(id value, RLMObjectSchema *objectSchema, RLMSchema *schema, bool allowMissing = false);
 
+// splits a string into the words stored in a full-text index, folded to
+// lowercase without diacritics, in the order they appear in the string
+NSArray *RLMFullTextTokens(NSString *string);
+
+// compares the values of a column in two rows, which may be in different
+// tables, ordering them the same way sorted results do
+// returns a negative number, zero or a positive number like strcmp()
+int RLMCompareRowValues(tightdb::Table const& tableA, size_t columnA, size_t rowA,
+                        tightdb::Table const& tableB, size_t columnB, size_t rowB);
+
+// copies the value of a column in a row to a column of the same type in a row
+// of another table
+void RLMCopyRowValue(tightdb::Table &dest, size_t destColumn, size_t destRow,
+                     tightdb::Table const& src, size_t srcColumn, size_t srcRow);
+
 // C version of isKindOfClass
 static inline BOOL RLMIsKindOfclass(Class class1, Class class2) {
     while (class1) {
@@ -118,6 +139,57 @@ static inline tightdb::StringData RLMStringDataWithNSString(NSString *string) {
                                [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding]);
 }
 
+// Compound index key utilities
+// the key of a compound index row is the values of all but the last of the
+// index's properties, with strings prefixed by their length so that keys are
+// only equal if all of their values are
+static inline void RLMAppendCompoundIndexKey(std::string &key, int64_t value) {
+    key += std::to_string(value);
+    key += ',';
+}
+
+static inline void RLMAppendCompoundIndexKey(std::string &key, tightdb::StringData value) {
+    key += std::to_string(value.size());
+    key += ':';
+    key.append(value.data(), value.size());
+    key += ',';
+}
+
+// Ordered index utilities
+static inline bool RLMPropertyTypeSupportsOrderedIndex(RLMPropertyType type) {
+    switch (type) {
+        case RLMPropertyTypeString:
+        case RLMPropertyTypeInt:
+        case RLMPropertyTypeFloat:
+        case RLMPropertyTypeDouble:
+        case RLMPropertyTypeBool:
+        case RLMPropertyTypeDate:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// binary search the rows of an ordered index, given a function which compares
+// the value of a row to the value searched for
+// returns the first row whose value is not less than the value searched for,
+// or if upper is true, the first row whose value is greater than it
+template<typename Compare>
+static inline size_t RLMOrderedIndexBound(size_t size, Compare&& compare, bool upper) {
+    size_t low = 0, high = size;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int c = compare(mid);
+        if (c < 0 || (upper && c == 0)) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
 // Binary convertion utilities
 static inline tightdb::BinaryData RLMBinaryDataForNSData(NSData *data) {
     return tightdb::BinaryData(static_cast<const char *>(data.bytes), data.length);
@@ -25,6 +25,9 @@
 #import "RLMSchema_Private.h"
 #import "RLMSwiftSupport.h"
 
+#import <tightdb/table.hpp>
+#import <tightdb/utf8.hpp>
+
 #if !defined(REALM_VERSION)
 #import "RLMVersion.h"
 #endif
@@ -287,3 +290,75 @@ static inline BOOL RLMIsSubclass(Class class1, Class class2) {
 BOOL RLMIsObjectSubclass(Class klass) {
     return RLMIsSubclass(class_getSuperclass(klass), RLMObjectBase.class);
 }
+
+NSArray *RLMFullTextTokens(NSString *string) {
+    NSMutableArray *tokens = [NSMutableArray array];
+    if (!string.length) {
+        return tokens;
+    }
+
+    NSStringCompareOptions fold = NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch;
+    [string enumerateSubstringsInRange:NSMakeRange(0, string.length)
+                               options:NSStringEnumerationByWords
+                            usingBlock:^(NSString *word, __unused NSRange wordRange, __unused NSRange enclosingRange, __unused BOOL *stop) {
+        [tokens addObject:[word stringByFoldingWithOptions:fold locale:nil]];
+    }];
+    return tokens;
+}
+
+template<typename T>
+static inline int RLMCompareValues(T const& a, T const& b) {
+    return a < b ? -1 : b < a ? 1 : 0;
+}
+
+int RLMCompareRowValues(tightdb::Table const& tableA, size_t columnA, size_t rowA,
+                        tightdb::Table const& tableB, size_t columnB, size_t rowB) {
+    switch (tableA.get_column_type(columnA)) {
+        case tightdb::type_Int:
+            return RLMCompareValues(tableA.get_int(columnA, rowA), tableB.get_int(columnB, rowB));
+        case tightdb::type_Bool:
+            return RLMCompareValues(tableA.get_bool(columnA, rowA), tableB.get_bool(columnB, rowB));
+        case tightdb::type_DateTime:
+            return RLMCompareValues(tableA.get_datetime(columnA, rowA).get_datetime(),
+                                    tableB.get_datetime(columnB, rowB).get_datetime());
+        case tightdb::type_Float:
+            return RLMCompareValues(tableA.get_float(columnA, rowA), tableB.get_float(columnB, rowB));
+        case tightdb::type_Double:
+            return RLMCompareValues(tableA.get_double(columnA, rowA), tableB.get_double(columnB, rowB));
+        case tightdb::type_String: {
+            tightdb::StringData a = tableA.get_string(columnA, rowA), b = tableB.get_string(columnB, rowB);
+            if (a == b) {
+                return 0;
+            }
+            return tightdb::utf8_compare(a, b) ? -1 : 1;
+        }
+        default:
+            @throw RLMException(@"Only bool, date, double, float, int and string values can be compared");
+    }
+}
+
+void RLMCopyRowValue(tightdb::Table &dest, size_t destColumn, size_t destRow,
+                     tightdb::Table const& src, size_t srcColumn, size_t srcRow) {
+    switch (src.get_column_type(srcColumn)) {
+        case tightdb::type_Int:
+            dest.set_int(destColumn, destRow, src.get_int(srcColumn, srcRow));
+            break;
+        case tightdb::type_Bool:
+            dest.set_bool(destColumn, destRow, src.get_bool(srcColumn, srcRow));
+            break;
+        case tightdb::type_DateTime:
+            dest.set_datetime(destColumn, destRow, src.get_datetime(srcColumn, srcRow));
+            break;
+        case tightdb::type_Float:
+            dest.set_float(destColumn, destRow, src.get_float(srcColumn, srcRow));
+            break;
+        case tightdb::type_Double:
+            dest.set_double(destColumn, destRow, src.get_double(srcColumn, srcRow));
+            break;
+        case tightdb::type_String:
+            dest.set_string(destColumn, destRow, src.get_string(srcColumn, srcRow));
+            break;
+        default:
+            @throw RLMException(@"Only bool, date, double, float, int and string values can be copied");
+    }
+}
@@ -429,7 +429,6 @@
     [RLMRealm migrateRealmAtPath:RLMTestRealmPath()];
 }
 
-#if 0 // FIXME: re-enable when int indexing is enabled
 - (void)testIntPrimaryKeyNoIndexMigration {
     // make string an int
     RLMObjectSchema *objectSchema = [RLMObjectSchema schemaForObjectClass:MigrationPrimaryKeyObject.class];
@@ -461,7 +460,34 @@
     XCTAssertEqual(1, [objects[0] intCol]);
     XCTAssertEqual(2, [objects[1] intCol]);
 }
-#endif
+
+- (void)testPrimaryKeyIndexAddedWithoutMigration {
+    RLMObjectSchema *objectSchema = [RLMObjectSchema schemaForObjectClass:MigrationPrimaryKeyObject.class];
+
+    // create without search index
+    objectSchema.primaryKeyProperty.indexed = NO;
+
+    @autoreleasepool {
+        RLMRealm *realm = [self realmWithSingleObject:objectSchema];
+        [realm beginWriteTransaction];
+        [realm createObject:MigrationPrimaryKeyObject.className withObject:@[@1]];
+        [realm createObject:MigrationPrimaryKeyObject.className withObject:@[@2]];
+        [realm commitWriteTransaction];
+
+        XCTAssertFalse(realm.schema[MigrationPrimaryKeyObject.className].table->has_search_index(0));
+    }
+
+    // opening the realm with the same schema version adds the missing index
+    RLMRealm *realm = [self realmWithTestPath];
+    XCTAssertTrue(realm.schema[MigrationPrimaryKeyObject.className].table->has_search_index(0));
+
+    [realm beginWriteTransaction];
+    [MigrationPrimaryKeyObject createOrUpdateInRealm:realm withObject:@[@2]];
+    [MigrationPrimaryKeyObject createOrUpdateInRealm:realm withObject:@[@3]];
+    XCTAssertThrows([MigrationPrimaryKeyObject createInRealm:realm withObject:@[@3]]);
+    [realm commitWriteTransaction];
+    XCTAssertEqual(3U, [MigrationPrimaryKeyObject allObjectsInRealm:realm].count);
+}
 
 - (void)testDuplicatePrimaryKeyMigration {
     // make string an int
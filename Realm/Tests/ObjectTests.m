@@ -141,6 +141,17 @@ RLM_ARRAY_TYPE(PrimaryIntObject);
 }
 @end
 
+@interface PrimaryLinkedFirstObject : RLMObject
+@property PrimaryLinkedFirstObject *link;
+@property int primaryCol;
+@end
+
+@implementation PrimaryLinkedFirstObject
++ (NSString *)primaryKey {
+    return @"primaryCol";
+}
+@end
+
 @interface StringSubclassObject : StringObject
 @property NSString *stringCol2;
 @end
@@ -1211,6 +1222,19 @@ RLM_ARRAY_TYPE(PrimaryIntObject);
     [realm commitWriteTransaction];
 }
 
+- (void)testCreateOrUpdateNestedObjectWithSamePrimaryKey {
+    RLMRealm *realm = [RLMRealm defaultRealm];
+    [realm beginWriteTransaction];
+
+    // the linked object is created before the primary key of the new object is set
+    XCTAssertThrows([PrimaryLinkedFirstObject createOrUpdateInDefaultRealmWithObject:@[@[NSNull.null, @1], @1]]);
+    XCTAssertThrows([PrimaryLinkedFirstObject createOrUpdateInDefaultRealmWithObject:@{@"link": @{@"link": NSNull.null, @"primaryCol": @2}, @"primaryCol": @2}]);
+    PrimaryLinkedFirstObject *obj = [[PrimaryLinkedFirstObject alloc] initWithObject:@[@[NSNull.null, @3], @3]];
+    XCTAssertThrows([realm addOrUpdateObject:obj]);
+
+    [realm cancelWriteTransaction];
+}
+
 
 - (void)testObjectInSet {
     [[RLMRealm defaultRealm] beginWriteTransaction];
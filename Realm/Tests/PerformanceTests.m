@@ -311,6 +311,23 @@ static RLMRealm *s_smallRealm, *s_mediumRealm, *s_largeRealm;
     }];
 }
 
+- (void)testLargeINQueryOnIndexedStrings {
+    RLMRealm *realm = self.realmWithTestPath;
+    [realm beginWriteTransaction];
+    NSMutableArray *ids = [NSMutableArray arrayWithCapacity:1000];
+    for (int i = 0; i < 2000; ++i) {
+        [IndexedStringObject createInRealm:realm withObject:@[@(i).stringValue]];
+        if (i % 2) {
+            [ids addObject:@(i).stringValue];
+        }
+    }
+    [realm commitWriteTransaction];
+
+    [self measureBlock:^{
+        (void)[[IndexedStringObject objectsInRealm:realm where:@"stringCol IN %@", ids] lastObject];
+    }];
+}
+
 - (void)testSortingAllObjects {
     RLMRealm *realm = self.realmWithTestPath;
     [realm beginWriteTransaction];
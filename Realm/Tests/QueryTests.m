@@ -67,6 +67,59 @@
 @implementation QueryObject
 @end
 
+#pragma mark IndexedPrimitivesObject
+
+@interface IndexedPrimitivesObject : RLMObject
+@property NSInteger intCol;
+@property BOOL boolCol;
+@property NSDate *dateCol;
+@end
+
+@implementation IndexedPrimitivesObject
++ (NSArray *)indexedProperties
+{
+    return @[@"intCol", @"boolCol", @"dateCol"];
+}
+@end
+
+#pragma mark CircleArrayOwnerObject
+
+@interface CircleArrayOwnerObject : RLMObject
+@property CircleArrayObject *owned;
+@end
+
+@implementation CircleArrayOwnerObject
+@end
+
+#pragma mark CompoundIndexObject
+
+@interface CompoundIndexObject : RLMObject
+@property NSString *account;
+@property NSInteger priority;
+@property NSDate *timestamp;
+@end
+
+@implementation CompoundIndexObject
++ (NSArray *)compoundIndexes
+{
+    return @[@[@"account", @"priority", @"timestamp"]];
+}
+@end
+
+#pragma mark FullTextObject
+
+@interface FullTextObject : RLMObject
+@property NSString *title;
+@property NSString *body;
+@end
+
+@implementation FullTextObject
++ (NSArray *)fullTextIndexedProperties
+{
+    return @[@"body"];
+}
+@end
+
 #pragma mark - Tests
 
 @interface QueryTests : RLMTestCase
@@ -816,6 +869,169 @@
     XCTAssertEqual(1U, [AllTypesObject objectsWhere:@"objectCol.stringCol CONTAINS[c] 'C'"].count);
 }
 
+- (void)testStringCaseAndDiacriticInsensitive
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    StringObject *so = [StringObject createInRealm:realm withObject:(@[@"Crème Brûlée"])];
+    [StringObject createInRealm:realm withObject:(@[@"ΆΛΦΑ"])];
+    [StringObject createInRealm:realm withObject:(@[@"creme brulee"])];
+    [AllTypesObject createInRealm:realm withObject:@[@YES, @1, @1.0f, @1.0, @"a", [@"a" dataUsingEncoding:NSUTF8StringEncoding], NSDate.date, @YES, @1LL, @1, so]];
+    [realm commitWriteTransaction];
+
+    XCTAssertEqual(1U, [StringObject objectsWhere:@"stringCol ==[c] 'CRÈME BRÛLÉE'"].count);
+    XCTAssertEqual(1U, [StringObject objectsWhere:@"stringCol ==[d] 'Creme Brulee'"].count);
+    XCTAssertEqual(2U, [StringObject objectsWhere:@"stringCol ==[cd] 'CREME BRULEE'"].count);
+    XCTAssertEqual(1U, [StringObject objectsWhere:@"stringCol !=[cd] 'CREME BRULEE'"].count);
+    XCTAssertEqual(2U, [StringObject objectsWhere:@"stringCol BEGINSWITH[cd] 'cre'"].count);
+    XCTAssertEqual(1U, [StringObject objectsWhere:@"stringCol BEGINSWITH[c] 'crè'"].count);
+    XCTAssertEqual(2U, [StringObject objectsWhere:@"stringCol ENDSWITH[cd] 'LEE'"].count);
+    XCTAssertEqual(2U, [StringObject objectsWhere:@"stringCol CONTAINS[cd] 'E BRU'"].count);
+    XCTAssertEqual(1U, [StringObject objectsWhere:@"stringCol CONTAINS[c] 'E BRU'"].count);
+    XCTAssertEqual(1U, [StringObject objectsWhere:@"stringCol CONTAINS[cd] 'λφα'"].count);
+    XCTAssertEqual(1U, [StringObject objectsWhere:@"stringCol BEGINSWITH[cd] 'α'"].count);
+
+    XCTAssertEqual(1U, [AllTypesObject objectsWhere:@"objectCol.stringCol CONTAINS[cd] 'BRULEE'"].count);
+    XCTAssertEqual(0U, [AllTypesObject objectsWhere:@"objectCol.stringCol CONTAINS[d] 'BRULEE'"].count);
+}
+
+- (void)testIndexedPrimitiveQueries
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 20; ++i) {
+        [IndexedPrimitivesObject createInRealm:realm withObject:@[@(i % 10), @(i % 2 == 0), [NSDate dateWithTimeIntervalSince1970:i]]];
+    }
+    [realm commitWriteTransaction];
+
+    XCTAssertEqual(2U, [IndexedPrimitivesObject objectsWhere:@"intCol == 3"].count);
+    XCTAssertEqual(10U, [IndexedPrimitivesObject objectsWhere:@"boolCol == YES"].count);
+    XCTAssertEqual(1U, ([IndexedPrimitivesObject objectsWhere:@"dateCol == %@", [NSDate dateWithTimeIntervalSince1970:5]].count));
+    XCTAssertEqual(6U, [IndexedPrimitivesObject objectsWhere:@"intCol IN {1, 3, 5, 42}"].count);
+    XCTAssertEqual(8U, [IndexedPrimitivesObject objectsWhere:@"intCol >= 2 AND intCol < 6"].count);
+    XCTAssertEqual(8U, [IndexedPrimitivesObject objectsWhere:@"intCol BETWEEN {2, 5}"].count);
+    XCTAssertEqual(4U, ([IndexedPrimitivesObject objectsWhere:@"dateCol > %@ AND dateCol <= %@",
+                         [NSDate dateWithTimeIntervalSince1970:2], [NSDate dateWithTimeIntervalSince1970:6]].count));
+    XCTAssertEqual(20U, [IndexedPrimitivesObject objectsWhere:@"intCol >= -100000 AND intCol <= 100000"].count);
+
+    // the index follows changes to the column
+    [realm beginWriteTransaction];
+    [[IndexedPrimitivesObject objectsWhere:@"intCol == 3"].firstObject setIntCol:4];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(1U, [IndexedPrimitivesObject objectsWhere:@"intCol IN {3}"].count);
+    XCTAssertEqual(3U, [IndexedPrimitivesObject objectsWhere:@"intCol BETWEEN {4, 4}"].count);
+
+    NSString *explanation = [IndexedPrimitivesObject objectsWhere:@"intCol IN {1, 3}"].explain;
+    XCTAssertTrue([explanation rangeOfString:@"using index"].location != NSNotFound);
+
+    // bool comparisons check each row even when the column is indexed
+    explanation = [IndexedPrimitivesObject objectsWhere:@"boolCol == YES"].explain;
+    XCTAssertTrue([explanation rangeOfString:@"using index"].location == NSNotFound);
+}
+
+- (void)testCompoundIndexQueries
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 20; ++i) {
+        [CompoundIndexObject createInRealm:realm withObject:@[i % 2 ? @"a" : @"b", @(i % 4 / 2),
+                                                              [NSDate dateWithTimeIntervalSince1970:i]]];
+    }
+    [realm commitWriteTransaction];
+
+    NSDate *(^date)(int) = ^(int seconds) { return [NSDate dateWithTimeIntervalSince1970:seconds]; };
+    XCTAssertEqual(5U, [CompoundIndexObject objectsWhere:@"account == 'a' AND priority == 1"].count);
+    XCTAssertEqual(3U, ([CompoundIndexObject objectsWhere:@"account == 'a' AND priority == 1 AND timestamp > %@", date(10)].count));
+    XCTAssertEqual(3U, ([CompoundIndexObject objectsWhere:@"timestamp >= %@ AND priority == 0 AND timestamp < %@ AND account == 'b'",
+                         date(4), date(13)].count));
+    XCTAssertEqual(1U, ([CompoundIndexObject objectsWhere:@"account == 'a' AND priority == 1 AND timestamp == %@", date(3)].count));
+    XCTAssertEqual(0U, [CompoundIndexObject objectsWhere:@"account == 'c' AND priority == 1"].count);
+
+    NSString *explanation = [CompoundIndexObject objectsWhere:@"account == 'a' AND priority == 1 AND timestamp > %@", date(10)].explain;
+    XCTAssertTrue([explanation rangeOfString:@"using compound index"].location != NSNotFound);
+
+    // the index follows changes to and deletions of the objects
+    [realm beginWriteTransaction];
+    CompoundIndexObject *obj = [CompoundIndexObject objectsWhere:@"timestamp == %@", date(3)].firstObject;
+    obj.account = @"b";
+    [realm deleteObject:[CompoundIndexObject objectsWhere:@"timestamp == %@", date(7)].firstObject];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(3U, [CompoundIndexObject objectsWhere:@"account == 'a' AND priority == 1"].count);
+    XCTAssertEqual(6U, [CompoundIndexObject objectsWhere:@"account == 'b' AND priority == 1"].count);
+
+    [realm beginWriteTransaction];
+    [realm deleteObjects:[CompoundIndexObject objectsWhere:@"account == 'a' AND priority == 1"]];
+    [CompoundIndexObject createInRealm:realm withObject:@[@"a", @1, date(30)]];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(1U, [CompoundIndexObject objectsWhere:@"account == 'a' AND priority == 1"].count);
+    XCTAssertEqual(6U, [CompoundIndexObject objectsWhere:@"account == 'b' AND priority == 1"].count);
+
+    [realm beginWriteTransaction];
+    [realm deleteObjects:[CompoundIndexObject allObjects]];
+    [CompoundIndexObject createInRealm:realm withObject:@[@"b", @1, date(31)]];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(0U, [CompoundIndexObject objectsWhere:@"account == 'a' AND priority == 1"].count);
+    XCTAssertEqual(1U, [CompoundIndexObject objectsWhere:@"account == 'b' AND priority == 1"].count);
+
+    [realm beginWriteTransaction];
+    [realm deleteAllObjects];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(0U, [CompoundIndexObject objectsWhere:@"account == 'b' AND priority == 1"].count);
+}
+
+- (void)testFullTextMatches
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    [FullTextObject createInRealm:realm withObject:@[@"a", @"The quick brown fox jumps over the lazy dog"]];
+    FullTextObject *b = [FullTextObject createInRealm:realm withObject:@[@"b", @"A brown dog, quick to bark"]];
+    FullTextObject *c = [FullTextObject createInRealm:realm withObject:@[@"c", @"Crème brûlée for dessert"]];
+    [realm commitWriteTransaction];
+
+    XCTAssertEqual(2U, [FullTextObject objectsWhere:@"body MATCHES 'quick'"].count);
+    XCTAssertEqual(2U, [FullTextObject objectsWhere:@"body MATCHES 'BROWN dog'"].count);
+    XCTAssertEqual(1U, [FullTextObject objectsWhere:@"body MATCHES 'fox dog'"].count);
+    XCTAssertEqual(0U, [FullTextObject objectsWhere:@"body MATCHES 'fox cat'"].count);
+    XCTAssertEqual(1U, [FullTextObject objectsWhere:@"body MATCHES 'jum*'"].count);
+    XCTAssertEqual(3U, [FullTextObject objectsWhere:@"body MATCHES 'b*'"].count);
+    XCTAssertEqual(1U, [FullTextObject objectsWhere:@"body MATCHES 'creme'"].count);
+    XCTAssertEqual(1U, [FullTextObject objectsWhere:@"body MATCHES '\"quick brown\"'"].count);
+    XCTAssertEqual(0U, [FullTextObject objectsWhere:@"body MATCHES '\"brown quick\"'"].count);
+    XCTAssertEqual(1U, [FullTextObject objectsWhere:@"body MATCHES '\"lazy d*\"'"].count);
+    XCTAssertEqual(1U, [FullTextObject objectsWhere:@"body MATCHES 'dog' AND title == 'b'"].count);
+
+    // the index follows changes to the property and deletions
+    [realm beginWriteTransaction];
+    b.body = @"Nothing to see here";
+    [realm deleteObject:c];
+    [realm commitWriteTransaction];
+
+    XCTAssertEqual(1U, [FullTextObject objectsWhere:@"body MATCHES 'quick'"].count);
+    XCTAssertEqual(1U, [FullTextObject objectsWhere:@"body MATCHES 'nothing'"].count);
+    XCTAssertEqual(0U, [FullTextObject objectsWhere:@"body MATCHES 'creme'"].count);
+
+    // and deletions of results or of all of the objects
+    [realm beginWriteTransaction];
+    [realm deleteObjects:[FullTextObject objectsWhere:@"body MATCHES 'quick'"]];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(0U, [FullTextObject objectsWhere:@"body MATCHES 'quick'"].count);
+    XCTAssertEqual(1U, [FullTextObject objectsWhere:@"body MATCHES 'nothing'"].count);
+
+    [realm beginWriteTransaction];
+    [realm deleteObjects:[FullTextObject allObjects]];
+    [FullTextObject createInRealm:realm withObject:@[@"d", @"Nothing quick"]];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(1U, [FullTextObject objectsWhere:@"body MATCHES 'quick'"].count);
+    XCTAssertEqual(1U, [FullTextObject objectsWhere:@"body MATCHES 'nothing'"].count);
+
+    XCTAssertThrows([FullTextObject objectsWhere:@"title MATCHES 'a'"]);
+    XCTAssertThrows([FullTextObject objectsWhere:@"body MATCHES '!!'"]);
+}
+
 - (void)testStringEquality
 {
     RLMRealm *realm = [RLMRealm defaultRealm];
@@ -1152,6 +1368,14 @@
     XCTAssertEqual(([OwnerObject objectsInRealm:realm where:@"dog.age IN {8, 10}"].count), 1U);
     XCTAssertEqual(([OwnerObject objectsInRealm:realm where:@"dog.age BETWEEN {0, 10}"].count), 3U);
     XCTAssertEqual(([OwnerObject objectsInRealm:realm where:@"dog.age BETWEEN {0, 7}"].count), 2U);
+
+    // owners without a dog don't match any comparison on the dog's properties
+    [realm beginWriteTransaction];
+    [OwnerObject createInRealm:realm withObject:@[@"Sam", NSNull.null]];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(([OwnerObject objectsInRealm:realm where:@"dog.age != 5"].count), 1U);
+    XCTAssertEqual(([OwnerObject objectsInRealm:realm where:@"dog.age > 6"].count), 1U);
+    XCTAssertEqual(([OwnerObject objectsInRealm:realm where:@"NOT dog.age = 5"].count), 2U);
 }
 
 - (void)testLinkQueryAllTypes
@@ -1277,7 +1501,10 @@
     XCTAssertTrue([circle.next.next isEqualToObject:[CircleObject objectsInRealm:realm where:@"next.next.data = '0'"].firstObject]);
 
     XCTAssertNoThrow(([CircleObject objectsInRealm:realm where:@"next = %@", circle]));
-    XCTAssertThrows(([CircleObject objectsInRealm:realm where:@"next.next = %@", circle]));
+    XCTAssertTrue([circle isEqualToObject:[CircleObject objectsInRealm:realm where:@"next.next = %@", circle.next.next].firstObject]);
+    XCTAssertEqual(0U, ([CircleObject objectsInRealm:realm where:@"next.next = %@", circle].count));
+    XCTAssertEqual(4U, ([CircleObject objectsInRealm:realm where:@"next.next.next != %@", circle.next.next.next.next].count));
+    XCTAssertEqual(1U, [CircleObject objectsInRealm:realm where:@"next.next = nil"].count);
     XCTAssertTrue([circle.next.next.next.next isEqualToObject:[CircleObject objectsInRealm:realm where:@"next = nil"].firstObject]);
 }
 
@@ -1308,6 +1535,70 @@
     XCTAssertThrows([CircleArrayObject objectsInRealm:realm where:@"ANY circles.next = '2'"]);
     XCTAssertThrows([CircleArrayObject objectsInRealm:realm where:@"ANY data.circles = '2'"]);
     XCTAssertThrows([CircleArrayObject objectsInRealm:realm where:@"circles.data = '2'"]);
+
+    // ANY applies to arrays at any level of the key path
+    [realm beginWriteTransaction];
+    [CircleArrayOwnerObject createInRealm:realm withObject:@[[CircleArrayObject allObjectsInRealm:realm].firstObject]];
+    [CircleArrayOwnerObject createInRealm:realm withObject:@[NSNull.null]];
+    [realm commitWriteTransaction];
+    CircleObject *last = [CircleObject objectsInRealm:realm where:@"data = '4'"].firstObject;
+    XCTAssertEqual(1U, [CircleArrayOwnerObject objectsInRealm:realm where:@"ANY owned.circles.data = '2'"].count);
+    XCTAssertEqual(1U, [CircleArrayOwnerObject objectsInRealm:realm where:@"ANY owned.circles.next.next.data = '2'"].count);
+    XCTAssertEqual(0U, [CircleArrayOwnerObject objectsInRealm:realm where:@"ANY owned.circles.data = '5'"].count);
+    XCTAssertEqual(1U, ([CircleArrayOwnerObject objectsInRealm:realm where:@"ANY owned.circles.next = %@", last.next].count));
+    XCTAssertEqual(1U, ([CircleArrayOwnerObject objectsInRealm:realm where:@"ANY owned.circles = %@", last].count));
+    XCTAssertThrows([CircleArrayOwnerObject objectsInRealm:realm where:@"ANY owned.circles.next = '2'"]);
+}
+
+- (void)testArrayCollectionOperatorQueries
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    [CompanyObject createInRealm:realm withObject:@[@"empty", @[]]];
+    [CompanyObject createInRealm:realm withObject:@[@"young", @[@[@"Joe", @20, @YES], @[@"Jane", @25, @YES]]]];
+    [CompanyObject createInRealm:realm withObject:@[@"mixed", @[@[@"Bob", @30, @NO], @[@"Sue", @45, @YES], @[@"Tom", @50, @NO]]]];
+    [realm commitWriteTransaction];
+
+    // collection operators
+    XCTAssertEqual(1U, [CompanyObject objectsWhere:@"employees.@count > 2"].count);
+    XCTAssertEqual(1U, [CompanyObject objectsWhere:@"employees.@count == 0"].count);
+    XCTAssertEqual(1U, [CompanyObject objectsWhere:@"employees.@count BETWEEN {1, 2}"].count);
+    XCTAssertEqual(1U, [CompanyObject objectsWhere:@"employees.@sum.age > 100"].count);
+    XCTAssertEqual(1U, [CompanyObject objectsWhere:@"employees.@sum.age == 0"].count);
+    XCTAssertEqual(1U, [CompanyObject objectsWhere:@"employees.@min.age < 25"].count);
+    XCTAssertEqual(1U, [CompanyObject objectsWhere:@"employees.@max.age >= 45"].count);
+    XCTAssertEqual(2U, [CompanyObject objectsWhere:@"employees.@avg.age > 22"].count);
+    XCTAssertEqual(2U, [CompanyObject objectsWhere:@"NOT employees.@max.age > 30"].count);
+    XCTAssertEqualObjects(@"mixed", [[CompanyObject objectsWhere:@"employees.@count > 2 AND employees.@avg.age > 40"].firstObject name]);
+
+    // ALL and NONE
+    XCTAssertEqual(2U, [CompanyObject objectsWhere:@"ALL employees.age < 30"].count);
+    XCTAssertEqual(2U, [CompanyObject objectsWhere:@"ALL employees.hired == YES"].count);
+    XCTAssertEqual(2U, [CompanyObject objectsWhere:@"ALL employees.name BEGINSWITH 'J'"].count);
+    XCTAssertEqual(3U, [CompanyObject objectsWhere:@"ALL employees.age BETWEEN {20, 50}"].count);
+    XCTAssertEqual(2U, [CompanyObject objectsWhere:@"NONE employees.age > 40"].count);
+    XCTAssertEqual(2U, [CompanyObject objectsWhere:@"NONE employees.hired == NO"].count);
+    XCTAssertEqual(1U, [CompanyObject objectsWhere:@"ALL employees.age > 0 AND employees.@count > 0 AND ANY employees.age > 40"].count);
+
+    // SUBQUERY
+    XCTAssertEqual(1U, [CompanyObject objectsWhere:@"SUBQUERY(employees, $e, $e.age > 25 AND $e.hired == YES).@count > 0"].count);
+    XCTAssertEqual(1U, [CompanyObject objectsWhere:@"SUBQUERY(employees, $e, $e.age >= 30 AND $e.hired == NO).@count == 2"].count);
+    XCTAssertEqual(1U, [CompanyObject objectsWhere:@"SUBQUERY(employees, $e, $e.hired == YES).@count == 0"].count);
+    XCTAssertEqual(1U, ([CompanyObject objectsWhere:@"SUBQUERY(employees, $e, $e.name == %@).@count > %@", @"Jane", @0].count));
+    XCTAssertEqual(1U, ([CompanyObject objectsWhere:@"SUBQUERY(employees, $e, $e.name == %@).@count > %@", @"Bob", @0].count));
+    XCTAssertEqual(0U, ([CompanyObject objectsWhere:@"SUBQUERY(employees, $e, $e.name == %@).@count > %@", @"Bob", @1].count));
+
+    XCTAssertThrows([CompanyObject objectsWhere:@"employees.@count > 'a'"]);
+    XCTAssertThrows([CompanyObject objectsWhere:@"employees.@count CONTAINS 1"]);
+    XCTAssertThrows([CompanyObject objectsWhere:@"employees.@sum.name > 5"]);
+    XCTAssertThrows([CompanyObject objectsWhere:@"employees.@sum > 5"]);
+    XCTAssertThrows([CompanyObject objectsWhere:@"employees.@foo.age > 5"]);
+    XCTAssertThrows([CompanyObject objectsWhere:@"name.@count > 1"]);
+    XCTAssertThrows([CompanyObject objectsWhere:@"ANY employees.@count > 1"]);
+    XCTAssertThrows([CompanyObject objectsWhere:@"ALL name == 'a'"]);
+    XCTAssertThrows([CompanyObject objectsWhere:@"SUBQUERY(employees, $e, $e.height > 5).@count > 0"]);
+    XCTAssertThrows([CompanyObject objectsWhere:@"SUBQUERY(name, $e, $e.age > 5).@count > 0"]);
 }
 
 - (void)testQueryWithObjects
@@ -1355,6 +1646,14 @@
     XCTAssertEqual(2U, ([ArrayOfAllTypesObject objectsWhere:@"ANY array != %@", obj1].count));
     XCTAssertThrows(([ArrayOfAllTypesObject objectsWhere:@"array = %@", obj0].count));
     XCTAssertThrows(([ArrayOfAllTypesObject objectsWhere:@"array != %@", obj0].count));
+
+    // object and binary comparisons through links
+    XCTAssertEqual(2U, ([ArrayOfAllTypesObject objectsWhere:@"ANY array.objectCol = %@", stringObj0].count));
+    XCTAssertEqual(2U, ([ArrayOfAllTypesObject objectsWhere:@"ANY array.objectCol != %@", stringObj0].count));
+    XCTAssertEqual(1U, ([ArrayOfAllTypesObject objectsWhere:@"ANY array.objectCol = nil"].count));
+    XCTAssertEqual(2U, ([ArrayOfAllTypesObject objectsWhere:@"ANY array.binaryCol = %@", [@"b" dataUsingEncoding:NSUTF8StringEncoding]].count));
+    XCTAssertEqual(2U, ([ArrayOfAllTypesObject objectsWhere:@"ANY array.binaryCol BEGINSWITH %@", [@"c" dataUsingEncoding:NSUTF8StringEncoding]].count));
+    XCTAssertThrows(([ArrayOfAllTypesObject objectsWhere:@"ANY array.binaryCol > %@", [@"c" dataUsingEncoding:NSUTF8StringEncoding]].count));
 }
 
 - (void)testCompoundOrQuery {
@@ -1560,6 +1859,166 @@
     XCTAssertEqual(0U, [[[PersonObject objectsWhere:@"name == 'Ari'"] objectsWhere:@"age == 29"] count]);
 }
 
+- (void)testRepeatedPredicateWithDifferentValues {
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    [PersonObject createInRealm:realm withObject:@[@"Tim", @29]];
+    [PersonObject createInRealm:realm withObject:@[@"Ari", @33]];
+    [PersonObject createInRealm:realm withObject:@[@"Fiel", @27]];
+    [realm commitWriteTransaction];
+
+    // each query after the first reuses the compiled form of the predicate,
+    // so verify that the new values are what's actually used
+    XCTAssertEqual(3U, [[PersonObject objectsWhere:@"age > %d AND name != %@", 20, @"Bob"] count]);
+    XCTAssertEqual(2U, [[PersonObject objectsWhere:@"age > %d AND name != %@", 28, @"Bob"] count]);
+    XCTAssertEqual(1U, [[PersonObject objectsWhere:@"age > %d AND name != %@", 28, @"Tim"] count]);
+    XCTAssertEqual(0U, [[PersonObject objectsWhere:@"age > %d AND name != %@", 40, @"Tim"] count]);
+
+    XCTAssertEqual(2U, [[PersonObject objectsWhere:@"name IN %@", @[@"Tim", @"Ari"]] count]);
+    XCTAssertEqual(1U, [[PersonObject objectsWhere:@"name IN %@", @[@"Fiel"]] count]);
+    XCTAssertEqual(0U, [[PersonObject objectsWhere:@"name IN %@", @[]] count]);
+
+    XCTAssertEqual(2U, [[PersonObject objectsWhere:@"age BETWEEN %@", @[@27, @29]] count]);
+    XCTAssertEqual(1U, [[PersonObject objectsWhere:@"age BETWEEN %@", @[@30, @40]] count]);
+
+    // values are still validated when the compiled predicate is reused
+    XCTAssertThrows([PersonObject objectsWhere:@"age > %@ AND name != %@", @"Tim", @"Bob"]);
+    XCTAssertThrows([PersonObject objectsWhere:@"age BETWEEN %@", @[@1]]);
+    XCTAssertEqual(1U, [[PersonObject objectsWhere:@"age > %d AND name != %@", 28, @"Ari"] count]);
+
+    // the same structure on a different class has to be compiled separately
+    XCTAssertEqual(0U, [[EmployeeObject objectsWhere:@"age > %d AND name != %@", 20, @"Bob"] count]);
+}
+
+- (void)testPreparedQuery {
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    [PersonObject createInRealm:realm withObject:@[@"Tim", @29]];
+    [PersonObject createInRealm:realm withObject:@[@"Ari", @33]];
+    [PersonObject createInRealm:realm withObject:@[@"Fiel", @27]];
+    [realm commitWriteTransaction];
+
+    RLMPreparedQuery *query = [realm prepareQuery:@"age > $0 AND name BEGINSWITH $1" forClass:PersonObject.class];
+    XCTAssertEqual(2U, query.argumentCount);
+    XCTAssertEqualObjects(@"PersonObject", query.objectClassName);
+    XCTAssertEqual(1U, [[query resultsWithArguments:@[@20, @"T"]] count]);
+    XCTAssertEqual(0U, [[query resultsWithArguments:@[@30, @"T"]] count]);
+    XCTAssertEqual(1U, [[query resultsWithArguments:@[@30, @"A"]] count]);
+
+    // placeholders can be reused, and appear within aggregates
+    query = [realm prepareQuery:@"age BETWEEN {$1, $0} OR name IN {$2, 'Ari'} OR age == $0" forClass:PersonObject.class];
+    XCTAssertEqual(3U, query.argumentCount);
+    XCTAssertEqual(2U, [[query resultsWithArguments:@[@28, @27, @"Bob"]] count]);
+    XCTAssertEqual(3U, [[query resultsWithArguments:@[@29, @27, @"Fiel"]] count]);
+
+    // placeholders within string literals are left alone
+    query = [realm prepareQuery:@"name != '$0' AND age < $0" forClass:PersonObject.class];
+    XCTAssertEqual(1U, query.argumentCount);
+    XCTAssertEqual(2U, [[query resultsWithArguments:@[@30]] count]);
+
+    // prepared queries on results only match objects within the results
+    RLMResults *results = [[PersonObject objectsWhere:@"age < 30"] sortedResultsUsingProperty:@"age" ascending:YES];
+    query = [results prepareQuery:@"name != $0"];
+    RLMResults *filtered = [query resultsWithArguments:@[@"Bob"]];
+    XCTAssertEqual(2U, filtered.count);
+    XCTAssertEqualObjects(@"Fiel", [filtered[0] name]);
+    XCTAssertEqualObjects(@"Tim", [filtered[1] name]);
+
+    // argument types and counts are validated on each run
+    query = [realm prepareQuery:@"age > $0" forClass:PersonObject.class];
+    XCTAssertThrows([query resultsWithArguments:@[]]);
+    XCTAssertThrows([query resultsWithArguments:@[@1, @2]]);
+    XCTAssertThrows([query resultsWithArguments:@[@"Tim"]]);
+    XCTAssertEqual(1U, [[query resultsWithArguments:@[@30]] count]);
+
+    // invalid formats fail when preparing
+    XCTAssertThrows([realm prepareQuery:@"invalid > $0" forClass:PersonObject.class]);
+    XCTAssertThrows([realm prepareQuery:@"age > $name" forClass:PersonObject.class]);
+    XCTAssertThrowsSpecificNamed([realm prepareQuery:@"age > $0abc" forClass:PersonObject.class],
+                                 NSException, @"Invalid predicate");
+
+    // unsubstituted variables are still invalid in normal queries, and aren't
+    // treated as placeholders
+    XCTAssertThrowsSpecificNamed([PersonObject objectsWithPredicate:[NSPredicate predicateWithFormat:@"age > $age"]],
+                                 NSException, @"Invalid predicate expressions");
+}
+
+- (void)testINQueryOnIndexedAndUnindexedColumns {
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 10; ++i) {
+        [PrimaryStringObject createInRealm:realm withObject:@[@(i).stringValue, @(i)]];
+        [StringObject createInRealm:realm withObject:@[@(i).stringValue]];
+        [DoubleObject createInRealm:realm withObject:@[@(i / 2.0)]];
+        [DateObject createInRealm:realm withObject:@[[NSDate dateWithTimeIntervalSince1970:i]]];
+    }
+    [realm commitWriteTransaction];
+
+    NSArray *strings = @[@"1", @"3", @"5", @"3", @"nonexistent"];
+    XCTAssertEqual(3U, [[PrimaryStringObject objectsWhere:@"stringCol IN %@", strings] count]);
+    XCTAssertEqual(3U, [[StringObject objectsWhere:@"stringCol IN %@", strings] count]);
+    XCTAssertEqual(0U, [[PrimaryStringObject objectsWhere:@"stringCol IN %@", @[]] count]);
+    XCTAssertEqual(7U, [[PrimaryStringObject objectsWhere:@"NOT stringCol IN %@", strings] count]);
+    XCTAssertEqual(2U, [[PrimaryStringObject objectsWhere:@"stringCol IN %@ AND intCol > 2", strings] count]);
+    XCTAssertEqual(4U, [[PrimaryStringObject objectsWhere:@"stringCol IN %@ OR intCol == 0", strings] count]);
+    XCTAssertEqual(3U, [[PrimaryStringObject objectsWhere:@"intCol IN {1, 3, 5}"] count]);
+
+    XCTAssertEqual(2U, [[DoubleObject objectsWhere:@"doubleCol IN {0.5, 1.5, 1.75}"] count]);
+    XCTAssertEqual(2U, [[DateObject objectsWhere:@"dateCol IN %@", @[[NSDate dateWithTimeIntervalSince1970:2],
+                                                                    [NSDate dateWithTimeIntervalSince1970:4]]] count]);
+
+    // results using the index stay up to date as the table changes
+    RLMResults *results = [PrimaryStringObject objectsWhere:@"stringCol IN %@", strings];
+    XCTAssertEqual(3U, results.count);
+    [realm beginWriteTransaction];
+    [PrimaryStringObject createInRealm:realm withObject:@[@"nonexistent", @10]];
+    [realm deleteObjects:[PrimaryStringObject objectsWhere:@"stringCol == '1'"]];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(3U, results.count);
+    XCTAssertEqualObjects(@"nonexistent", [results.lastObject stringCol]);
+    XCTAssertEqual(0U, [[results objectsWhere:@"stringCol == '1'"] count]);
+}
+
+- (void)testReorderedAndCombinedConditions {
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 10; ++i) {
+        [PrimaryStringObject createInRealm:realm withObject:@[@(i).stringValue, @(i)]];
+        [DoubleObject createInRealm:realm withObject:@[@(i / 2.0)]];
+        [DateObject createInRealm:realm withObject:@[[NSDate dateWithTimeIntervalSince1970:i]]];
+    }
+    [IntObject createInRealm:realm withObject:@[@INT_MAX]];
+    [IntObject createInRealm:realm withObject:@[@INT_MIN]];
+    [realm commitWriteTransaction];
+
+    // bounds on the same column are combined regardless of how they're written
+    XCTAssertEqual(4U, [[PrimaryStringObject objectsWhere:@"intCol >= 2 AND intCol <= 5"] count]);
+    XCTAssertEqual(2U, [[PrimaryStringObject objectsWhere:@"intCol > 2 AND intCol < 5"] count]);
+    XCTAssertEqual(3U, [[PrimaryStringObject objectsWhere:@"intCol < 5 AND stringCol != '0' AND intCol > 1"] count]);
+    XCTAssertEqual(0U, [[PrimaryStringObject objectsWhere:@"intCol > 5 AND intCol < 5"] count]);
+    XCTAssertEqual(3U, [[DoubleObject objectsWhere:@"doubleCol > 1.0 AND doubleCol <= 2.5"] count]);
+    XCTAssertEqual(2U, [[DoubleObject objectsWhere:@"doubleCol > 1.0 AND doubleCol < 2.5"] count]);
+    XCTAssertEqual(3U, [[DateObject objectsWhere:@"dateCol > %@ AND dateCol < %@",
+                         [NSDate dateWithTimeIntervalSince1970:3], [NSDate dateWithTimeIntervalSince1970:7]] count]);
+
+    // strict bounds at the limits of the type
+    XCTAssertEqual(0U, [[IntObject objectsWhere:@"intCol > %lld AND intCol < 0", INT64_MAX] count]);
+    XCTAssertEqual(1U, [[IntObject objectsWhere:@"intCol > 0 AND intCol <= %d", INT_MAX] count]);
+    XCTAssertEqual(0U, [[IntObject objectsWhere:@"intCol > 0 AND intCol < %lld", INT64_MIN] count]);
+
+    // conditions are reordered within AND groups without changing the results
+    XCTAssertEqual(1U, [[PrimaryStringObject objectsWhere:@"intCol > 2 AND (intCol < 4 OR intCol > 8) AND stringCol == '3'"] count]);
+    XCTAssertEqual(2U, [[PrimaryStringObject objectsWhere:@"stringCol BEGINSWITH '1' OR (intCol > 2 AND intCol < 4 AND stringCol == '3')"] count]);
+    XCTAssertEqual(4U, [[PrimaryStringObject objectsWhere:@"NOT (intCol >= 2 AND intCol <= 6) AND stringCol != '9'"] count]);
+
+    // values are still validated
+    XCTAssertThrows([PrimaryStringObject objectsWhere:@"intCol > 2 AND intCol < 'a'"]);
+}
+
 - (void)testLinkViewQuery {
     RLMRealm *realm = [RLMRealm defaultRealm];
 
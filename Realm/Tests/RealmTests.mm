@@ -20,6 +20,7 @@
 
 #import "RLMObjectSchema_Private.hpp"
 #import "RLMRealm_Dynamic.h"
+#import "RLMRealm_Private.hpp"
 
 extern "C" {
 #import "RLMSchema_Private.h"
@@ -39,6 +40,17 @@ extern "C" {
 @property (nonatomic, readwrite, copy) NSArray *objectSchema;
 @end
 
+@interface OrderedIndexAgeObject : RLMObject
+@property int age;
+@end
+
+@implementation OrderedIndexAgeObject
++ (NSArray *)orderedIndexedProperties
+{
+    return @[@"age"];
+}
+@end
+
 @interface RealmTests : RLMTestCase
 @end
 
@@ -1172,6 +1184,28 @@ extern "C" {
     [realm path]; // ensure ARC releases the object after the thread has finished
 }
 
+- (void)testSortWithOrderedIndexMissingPostings {
+    RLMRealm *realm = [RLMRealm defaultRealm];
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 10; ++i) {
+        [OrderedIndexAgeObject createInRealm:realm withObject:@[@(9 - i)]];
+    }
+    // objects written without this binding's indexes have no postings
+    tightdb::TableRef index = realm.group->get_table(RLMOrderedIndexTableName(OrderedIndexAgeObject.className, @"age").UTF8String);
+    index->remove(0);
+    index->remove(4);
+    [realm commitWriteTransaction];
+
+    RLMResults *sorted = [[OrderedIndexAgeObject objectsWhere:@"age >= 0"] sortedResultsUsingProperty:@"age" ascending:YES];
+    XCTAssertEqual(10U, sorted.count);
+    for (NSUInteger i = 0; i < sorted.count; ++i) {
+        XCTAssertEqual((int)i, [sorted[i] age]);
+    }
+    RLMResults *limited = [sorted resultsLimitedTo:3 offset:0];
+    XCTAssertEqual(3U, limited.count);
+    XCTAssertEqual(0, [limited.firstObject age]);
+}
+
 - (void)runBlock:(void (^)())block {
     block();
 }
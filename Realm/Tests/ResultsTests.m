@@ -20,6 +20,31 @@
 
 #import <mach/mach.h>
 
+@interface IndexedNameObject : RLMObject
+@property NSString *name;
+@property int age;
+@end
+
+@implementation IndexedNameObject
++ (NSArray *)indexedProperties
+{
+    return @[@"name"];
+}
+@end
+
+@interface OrderedIndexEmployeeObject : RLMObject
+@property NSString *name;
+@property int age;
+@property BOOL hired;
+@end
+
+@implementation OrderedIndexEmployeeObject
++ (NSArray *)orderedIndexedProperties
+{
+    return @[@"name", @"age"];
+}
+@end
+
 @interface ResultsTests : RLMTestCase
 @end
 
@@ -233,6 +258,81 @@
     XCTAssertThrows([allArray maxOfProperty:@"boolCol"]);
 }
 
+- (void)testKeyPathAggregate
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    RLMResults *companies = [CompanyObject objectsWhere:@"name BEGINSWITH 'A'"];
+    XCTAssertEqual(0, [companies sumOfProperty:@"employees.age"].intValue);
+    XCTAssertNil([companies minOfProperty:@"employees.age"]);
+    XCTAssertNil([companies averageOfProperty:@"employees.age"]);
+
+    [realm beginWriteTransaction];
+    [CompanyObject createInRealm:realm withObject:@[@"A", @[@[@"Joe", @40, @YES], @[@"John", @30, @NO]]]];
+    [CompanyObject createInRealm:realm withObject:@[@"Ab", @[@[@"Jill", @25, @YES]]]];
+    [CompanyObject createInRealm:realm withObject:@[@"B", @[@[@"Jack", @50, @YES]]]];
+    [CompanyObject createInRealm:realm withObject:@[@"Ac", @[]]];
+    DogObject *fido = [DogObject createInRealm:realm withObject:@[@"Fido", @3]];
+    [OwnerObject createInRealm:realm withObject:@[@"Tim", fido]];
+    [OwnerObject createInRealm:realm withObject:@[@"Tom", fido]];
+    [OwnerObject createInRealm:realm withObject:@[@"Tam", [NSNull null]]];
+    [realm commitWriteTransaction];
+
+    // through an RLMArray property, with and without a query
+    XCTAssertEqual(95, [companies sumOfProperty:@"employees.age"].intValue);
+    XCTAssertEqual(25, [[companies minOfProperty:@"employees.age"] intValue]);
+    XCTAssertEqual(40, [[companies maxOfProperty:@"employees.age"] intValue]);
+    XCTAssertEqualWithAccuracy([companies averageOfProperty:@"employees.age"].doubleValue, 95.0 / 3, 0.001);
+    XCTAssertEqual(145, [[CompanyObject allObjects] sumOfProperty:@"employees.age"].intValue);
+
+    // the same results once the view has been created
+    XCTAssertEqual(3U, companies.count);
+    XCTAssertEqual(95, [companies sumOfProperty:@"employees.age"].intValue);
+    XCTAssertEqual(40, [[[companies resultsLimitedTo:1 offset:0] maxOfProperty:@"employees.age"] intValue]);
+
+    // through a link, counting each link and skipping nil links
+    XCTAssertEqual(6, [[OwnerObject allObjects] sumOfProperty:@"dog.age"].intValue);
+    XCTAssertEqualWithAccuracy([[OwnerObject allObjects] averageOfProperty:@"dog.age"].doubleValue, 3.0, 0.001);
+
+    // top-level properties computed by the query
+    XCTAssertEqual(50, [[[EmployeeObject objectsWhere:@"hired = YES"] maxOfProperty:@"age"] intValue]);
+
+    XCTAssertThrows([companies sumOfProperty:@"employees.name"]);
+    XCTAssertThrows([companies sumOfProperty:@"employees.foo"]);
+    XCTAssertThrows([companies sumOfProperty:@"name.age"]);
+    XCTAssertThrows([companies sumOfProperty:@"staff.age"]);
+}
+
+- (void)testStatisticsForProperties
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    RLMResults *results = [AggregateObject objectsWhere:@"boolCol == YES"];
+    NSDictionary *statistics = [results statisticsForProperties:@[@"intCol", @"dateCol"]];
+    XCTAssertEqualObjects(statistics[@"intCol"], (@{@"count": @0, @"sum": @0}));
+    XCTAssertEqualObjects(statistics[@"dateCol"], (@{@"count": @0}));
+
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1000];
+    [realm beginWriteTransaction];
+    [AggregateObject createInRealm:realm withObject:@[@1, @1.5f, @2.0, @YES, date]];
+    [AggregateObject createInRealm:realm withObject:@[@4, @0.5f, @3.0, @YES, [date dateByAddingTimeInterval:10]]];
+    [AggregateObject createInRealm:realm withObject:@[@10, @9.0f, @9.0, @NO, [date dateByAddingTimeInterval:20]]];
+    [realm commitWriteTransaction];
+
+    statistics = [results statisticsForProperties:@[@"intCol", @"floatCol", @"doubleCol", @"dateCol"]];
+    XCTAssertEqualObjects(statistics[@"intCol"], (@{@"count": @2, @"sum": @5, @"min": @1, @"max": @4, @"average": @2.5}));
+    XCTAssertEqualObjects(statistics[@"floatCol"][@"max"], @1.5f);
+    XCTAssertEqualWithAccuracy([statistics[@"floatCol"][@"sum"] doubleValue], 2.0, 0.001);
+    XCTAssertEqualWithAccuracy([statistics[@"doubleCol"][@"average"] doubleValue], 2.5, 0.001);
+    XCTAssertEqualObjects(statistics[@"dateCol"],
+                          (@{@"count": @2, @"min": date, @"max": [date dateByAddingTimeInterval:10]}));
+
+    XCTAssertEqualObjects([results statisticsForProperties:@[@"intCol"]][@"intCol"][@"sum"],
+                          [results sumOfProperty:@"intCol"]);
+    XCTAssertThrows([results statisticsForProperties:@[@"intCol", @"boolCol"]]);
+    XCTAssertThrows([results statisticsForProperties:@[@"foo"]]);
+}
+
 - (void)testArrayDescription
 {
     RLMRealm *realm = [RLMRealm defaultRealm];
@@ -372,6 +472,702 @@
     XCTAssertEqual(40, [(EmployeeObject *)sortedName[0] age]);
 }
 
+- (void)testExplain
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 10; ++i) {
+        [PrimaryStringObject createInRealm:realm withObject:@[@(i).stringValue, @(i % 3)]];
+    }
+    [realm commitWriteTransaction];
+
+    RLMResults *results = [[PrimaryStringObject objectsWhere:@"intCol == 1 AND stringCol IN {'1', '4', '5'}"]
+                           sortedResultsUsingProperty:@"stringCol" ascending:NO];
+    results = [results objectsWhere:@"stringCol != '4'"];
+    XCTAssertEqual(1U, results.count);
+
+    NSString *explanation = results.explain;
+    XCTAssertTrue([explanation rangeOfString:@"of PrimaryStringObject (1 objects)"].location != NSNotFound);
+    XCTAssertTrue([explanation rangeOfString:@"find_all: "].location != NSNotFound);
+    XCTAssertTrue([explanation rangeOfString:@"sort by stringCol descending: "].location != NSNotFound);
+    XCTAssertTrue([explanation rangeOfString:@"all objects (10 objects)"].location != NSNotFound);
+
+    // the indexed condition is evaluated first, so the other condition only
+    // has to check the objects it matched
+    NSRange inRange = [explanation rangeOfString:@"stringCol IN {\"1\", \"4\", \"5\"} using index (scanned 10, matched 3)"];
+    NSRange intRange = [explanation rangeOfString:@"intCol == 1 (scanned 3, matched 2)"];
+    XCTAssertTrue(inRange.location != NSNotFound);
+    XCTAssertTrue(intRange.location != NSNotFound);
+    XCTAssertTrue(inRange.location < intRange.location);
+    XCTAssertTrue([explanation rangeOfString:@"stringCol != \"4\" (scanned 2, matched 1)"].location != NSNotFound);
+
+    RLMPreparedQuery *query = [realm prepareQuery:@"intCol > $0" forClass:PrimaryStringObject.class];
+    explanation = [query resultsWithArguments:@[@1]].explain;
+    XCTAssertTrue([explanation rangeOfString:@"intCol > 1 (scanned 10, matched 3)"].location != NSNotFound);
+
+    explanation = [PrimaryStringObject allObjects].explain;
+    XCTAssertTrue([explanation rangeOfString:@"all objects (10 objects)"].location != NSNotFound);
+}
+
+- (void)testLimitedResults
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 100; ++i) {
+        [EmployeeObject createInRealm:realm withObject:@{@"name": @(i).stringValue, @"age": @(i % 50), @"hired": @YES}];
+    }
+    [realm commitWriteTransaction];
+
+    RLMResults *unsorted = [EmployeeObject objectsWhere:@"age >= 10"];
+    RLMResults *limited = [unsorted resultsLimitedTo:5 offset:3];
+    XCTAssertEqual(5U, limited.count);
+    for (NSUInteger i = 0; i < 5; ++i) {
+        XCTAssertEqualObjects([unsorted[i + 3] name], [limited[i] name]);
+    }
+    XCTAssertEqual(2U, [limited indexOfObjectWhere:@"name == %@", [unsorted[5] name]]);
+    XCTAssertEqual((NSUInteger)NSNotFound, [limited indexOfObjectWhere:@"name == %@", [unsorted[8] name]]);
+
+    XCTAssertEqual(2U, [unsorted resultsLimitedTo:10 offset:78].count);
+    XCTAssertEqual(0U, [unsorted resultsLimitedTo:10 offset:100].count);
+    XCTAssertEqual(0U, [unsorted resultsLimitedTo:0 offset:0].count);
+
+    RLMResults *nested = [[unsorted resultsLimitedTo:10 offset:2] resultsLimitedTo:5 offset:6];
+    XCTAssertEqual(4U, nested.count);
+    XCTAssertEqualObjects([unsorted[8] name], [nested[0] name]);
+
+    RLMResults *sorted = [[EmployeeObject objectsWhere:@"age >= 10"] sortedResultsUsingProperty:@"age" ascending:NO];
+    RLMResults *top = [sorted resultsLimitedTo:4 offset:1];
+    void (^verify)() = ^{
+        XCTAssertEqual(4U, top.count);
+        for (NSUInteger i = 0; i < 4; ++i) {
+            XCTAssertEqualObjects([sorted[i + 1] name], [top[i] name]);
+        }
+    };
+    verify();
+
+    [realm beginWriteTransaction];
+    [EmployeeObject createInRealm:realm withObject:@{@"name": @"new", @"age": @49, @"hired": @YES}];
+    [[EmployeeObject objectsWhere:@"name == '49'"].firstObject setAge:5];
+    [realm commitWriteTransaction];
+    verify();
+
+    XCTAssertThrows([limited objectsWhere:@"age > 20"]);
+    XCTAssertThrows([limited sortedResultsUsingProperty:@"age" ascending:YES]);
+}
+
+- (void)testDistinctResultsAndGroupedCounts
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    NSArray *names = @[@"a", @"b", @"a", @"c", @"b", @"a"];
+    [realm beginWriteTransaction];
+    for (NSUInteger i = 0; i < names.count; ++i) {
+        [EmployeeObject createInRealm:realm withObject:@{@"name": names[i], @"age": @(i + 1), @"hired": @(i % 2 == 0)}];
+        [IndexedNameObject createInRealm:realm withObject:@{@"name": names[i], @"age": @(i + 1)}];
+    }
+    [realm commitWriteTransaction];
+
+    NSArray *(^namesOf)(RLMResults *) = ^(RLMResults *results) {
+        NSMutableArray *array = [NSMutableArray array];
+        for (id obj in results) {
+            [array addObject:[obj name]];
+        }
+        return array;
+    };
+
+    XCTAssertEqualObjects((@[@"a", @"b", @"c"]), namesOf([[EmployeeObject allObjects] distinctResultsUsingProperty:@"name"]));
+    XCTAssertEqualObjects((@[@"b", @"a", @"c"]), namesOf([[EmployeeObject objectsWhere:@"age > 1"] distinctResultsUsingProperty:@"name"]));
+    XCTAssertEqual(2U, [[EmployeeObject allObjects] distinctResultsUsingProperty:@"hired"].count);
+
+    RLMResults *sortedDistinct = [[[EmployeeObject allObjects] sortedResultsUsingProperty:@"age" ascending:NO] distinctResultsUsingProperty:@"name"];
+    XCTAssertEqualObjects((@[@"a", @"b", @"c"]), namesOf(sortedDistinct));
+    XCTAssertEqual(6, [sortedDistinct[0] age]);
+    XCTAssertEqual(5, [sortedDistinct[1] age]);
+    XCTAssertEqualObjects((@[@"b", @"c"]), namesOf([[[EmployeeObject allObjects] distinctResultsUsingProperty:@"name"] resultsLimitedTo:2 offset:1]));
+
+    RLMResults *indexedDistinct = [[IndexedNameObject allObjects] distinctResultsUsingProperty:@"name"];
+    XCTAssertEqualObjects((@[@"a", @"b", @"c"]), namesOf(indexedDistinct));
+    XCTAssertEqual(4, [indexedDistinct[2] age]);
+
+    NSDictionary *expected = @{@"a": @3, @"b": @2, @"c": @1};
+    XCTAssertEqualObjects(expected, [[EmployeeObject allObjects] groupedCountsByProperty:@"name"]);
+    XCTAssertEqualObjects(expected, [[IndexedNameObject allObjects] groupedCountsByProperty:@"name"]);
+    XCTAssertEqualObjects((@{@"a": @2, @"b": @1}), [[IndexedNameObject objectsWhere:@"age > 2"] groupedCountsByProperty:@"name"]);
+    XCTAssertEqualObjects((@{@YES: @3, @NO: @3}), [[EmployeeObject allObjects] groupedCountsByProperty:@"hired"]);
+
+    // distinct results update after changes
+    [realm beginWriteTransaction];
+    [IndexedNameObject createInRealm:realm withObject:@{@"name": @"d", @"age": @7}];
+    [realm deleteObjects:[IndexedNameObject objectsWhere:@"name == 'c'"]];
+    [realm commitWriteTransaction];
+    XCTAssertEqualObjects((@[@"a", @"b", @"d"]), namesOf(indexedDistinct));
+
+    XCTAssertThrows([[EmployeeObject allObjects] distinctResultsUsingProperty:@"invalid"]);
+    XCTAssertThrows([[[EmployeeObject allObjects] distinctResultsUsingProperty:@"name"] distinctResultsUsingProperty:@"age"]);
+    XCTAssertThrows([[[EmployeeObject allObjects] distinctResultsUsingProperty:@"name"] objectsWhere:@"age > 1"]);
+    XCTAssertThrows([[CompanyObject allObjects] groupedCountsByProperty:@"employees"]);
+}
+
+- (void)testSortedResultsUpdateAfterChanges
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 100; ++i) {
+        [EmployeeObject createInRealm:realm withObject:@{@"name": @(i).stringValue, @"age": @(i % 10), @"hired": @(i % 3 != 0)}];
+    }
+    [realm commitWriteTransaction];
+
+    RLMResults *results = [[EmployeeObject objectsWhere:@"hired == YES"] sortedResultsUsingProperty:@"age" ascending:NO];
+    void (^verify)() = ^{
+        // freshly created results are sorted from scratch, while the existing
+        // results reuse their previous order
+        RLMResults *expected = [[EmployeeObject objectsWhere:@"hired == YES"] sortedResultsUsingProperty:@"age" ascending:NO];
+        XCTAssertEqual(expected.count, results.count);
+        for (NSUInteger i = 0; i < results.count; ++i) {
+            XCTAssertEqualObjects([expected[i] name], [results[i] name]);
+            if (i > 0) {
+                XCTAssertGreaterThanOrEqual([results[i - 1] age], [results[i] age]);
+            }
+        }
+    };
+    verify();
+
+    [realm beginWriteTransaction];
+    [EmployeeObject createInRealm:realm withObject:@{@"name": @"new", @"age": @5, @"hired": @YES}];
+    [realm commitWriteTransaction];
+    verify();
+
+    [realm beginWriteTransaction];
+    [results[10] setAge:100];
+    [results[20] setAge:-1];
+    [realm commitWriteTransaction];
+    verify();
+
+    [realm beginWriteTransaction];
+    [realm deleteObject:results[0]];
+    [realm deleteObject:results[30]];
+    [[EmployeeObject objectsWhere:@"hired == NO"].firstObject setHired:YES];
+    [results.lastObject setHired:NO];
+    verify();
+    [realm commitWriteTransaction];
+    verify();
+
+    [realm beginWriteTransaction];
+    for (EmployeeObject *employee in [EmployeeObject allObjects]) {
+        employee.age = 100 - employee.age;
+    }
+    [realm commitWriteTransaction];
+    verify();
+}
+
+- (void)testSortingLargeResults
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 3000; ++i) {
+        [EmployeeObject createInRealm:realm withObject:@{@"name": @(i % 37).stringValue, @"age": @(i % 50 - 25), @"hired": @(i % 3 == 0)}];
+        [AggregateObject createInRealm:realm withObject:@[@(i), @((i % 11 - 5) * 0.5f), @((i % 13 - 6) * 1.5), @NO, NSDate.date]];
+    }
+    [realm commitWriteTransaction];
+
+    NSArray *descriptors = @[[RLMSortDescriptor sortDescriptorWithProperty:@"hired" ascending:YES],
+                             [RLMSortDescriptor sortDescriptorWithProperty:@"age" ascending:NO],
+                             [RLMSortDescriptor sortDescriptorWithProperty:@"name" ascending:YES]];
+    RLMResults *sorted = [[EmployeeObject allObjects] sortedResultsUsingDescriptors:descriptors];
+    XCTAssertEqual(3000U, sorted.count);
+    EmployeeObject *previous = nil;
+    for (EmployeeObject *employee in sorted) {
+        if (previous) {
+            NSComparisonResult order = [@(previous.hired) compare:@(employee.hired)];
+            if (order == NSOrderedSame) {
+                order = [@(employee.age) compare:@(previous.age)];
+            }
+            if (order == NSOrderedSame) {
+                order = [previous.name compare:employee.name];
+            }
+            XCTAssertNotEqual(NSOrderedDescending, order);
+        }
+        previous = employee;
+    }
+
+    // objects with equal values stay in the order they were added
+    RLMResults *byFloat = [[AggregateObject allObjects] sortedResultsUsingProperty:@"floatCol" ascending:NO];
+    RLMResults *byDouble = [[AggregateObject allObjects] sortedResultsUsingProperty:@"doubleCol" ascending:YES];
+    for (NSUInteger i = 1; i < byFloat.count; ++i) {
+        AggregateObject *a = byFloat[i - 1], *b = byFloat[i];
+        XCTAssertTrue(a.floatCol > b.floatCol || (a.floatCol == b.floatCol && a.intCol < b.intCol));
+        a = byDouble[i - 1], b = byDouble[i];
+        XCTAssertTrue(a.doubleCol < b.doubleCol || (a.doubleCol == b.doubleCol && a.intCol < b.intCol));
+    }
+    XCTAssertEqual(2.5f, [byFloat.firstObject floatCol]);
+    XCTAssertEqual(-9.0, [byDouble.firstObject doubleCol]);
+}
+
+- (void)testSortedResultsUsingOrderedIndex
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    // the same objects with and without ordered indexes must sort the same way
+    void (^create)(NSDictionary *) = ^(NSDictionary *value) {
+        [EmployeeObject createInRealm:realm withObject:value];
+        [OrderedIndexEmployeeObject createInRealm:realm withObject:value];
+    };
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 100; ++i) {
+        create(@{@"name": @(i * 7 % 100).stringValue, @"age": @(i % 10), @"hired": @(i % 3 != 0)});
+    }
+    [realm commitWriteTransaction];
+
+    void (^verify)(NSString *, NSArray *) = ^(NSString *predicate, NSArray *properties) {
+        RLMResults *expected = [[EmployeeObject objectsWhere:predicate] sortedResultsUsingDescriptors:properties];
+        RLMResults *actual = [[OrderedIndexEmployeeObject objectsWhere:predicate] sortedResultsUsingDescriptors:properties];
+        XCTAssertEqual(expected.count, actual.count);
+        for (NSUInteger i = 0; i < actual.count; ++i) {
+            XCTAssertEqualObjects([expected[i] name], [actual[i] name]);
+        }
+
+        RLMResults *expectedTop = [expected resultsLimitedTo:5 offset:2];
+        RLMResults *actualTop = [actual resultsLimitedTo:5 offset:2];
+        XCTAssertEqual(expectedTop.count, actualTop.count);
+        for (NSUInteger i = 0; i < actualTop.count; ++i) {
+            XCTAssertEqualObjects([expectedTop[i] name], [actualTop[i] name]);
+        }
+    };
+    void (^verifyAll)() = ^{
+        RLMSortDescriptor *ageAscending = [RLMSortDescriptor sortDescriptorWithProperty:@"age" ascending:YES];
+        RLMSortDescriptor *ageDescending = [RLMSortDescriptor sortDescriptorWithProperty:@"age" ascending:NO];
+        RLMSortDescriptor *name = [RLMSortDescriptor sortDescriptorWithProperty:@"name" ascending:YES];
+        RLMSortDescriptor *hired = [RLMSortDescriptor sortDescriptorWithProperty:@"hired" ascending:NO];
+        verify(@"TRUEPREDICATE", @[ageAscending]);
+        verify(@"TRUEPREDICATE", @[ageDescending, name]);
+        verify(@"hired == YES", @[ageAscending, hired]);
+        verify(@"hired == YES", @[name]);
+    };
+    verifyAll();
+
+    [realm beginWriteTransaction];
+    for (RLMResults *results in @[[EmployeeObject allObjects], [OrderedIndexEmployeeObject allObjects]]) {
+        [results[10] setAge:100];
+        [results[20] setName:@"zzz"];
+        [realm deleteObject:results[30]];
+    }
+    create(@{@"name": @"new", @"age": @5, @"hired": @YES});
+    [realm commitWriteTransaction];
+    verifyAll();
+
+    // deleting objects in bulk removes them from the ordered index too
+    [realm beginWriteTransaction];
+    [realm deleteObjects:[EmployeeObject objectsWhere:@"age == 3"]];
+    [realm deleteObjects:[OrderedIndexEmployeeObject objectsWhere:@"age == 3"]];
+    create(@{@"name": @"newer", @"age": @3, @"hired": @NO});
+    [realm commitWriteTransaction];
+    verifyAll();
+
+    // range comparisons are answered by the ordered index
+    XCTAssertEqual([EmployeeObject objectsWhere:@"age > 3 AND age <= 7"].count,
+                   [OrderedIndexEmployeeObject objectsWhere:@"age > 3 AND age <= 7"].count);
+    XCTAssertEqual([EmployeeObject objectsWhere:@"age >= 9"].count,
+                   [OrderedIndexEmployeeObject objectsWhere:@"age >= 9"].count);
+    XCTAssertEqual([EmployeeObject objectsWhere:@"age BETWEEN {2, 4}"].count,
+                   [OrderedIndexEmployeeObject objectsWhere:@"age BETWEEN {2, 4}"].count);
+    NSString *explanation = [OrderedIndexEmployeeObject objectsWhere:@"age > 3 AND age <= 7"].explain;
+    XCTAssertTrue([explanation rangeOfString:@"using ordered index"].location != NSNotFound);
+}
+
+- (void)testNotificationBlockReportsChangedIndices
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    EmployeeObject *a = [EmployeeObject createInRealm:realm withObject:@{@"name": @"A", @"age": @40, @"hired": @YES}];
+    EmployeeObject *b = [EmployeeObject createInRealm:realm withObject:@{@"name": @"B", @"age": @50, @"hired": @YES}];
+    EmployeeObject *c = [EmployeeObject createInRealm:realm withObject:@{@"name": @"C", @"age": @60, @"hired": @YES}];
+    [realm commitWriteTransaction];
+
+    RLMResults *results = [[EmployeeObject objectsWhere:@"age > 30"] sortedResultsUsingProperty:@"age" ascending:YES];
+    __block RLMCollectionChange *change;
+    __block NSUInteger calls = 0;
+    RLMNotificationToken *token = [results addNotificationBlock:^(id<RLMCollection> collection, RLMCollectionChange *changes) {
+        XCTAssertEqual(results, collection);
+        change = changes;
+        ++calls;
+    }];
+
+    [realm beginWriteTransaction];
+    b.name = @"B2";
+    [realm commitWriteTransaction];
+    XCTAssertEqual(1U, calls);
+    XCTAssertEqualObjects([NSIndexSet indexSet], change.deletions);
+    XCTAssertEqualObjects([NSIndexSet indexSet], change.insertions);
+    XCTAssertEqualObjects([NSIndexSet indexSetWithIndex:1], change.modifications);
+
+    [realm beginWriteTransaction];
+    [EmployeeObject createInRealm:realm withObject:@{@"name": @"D", @"age": @45, @"hired": @YES}];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(2U, calls);
+    XCTAssertEqualObjects([NSIndexSet indexSet], change.deletions);
+    XCTAssertEqualObjects([NSIndexSet indexSetWithIndex:1], change.insertions);
+    XCTAssertEqualObjects([NSIndexSet indexSet], change.modifications);
+
+    // deleting A moves D into its row, which must not be reported as a change to D
+    [realm beginWriteTransaction];
+    [realm deleteObject:a];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(3U, calls);
+    XCTAssertEqualObjects([NSIndexSet indexSetWithIndex:0], change.deletions);
+    XCTAssertEqualObjects([NSIndexSet indexSet], change.insertions);
+    XCTAssertEqualObjects([NSIndexSet indexSet], change.modifications);
+
+    // moving an object within the sort order deletes and reinserts it
+    [realm beginWriteTransaction];
+    c.age = 35;
+    [realm commitWriteTransaction];
+    XCTAssertEqual(4U, calls);
+    XCTAssertEqualObjects([NSIndexSet indexSetWithIndex:2], change.deletions);
+    XCTAssertEqualObjects([NSIndexSet indexSetWithIndex:0], change.insertions);
+    XCTAssertEqualObjects([NSIndexSet indexSet], change.modifications);
+
+    // changes which don't affect the results don't call the block
+    [realm beginWriteTransaction];
+    [EmployeeObject createInRealm:realm withObject:@{@"name": @"E", @"age": @10, @"hired": @YES}];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(4U, calls);
+
+    [realm removeNotification:token];
+}
+
+- (void)testArrayNotificationBlockReportsChangedIndices
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    CompanyObject *company = [CompanyObject createInRealm:realm withObject:@[@"company", @[@[@"A", @40, @YES], @[@"B", @50, @YES]]]];
+    [realm commitWriteTransaction];
+
+    __block RLMCollectionChange *change;
+    RLMNotificationToken *token = [company.employees addNotificationBlock:^(__unused id<RLMCollection> collection, RLMCollectionChange *changes) {
+        change = changes;
+    }];
+
+    [realm beginWriteTransaction];
+    [company.employees addObject:company.employees[0]];
+    [company.employees removeObjectAtIndex:0];
+    [realm commitWriteTransaction];
+    XCTAssertEqualObjects([NSIndexSet indexSetWithIndex:1], change.deletions);
+    XCTAssertEqualObjects([NSIndexSet indexSetWithIndex:0], change.insertions);
+    XCTAssertEqualObjects([NSIndexSet indexSet], change.modifications);
+
+    // changing an object in the list without changing the list itself
+    change = nil;
+    [realm beginWriteTransaction];
+    [company.employees[1] setAge:41];
+    [realm commitWriteTransaction];
+    XCTAssertEqualObjects([NSIndexSet indexSet], change.deletions);
+    XCTAssertEqualObjects([NSIndexSet indexSet], change.insertions);
+    XCTAssertEqualObjects([NSIndexSet indexSetWithIndex:1], change.modifications);
+
+    // changes to other tables don't call the block
+    change = nil;
+    [realm beginWriteTransaction];
+    [StringObject createInRealm:realm withObject:@[@"unrelated"]];
+    [realm commitWriteTransaction];
+    XCTAssertNil(change);
+
+    [realm removeNotification:token];
+
+    CompanyObject *standalone = [[CompanyObject alloc] init];
+    XCTAssertThrows([standalone.employees addNotificationBlock:^(__unused id<RLMCollection> collection, __unused RLMCollectionChange *changes) {}]);
+}
+
+- (void)testEvaluateAsync
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 100; ++i) {
+        [EmployeeObject createInRealm:realm withObject:@{@"name": @(i).stringValue, @"age": @(i % 50), @"hired": @(i % 3 != 0)}];
+    }
+    [realm commitWriteTransaction];
+
+    RLMResults *results = [[EmployeeObject objectsWhere:@"hired == YES AND age > 20"] sortedResultsUsingProperty:@"age" ascending:NO];
+    XCTestExpectation *evaluated = [self expectationWithDescription:@"results evaluated"];
+    [results evaluateAsync:^(RLMResults *r) {
+        XCTAssertEqual(results, r);
+        RLMResults *expected = [[EmployeeObject objectsWhere:@"hired == YES AND age > 20"] sortedResultsUsingProperty:@"age" ascending:NO];
+        XCTAssertEqual(expected.count, r.count);
+        for (NSUInteger i = 0; i < r.count; ++i) {
+            XCTAssertEqualObjects([expected[i] name], [r[i] name]);
+        }
+        [evaluated fulfill];
+    }];
+
+    // changing the data while the query runs in the background must not
+    // result in rows from the old version being used
+    [realm beginWriteTransaction];
+    [realm deleteObjects:[EmployeeObject objectsWhere:@"age > 40"]];
+    [EmployeeObject createInRealm:realm withObject:@{@"name": @"new", @"age": @30, @"hired": @YES}];
+    [realm commitWriteTransaction];
+
+    [self waitForExpectationsWithTimeout:2.0 handler:nil];
+}
+
+- (void)testEvaluateAsyncAllObjects
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 100; ++i) {
+        [EmployeeObject createInRealm:realm withObject:@{@"name": @(i).stringValue, @"age": @(i % 50), @"hired": @(i % 3 != 0)}];
+    }
+    [realm commitWriteTransaction];
+
+    // sorting, limiting or taking distinct values of all of the objects gives
+    // results whose query can be built in a background realm
+    RLMResults *sorted = [[EmployeeObject allObjects] sortedResultsUsingProperty:@"age" ascending:NO];
+    RLMResults *limited = [[EmployeeObject allObjects] resultsLimitedTo:10 offset:5];
+    RLMResults *distinct = [[EmployeeObject allObjects] distinctResultsUsingProperty:@"age"];
+    XCTestExpectation *sortedEvaluated = [self expectationWithDescription:@"sorted results evaluated"];
+    XCTestExpectation *limitedEvaluated = [self expectationWithDescription:@"limited results evaluated"];
+    XCTestExpectation *distinctEvaluated = [self expectationWithDescription:@"distinct results evaluated"];
+    [sorted evaluateAsync:^(RLMResults *r) {
+        XCTAssertEqual(100U, r.count);
+        XCTAssertEqual(49, [r.firstObject age]);
+        XCTAssertEqual(0, [r.lastObject age]);
+        [sortedEvaluated fulfill];
+    }];
+    [limited evaluateAsync:^(RLMResults *r) {
+        XCTAssertEqual(10U, r.count);
+        XCTAssertEqualObjects(@"5", [r.firstObject name]);
+        [limitedEvaluated fulfill];
+    }];
+    [distinct evaluateAsync:^(RLMResults *r) {
+        XCTAssertEqual(50U, r.count);
+        [distinctEvaluated fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:2.0 handler:nil];
+}
+
+- (void)testEvaluateAsyncWithObjectInPredicate
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    DogObject *fido = [DogObject createInRealm:realm withObject:@[@"Fido", @3]];
+    DogObject *rex = [DogObject createInRealm:realm withObject:@[@"Rex", @5]];
+    [OwnerObject createInRealm:realm withObject:@[@"Tim", fido]];
+    [OwnerObject createInRealm:realm withObject:@[@"Sam", rex]];
+    [realm commitWriteTransaction];
+
+    // the object's row is only read on this thread, so the results are
+    // evaluated here rather than in the background
+    RLMResults *results = [OwnerObject objectsWhere:@"dog == %@", fido];
+    RLMResults *prepared = [[[OwnerObject allObjects] prepareQuery:@"dog == $0"] resultsWithArguments:@[rex]];
+    XCTestExpectation *evaluated = [self expectationWithDescription:@"results evaluated"];
+    XCTestExpectation *preparedEvaluated = [self expectationWithDescription:@"prepared results evaluated"];
+    [results evaluateAsync:^(RLMResults *r) {
+        XCTAssertEqual(1U, r.count);
+        XCTAssertEqualObjects(@"Tim", [r.firstObject name]);
+        [evaluated fulfill];
+    }];
+    [prepared evaluateAsync:^(RLMResults *r) {
+        XCTAssertEqual(1U, r.count);
+        XCTAssertEqualObjects(@"Sam", [r.firstObject name]);
+        [preparedEvaluated fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:2.0 handler:nil];
+}
+
+- (void)testPreparedOrderedIndexQueryEvaluatedElsewhere
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 100000; ++i) {
+        [OrderedIndexEmployeeObject createInRealm:realm withObject:@{@"name": @(i).stringValue, @"age": @(i % 100), @"hired": @(i % 2 == 0)}];
+    }
+    [realm commitWriteTransaction];
+
+    // the ordered index is read from the realm building the query rather than
+    // from the one which prepared it
+    RLMPreparedQuery *query = [[OrderedIndexEmployeeObject allObjects] prepareQuery:@"age >= $0 AND age < $1"];
+    RLMResults *async = [[query resultsWithArguments:@[@10, @20]] sortedResultsUsingProperty:@"name" ascending:YES];
+    RLMResults *parallel = [query resultsWithArguments:@[@30, @35]].resultsEvaluatedInParallel;
+    XCTAssertTrue([[query resultsWithArguments:@[@10, @20]].explain rangeOfString:@"using ordered index"].location != NSNotFound);
+
+    XCTestExpectation *evaluated = [self expectationWithDescription:@"results evaluated"];
+    [async evaluateAsync:^(RLMResults *r) {
+        XCTAssertEqual(10000U, r.count);
+        XCTAssertEqualObjects(@"10", [r.firstObject name]);
+        [evaluated fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    XCTAssertEqual(5000U, parallel.count);
+    XCTAssertEqual(30, [[parallel minOfProperty:@"age"] intValue]);
+    XCTAssertEqual(34, [[parallel maxOfProperty:@"age"] intValue]);
+}
+
+- (void)testResultsEvaluatedInParallel
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 150000; ++i) {
+        [AggregateObject createInRealm:realm withObject:@[@(i % 1000), @(i % 7 * 0.5f), @(i * 0.25), @(i % 2 == 0), NSDate.date]];
+    }
+    [realm commitWriteTransaction];
+
+    RLMResults *serial = [AggregateObject objectsWhere:@"intCol > 900 AND boolCol == YES"];
+    RLMResults *parallel = [[AggregateObject objectsWhere:@"intCol > 900"].resultsEvaluatedInParallel objectsWhere:@"boolCol == YES"];
+    XCTAssertEqual(serial.count, parallel.count);
+    XCTAssertEqualObjects([serial minOfProperty:@"intCol"], [parallel minOfProperty:@"intCol"]);
+    XCTAssertEqualObjects([serial maxOfProperty:@"floatCol"], [parallel maxOfProperty:@"floatCol"]);
+    XCTAssertEqualObjects([serial sumOfProperty:@"doubleCol"], [parallel sumOfProperty:@"doubleCol"]);
+    XCTAssertEqualObjects([serial averageOfProperty:@"intCol"], [parallel averageOfProperty:@"intCol"]);
+    XCTAssertNil([[parallel objectsWhere:@"intCol < 0"] minOfProperty:@"intCol"]);
+
+    // the objects are found in the same order as by a single thread
+    XCTAssertEqual(serial.count, parallel.count);
+    for (NSUInteger i = 0; i < serial.count; i += 97) {
+        XCTAssertEqual([serial[i] doubleCol], [parallel[i] doubleCol]);
+    }
+    RLMResults *sorted = [parallel sortedResultsUsingProperty:@"doubleCol" ascending:NO];
+    XCTAssertEqual([serial.lastObject doubleCol], [sorted.firstObject doubleCol]);
+    XCTAssertEqual(10U, [sorted resultsLimitedTo:10 offset:0].count);
+
+    // sorted results of all of the objects are found in parallel too
+    RLMResults *allSorted = [[AggregateObject allObjects].resultsEvaluatedInParallel sortedResultsUsingProperty:@"intCol" ascending:NO];
+    RLMResults *allSortedSerial = [[AggregateObject allObjects] sortedResultsUsingProperty:@"intCol" ascending:NO];
+    XCTAssertEqual(allSortedSerial.count, allSorted.count);
+    for (NSUInteger i = 0; i < allSorted.count; i += 101) {
+        XCTAssertEqual([allSortedSerial[i] doubleCol], [allSorted[i] doubleCol]);
+    }
+    XCTAssertEqual(allSortedSerial.count, [[[AggregateObject allObjects] sortedResultsUsingProperty:@"intCol" ascending:YES].resultsEvaluatedInParallel count]);
+
+    // the results stay up to date after the realm changes
+    [realm beginWriteTransaction];
+    [realm deleteObjects:[AggregateObject objectsWhere:@"intCol == 999"]];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(serial.count, parallel.count);
+    XCTAssertEqual(0U, [parallel objectsWhere:@"intCol == 999"].count);
+
+    // small tables and queries during write transactions are run serially
+    RLMResults *small = [IntObject allObjects].resultsEvaluatedInParallel;
+    [realm beginWriteTransaction];
+    [IntObject createInRealm:realm withObject:@[@1]];
+    XCTAssertEqual(1U, small.count);
+    XCTAssertEqual(serial.count, parallel.count);
+    [realm commitWriteTransaction];
+}
+
+- (void)testResultsEvaluatedLazily
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 2500; ++i) {
+        [IntObject createInRealm:realm withObject:@[@(i)]];
+    }
+    [realm commitWriteTransaction];
+
+    RLMResults *serial = [IntObject objectsWhere:@"intCol >= 100"];
+    RLMResults *lazy = [IntObject allObjects].resultsEvaluatedLazily;
+    lazy = [lazy objectsWhere:@"intCol >= 100"];
+    XCTAssertEqual(2400U, lazy.count);
+    XCTAssertEqual(100, [lazy.firstObject intCol]);
+    XCTAssertEqual(2499, [lazy.lastObject intCol]);
+
+    // objects can be read in any order across the chunks they're found in
+    XCTAssertEqual(1600, [lazy[1500] intCol]);
+    XCTAssertEqual(101, [lazy[1] intCol]);
+    XCTAssertEqual(2399, [lazy[2299] intCol]);
+    XCTAssertThrows(lazy[2400]);
+
+    NSUInteger count = 0;
+    for (IntObject *io in lazy) {
+        XCTAssertEqual([serial[count] intCol], io.intCol);
+        ++count;
+    }
+    XCTAssertEqual(serial.count, count);
+    XCTAssertEqual(1900U, [lazy indexOfObject:serial[1900]]);
+    XCTAssertEqual(NSNotFound, [lazy indexOfObject:[IntObject allObjects][5]]);
+
+    // the objects are found again after the data changes
+    [realm beginWriteTransaction];
+    [realm deleteObjects:[IntObject objectsWhere:@"intCol < 1000"]];
+    XCTAssertEqual(1500U, lazy.count);
+    XCTAssertEqual([serial[1200] intCol], [lazy[1200] intCol]);
+    [realm commitWriteTransaction];
+
+    void (^mutateDuringEnumeration)() = ^{
+        bool first = true;
+        for (__unused IntObject *io in lazy) {
+            if (first) {
+                [realm beginWriteTransaction];
+                [IntObject createInRealm:realm withObject:@[@5000]];
+                [realm commitWriteTransaction];
+                first = false;
+            }
+        }
+    };
+    XCTAssertThrows(mutateDuringEnumeration());
+
+    [realm beginWriteTransaction];
+    [lazy deleteObjectsFromRealm];
+    XCTAssertEqual(0U, lazy.count);
+    XCTAssertNil(lazy.firstObject);
+    [IntObject createInRealm:realm withObject:@[@5000]];
+    [realm commitWriteTransaction];
+
+    // sorted results find all of their objects
+    RLMResults *sorted = [[IntObject allObjects].resultsEvaluatedLazily sortedResultsUsingProperty:@"intCol" ascending:NO];
+    XCTAssertEqual(5000, [sorted.firstObject intCol]);
+}
+
+- (void)testCountKeptUpToDate
+{
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [realm beginWriteTransaction];
+    for (int i = 0; i < 30; ++i) {
+        [IndexedNameObject createInRealm:realm withObject:@[@(i % 3).stringValue, @(i)]];
+    }
+    [realm commitWriteTransaction];
+
+    // counted using the search index
+    RLMResults *indexed = [IndexedNameObject objectsWhere:@"name == '1'"];
+    RLMResults *sorted = [[IndexedNameObject objectsWhere:@"age >= 10"] sortedResultsUsingProperty:@"age" ascending:NO];
+    XCTAssertEqual(10U, indexed.count);
+    XCTAssertEqual(0U, [IndexedNameObject objectsWhere:@"name == '3'"].count);
+    XCTAssertEqual(10U, [IndexedNameObject objectsWhere:@"'2' == name"].count);
+    XCTAssertEqual(20U, sorted.count);
+    XCTAssertEqual(29, [sorted.firstObject age]);
+
+    // changes to other tables don't change the counts
+    [realm beginWriteTransaction];
+    [IntObject createInRealm:realm withObject:@[@1]];
+    [realm commitWriteTransaction];
+    XCTAssertEqual(10U, indexed.count);
+    XCTAssertEqual(20U, sorted.count);
+
+    // changes to the table do, including for results whose view is out of date
+    [realm beginWriteTransaction];
+    [IndexedNameObject createInRealm:realm withObject:@[@"1", @40]];
+    [realm deleteObjects:[IndexedNameObject objectsWhere:@"age < 12"]];
+    XCTAssertEqual(7U, indexed.count);
+    XCTAssertEqual(19U, sorted.count);
+    XCTAssertEqual(40, [sorted.firstObject age]);
+    [realm commitWriteTransaction];
+    XCTAssertEqual(7U, indexed.count);
+    XCTAssertEqual(19U, sorted.count);
+}
+
 static vm_size_t get_resident_size() {
     struct task_basic_info info;
     mach_msg_type_number_t size = sizeof(info);
@@ -129,6 +129,32 @@ public class Object: RLMObjectBase, Equatable, Printable {
     */
     public class func indexedProperties() -> [String] { return [] }
 
+    /**
+    Return an array of property names for properties which should have a full-text index. Only
+    supported for string properties. Full-text indexed properties can be searched for words, word
+    prefixes and phrases with the `MATCHES` operator.
+    :returns: `Array` of property names to index.
+    */
+    public class func fullTextIndexedProperties() -> [String] { return [] }
+
+    /**
+    Return an array of property names for properties which should have an ordered index.
+    Supported for string, integer, float, double, bool and date properties. Results sorted by
+    an ordered indexed property are read in the order of the index, and range comparisons on
+    it look up the matching objects in the index.
+    :returns: `Array` of property names to index.
+    */
+    public class func orderedIndexedProperties() -> [String] { return [] }
+
+    /**
+    Return an array of compound indexes, each an array of two or more property names. Only
+    supported for string, integer, bool and date properties. A compound index is used for
+    queries which compare all but the last of its properties for equality, optionally along
+    with an equality or range comparison on the last property.
+    :returns: `Array` of compound indexes.
+    */
+    public class func compoundIndexes() -> [[String]] { return [] }
+
 
     // MARK: Inverse Relationships
 
@@ -273,6 +299,24 @@ public class ObjectUtil: NSObject {
         }
         return nil
     }
+    @objc private class func fullTextIndexedPropertiesForClass(type: AnyClass) -> NSArray? {
+        if let type = type as? Object.Type {
+            return type.fullTextIndexedProperties() as NSArray?
+        }
+        return nil
+    }
+    @objc private class func orderedIndexedPropertiesForClass(type: AnyClass) -> NSArray? {
+        if let type = type as? Object.Type {
+            return type.orderedIndexedProperties() as NSArray?
+        }
+        return nil
+    }
+    @objc private class func compoundIndexesForClass(type: AnyClass) -> NSArray? {
+        if let type = type as? Object.Type {
+            return type.compoundIndexes() as NSArray?
+        }
+        return nil
+    }
 
     // Get the names of all properties in the object which are of type List<>
     @objc private class func getGenericListPropertyNames(obj: AnyObject) -> NSArray {